@@ -7,6 +7,8 @@
 
 #include "esp_err.h"
 #include "ir_engine.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,13 +17,97 @@ extern "C" {
 // Enum defined in ir_types.h included via ir_engine.h
 
 /**
- * @brief Initialize AC logic (load state from NVS if needed)
+ * @brief Flash wear counters for the persisted AC state
  */
-void app_ac_init(void);
+typedef struct {
+  uint32_t changes;   // State/brand changes accepted
+  uint32_t writes;    // Settings commits issued for the AC state
+  uint32_t coalesced; // Changes folded into an already pending write
+  uint32_t errors;    // Failed commits
+  bool pending;       // A write is scheduled
+} app_ac_persist_stats_t;
+
+/**
+ * @brief Field selectors for app_ac_update_state()
+ */
+#define APP_AC_FIELD_POWER (1u << 0)
+#define APP_AC_FIELD_TEMP (1u << 1)
+#define APP_AC_FIELD_MODE (1u << 2)
+#define APP_AC_FIELD_FAN (1u << 3)
+#define APP_AC_FIELD_SWING_V (1u << 4)
+#define APP_AC_FIELD_SWING_H (1u << 5)
+#define APP_AC_FIELD_BRAND (1u << 6)
+#define APP_AC_FIELD_STATE                                                     \
+  (APP_AC_FIELD_POWER | APP_AC_FIELD_TEMP | APP_AC_FIELD_MODE |                \
+   APP_AC_FIELD_FAN | APP_AC_FIELD_SWING_V | APP_AC_FIELD_SWING_H)
+
+/**
+ * @brief Origin of an AC send request
+ */
+typedef enum {
+  APP_AC_SRC_WEB = 0, // Local web UI / REST API
+  APP_AC_SRC_CLOUD,   // RainMaker
+  APP_AC_SRC_LOCAL,   // On-device logic (button, schedules)
+  APP_AC_SRC_COUNT
+} app_ac_source_t;
+
+/**
+ * @brief Per-source scheduler counters
+ */
+typedef struct {
+  uint32_t received;    // Send requests accepted
+  uint32_t transmitted; // IR transmissions this source contributed to
+  uint32_t skipped;     // Flushes dropped as identical to the last sent state
+} app_ac_source_stats_t;
+
+/**
+ * @brief Send scheduler counters
+ */
+typedef struct {
+  app_ac_source_stats_t sources[APP_AC_SRC_COUNT];
+  uint32_t transmissions; // IR frames actually sent
+  uint32_t skipped;       // Coalesced flushes matching the last sent state
+  uint32_t tx_errors;     // Failed transmissions
+} app_ac_sched_stats_t;
+
+/**
+ * @brief Callback invoked after the AC state or brand changed.
+ *
+ * Runs in the context of the caller that made the change; must not block.
+ */
+typedef void (*app_ac_change_cb_t)(void);
+
+/**
+ * @brief Initialize AC logic and restore the last persisted state.
+ *
+ * Must be called after app_settings_init().
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t app_ac_init(void);
+
+/**
+ * @brief Atomically apply selected fields to the AC state.
+ *
+ * Only the fields selected by @p fields are taken from @p delta / @p brand;
+ * all others keep their current value, so concurrent updates of different
+ * fields (e.g. web sets temp while cloud sets mode) never overwrite each
+ * other. Readers are never blocked.
+ *
+ * @param delta Source of the state fields (may be NULL if only the brand is
+ *              selected)
+ * @param brand New brand, used if APP_AC_FIELD_BRAND is set
+ * @param fields Bitmask of APP_AC_FIELD_*
+ * @return true if the state changed
+ */
+bool app_ac_update_state(const ir_ac_state_t *delta, ac_brand_t brand,
+                         uint32_t fields);
 
 /**
  * @brief Set the full AC state.
  *
+ * Overwrites every field; prefer app_ac_update_state() for partial changes.
+ *
  * @param state Pointer to new state
  */
 void app_ac_set_state(const ir_ac_state_t *state);
@@ -47,13 +133,79 @@ void app_ac_set_brand(ac_brand_t brand);
  */
 ac_brand_t app_ac_get_brand(void);
 
+/**
+ * @brief Register a change listener (single slot, NULL to clear).
+ *
+ * @param cb Callback
+ */
+void app_ac_set_change_cb(app_ac_change_cb_t cb);
+
+/**
+ * @brief Write a pending state change to flash immediately.
+ *
+ * Changes are otherwise persisted CONFIG_APP_AC_PERSIST_DELAY_MS after the
+ * last modification, and on esp_restart().
+ */
+void app_ac_flush(void);
+
+/**
+ * @brief Get flash wear counters.
+ *
+ * @param stats Pointer to store counters
+ */
+void app_ac_get_persist_stats(app_ac_persist_stats_t *stats);
+
 /**
  * @brief Send the IR command based on current state and brand.
  *
+ * Transmits synchronously, bypassing the scheduler. Interactive callers
+ * should use app_ac_request_send() instead.
+ *
  * @return esp_err_t ESP_OK on success
  */
 esp_err_t app_ac_send(void);
 
+/**
+ * @brief Request transmission of the current state.
+ *
+ * Requests arriving within CONFIG_APP_AC_COALESCE_MS of each other are merged
+ * and only the final state is transmitted. A flush whose state and brand
+ * match the last successful transmission is skipped. Returns immediately.
+ *
+ * @param source Origin of the request (for metrics)
+ * @return esp_err_t ESP_OK if queued
+ */
+esp_err_t app_ac_request_send(app_ac_source_t source);
+
+/**
+ * @brief Request transmission and block until it has been handled.
+ *
+ * Same as app_ac_request_send(), but returns once the coalesced flush that
+ * includes this request has transmitted (or was skipped as a duplicate).
+ * The request stays queued when the wait times out.
+ *
+ * @param source Origin of the request (for metrics)
+ * @param timeout_ms Maximum time to wait
+ * @return esp_err_t ESP_OK once sent, the transmit error, or ESP_ERR_TIMEOUT
+ */
+esp_err_t app_ac_request_send_wait(app_ac_source_t source,
+                                   uint32_t timeout_ms);
+
+/**
+ * @brief Get send scheduler counters.
+ *
+ * @param stats Pointer to store counters
+ */
+void app_ac_get_sched_stats(app_ac_sched_stats_t *stats);
+
+/**
+ * @brief Short name of a request source ("web", "cloud", "local").
+ *
+ * @param source Source
+ * @return const char* Static string
+ */
+const char *app_ac_source_to_str(app_ac_source_t source);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,46 +1,523 @@
 #include "goku_ac.h"
 #include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "goku_settings.h"
+#include "sdkconfig.h"
+#include <stdatomic.h>
 #include <string.h>
 
 static const char *TAG = "goku_ac";
 
-static ir_ac_state_t g_ac_state = {.power = false,
-                                   .mode = 1, // Cool
-                                   .temp = 24,
-                                   .fan = 0,     // Auto
-                                   .swing_v = 0, // Off
-                                   .swing_h = 0};
+#define AC_PERSIST_DELAY_US ((uint64_t)CONFIG_APP_AC_PERSIST_DELAY_MS * 1000)
+// Continuous changes may postpone the write by at most this long
+#define AC_PERSIST_MAX_DELAY_US (AC_PERSIST_DELAY_US * 4)
 
-static ac_brand_t g_ac_brand = AC_BRAND_DAIKIN;
+#define AC_COALESCE_MS CONFIG_APP_AC_COALESCE_MS
+// A steady stream of requests still transmits at least this often
+#define AC_COALESCE_MAX_MS (AC_COALESCE_MS * 4)
 
-void app_ac_init(void) {
-  ESP_LOGI(TAG, "AC Logic Initialized");
-  // TODO: Load from NVS?
+#define AC_MAX_WAITERS 4 // Concurrent app_ac_request_send_wait() callers
+
+typedef struct {
+  ir_ac_state_t state;
+  ac_brand_t brand;
+} ac_snapshot_t;
+
+/*
+ * State + brand are published through a seqlock: writers serialize on
+ * s_ac_lock and bump s_ac_seq to odd while the snapshot is being modified;
+ * readers copy without locking and retry if the sequence moved. Writers
+ * run inside a critical section, so a reader on the same core never
+ * observes an odd sequence and the retry loop only spins while the other
+ * core is mid-write (a few dozen cycles).
+ */
+static ac_snapshot_t g_ac = {.state = {.power = false,
+                                       .mode = 1, // Cool
+                                       .temp = 24,
+                                       .fan = 0,     // Auto
+                                       .swing_v = 0, // Off
+                                       .swing_h = 0},
+                             .brand = AC_BRAND_DAIKIN};
+static _Atomic uint32_t s_ac_seq = 0;
+
+// Serializes snapshot writers and guards the persist/scheduler bookkeeping
+static portMUX_TYPE s_ac_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static esp_timer_handle_t s_persist_timer = NULL;
+static app_ac_persist_stats_t s_persist_stats;
+static int64_t s_pending_since = 0;
+
+// Send scheduler
+static TaskHandle_t s_sched_task = NULL;
+static app_ac_sched_stats_t s_sched_stats;
+static uint32_t s_pending_sources = 0; // Bitmask of app_ac_source_t
+static ir_ac_state_t s_last_sent_state;
+static ac_brand_t s_last_sent_brand;
+static bool s_last_sent_valid = false;
+static uint32_t s_req_seq = 0; // Bumped by every request
+
+// Tasks blocked until the flush covering their request has finished
+typedef struct {
+  TaskHandle_t task; // NULL = free slot
+  uint32_t ticket;   // s_req_seq of the request
+  bool done;
+  esp_err_t err;
+} ac_waiter_t;
+static ac_waiter_t s_waiters[AC_MAX_WAITERS];
+
+static app_ac_change_cb_t s_change_cb = NULL;
+
+static void app_ac_read(ac_snapshot_t *out) {
+  while (1) {
+    uint32_t begin = atomic_load_explicit(&s_ac_seq, memory_order_acquire);
+    if (begin & 1)
+      continue; // Writer active on the other core
+    memcpy(out, (const void *)&g_ac, sizeof(*out));
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&s_ac_seq, memory_order_relaxed) == begin)
+      return;
+  }
 }
 
-void app_ac_set_state(const ir_ac_state_t *state) {
-  if (state) {
-    memcpy(&g_ac_state, state, sizeof(ir_ac_state_t));
+// Caller holds s_ac_lock
+static void app_ac_publish(const ac_snapshot_t *next) {
+  atomic_fetch_add_explicit(&s_ac_seq, 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  memcpy(&g_ac, next, sizeof(g_ac));
+  atomic_fetch_add_explicit(&s_ac_seq, 1, memory_order_release);
+}
+
+static void app_ac_apply_fields(ac_snapshot_t *snap, const ir_ac_state_t *delta,
+                                ac_brand_t brand, uint32_t fields) {
+  if (delta) {
+    if (fields & APP_AC_FIELD_POWER)
+      snap->state.power = delta->power;
+    if (fields & APP_AC_FIELD_TEMP)
+      snap->state.temp = delta->temp;
+    if (fields & APP_AC_FIELD_MODE)
+      snap->state.mode = delta->mode;
+    if (fields & APP_AC_FIELD_FAN)
+      snap->state.fan = delta->fan;
+    if (fields & APP_AC_FIELD_SWING_V)
+      snap->state.swing_v = delta->swing_v;
+    if (fields & APP_AC_FIELD_SWING_H)
+      snap->state.swing_h = delta->swing_h;
+  }
+  if ((fields & APP_AC_FIELD_BRAND) && brand < AC_BRAND_MAX)
+    snap->brand = brand;
+}
+
+static void app_ac_persist_now(void) {
+  app_settings_ac_t ac;
+  ac_snapshot_t snap;
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  if (!s_persist_stats.pending) {
+    taskEXIT_CRITICAL(&s_ac_lock);
+    return;
+  }
+  s_persist_stats.pending = false;
+  taskEXIT_CRITICAL(&s_ac_lock);
+
+  // Any change after this point re-arms the timer and is written next time
+  app_ac_read(&snap);
+  ac.valid = 1;
+  ac.power = snap.state.power;
+  ac.temp = snap.state.temp;
+  ac.mode = snap.state.mode;
+  ac.fan = snap.state.fan;
+  ac.swing_v = snap.state.swing_v;
+  ac.swing_h = snap.state.swing_h;
+  ac.brand = (uint8_t)snap.brand;
+
+  app_settings_set_ac(&ac);
+  esp_err_t err = app_settings_commit();
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  if (err == ESP_OK) {
+    s_persist_stats.writes++;
+  } else {
+    s_persist_stats.errors++;
+  }
+  taskEXIT_CRITICAL(&s_ac_lock);
+
+  if (err == ESP_OK) {
+    ESP_LOGD(TAG, "AC state persisted");
+  } else {
+    ESP_LOGW(TAG, "AC state persist failed: %s", esp_err_to_name(err));
+  }
+}
+
+static void app_ac_persist_timer_cb(void *arg) { app_ac_persist_now(); }
+
+// Flush a pending write before any esp_restart() (OTA, factory reset, ...)
+static void app_ac_shutdown_handler(void) { app_ac_persist_now(); }
+
+// Called after a RAM change; (re)arms the write-behind timer
+static void app_ac_schedule_persist(void) {
+  int64_t now = esp_timer_get_time();
+  bool rearm = true;
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  s_persist_stats.changes++;
+  if (s_persist_stats.pending) {
+    s_persist_stats.coalesced++;
+    // Keep the running deadline once the burst exceeds the max delay
+    if (now - s_pending_since >= AC_PERSIST_MAX_DELAY_US)
+      rearm = false;
+  } else {
+    s_persist_stats.pending = true;
+    s_pending_since = now;
+  }
+  taskEXIT_CRITICAL(&s_ac_lock);
+
+  if (!s_persist_timer || !rearm)
+    return;
+
+  esp_timer_stop(s_persist_timer);
+  esp_timer_start_once(s_persist_timer, AC_PERSIST_DELAY_US);
+}
+
+static void app_ac_load(void) {
+  app_settings_t settings;
+  app_settings_get(&settings);
+
+  const app_settings_ac_t *ac = &settings.ac;
+  if (!ac->valid) {
+    ESP_LOGI(TAG, "No stored AC state, using defaults");
+    return;
+  }
+
+  ac_snapshot_t snap;
+  taskENTER_CRITICAL(&s_ac_lock);
+  memcpy(&snap, &g_ac, sizeof(snap));
+  snap.state.power = ac->power != 0;
+  snap.state.temp = (ac->temp >= 16 && ac->temp <= 30) ? ac->temp : 24;
+  snap.state.mode = ac->mode;
+  snap.state.fan = ac->fan;
+  snap.state.swing_v = ac->swing_v;
+  snap.state.swing_h = ac->swing_h;
+  if (ac->brand < AC_BRAND_MAX)
+    snap.brand = (ac_brand_t)ac->brand;
+  app_ac_publish(&snap);
+  taskEXIT_CRITICAL(&s_ac_lock);
+
+  ESP_LOGI(TAG, "Restored AC state: Brand=%d, P=%d, M=%d, T=%d", snap.brand,
+           snap.state.power, snap.state.mode, snap.state.temp);
+}
+
+static void app_ac_sched_account(uint32_t sources, bool skipped) {
+  for (int i = 0; i < APP_AC_SRC_COUNT; i++) {
+    if (!(sources & (1u << i)))
+      continue;
+    if (skipped) {
+      s_sched_stats.sources[i].skipped++;
+    } else {
+      s_sched_stats.sources[i].transmitted++;
+    }
+  }
+}
+
+// Called with s_ac_lock held once every request up to seq has been handled.
+// Collects the tasks to wake; they are notified after the lock is dropped.
+static int app_ac_sched_complete(uint32_t seq, esp_err_t err,
+                                 TaskHandle_t wake[AC_MAX_WAITERS]) {
+  int n = 0;
+  for (int i = 0; i < AC_MAX_WAITERS; i++) {
+    ac_waiter_t *w = &s_waiters[i];
+    if (w->task && !w->done && (int32_t)(seq - w->ticket) >= 0) {
+      w->done = true;
+      w->err = err;
+      wake[n++] = w->task;
+    }
+  }
+  return n;
+}
+
+static void app_ac_sched_wake(TaskHandle_t wake[AC_MAX_WAITERS], int n) {
+  for (int i = 0; i < n; i++)
+    xTaskNotifyGive(wake[i]);
+}
+
+static void app_ac_sched_task(void *arg) {
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    // Trailing-edge debounce: wait until the requests stop for one window
+    TickType_t start = xTaskGetTickCount();
+    while (AC_COALESCE_MS > 0 &&
+           (xTaskGetTickCount() - start) < pdMS_TO_TICKS(AC_COALESCE_MAX_MS)) {
+      if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AC_COALESCE_MS)) == 0)
+        break;
+    }
+
+    ac_snapshot_t snap;
+    uint32_t sources;
+    uint32_t seq;
+    bool duplicate;
+    TaskHandle_t wake[AC_MAX_WAITERS];
+    int n_wake = 0;
+
+    // Requests update the state before bumping s_req_seq, so reading the
+    // snapshot after taking seq includes every request up to seq.
+    taskENTER_CRITICAL(&s_ac_lock);
+    sources = s_pending_sources;
+    s_pending_sources = 0;
+    seq = s_req_seq;
+    taskEXIT_CRITICAL(&s_ac_lock);
+
+    app_ac_read(&snap);
+    ir_ac_state_t state = snap.state;
+    ac_brand_t brand = snap.brand;
+
+    taskENTER_CRITICAL(&s_ac_lock);
+    duplicate = s_last_sent_valid && brand == s_last_sent_brand &&
+                memcmp(&state, &s_last_sent_state, sizeof(state)) == 0;
+    if (duplicate) {
+      s_sched_stats.skipped++;
+      app_ac_sched_account(sources, true);
+      n_wake = app_ac_sched_complete(seq, ESP_OK, wake);
+    }
+    taskEXIT_CRITICAL(&s_ac_lock);
+
+    if (duplicate) {
+      app_ac_sched_wake(wake, n_wake);
+      ESP_LOGD(TAG, "AC state unchanged, transmission skipped");
+      continue;
+    }
+
+    ESP_LOGI(TAG, "Sending AC Command: Brand=%d, P=%d, M=%d, T=%d", brand,
+             state.power, state.mode, state.temp);
+    esp_err_t err = ir_engine_send_ac(brand, &state);
+
+    taskENTER_CRITICAL(&s_ac_lock);
+    s_sched_stats.transmissions++;
+    app_ac_sched_account(sources, false);
+    if (err == ESP_OK) {
+      memcpy(&s_last_sent_state, &state, sizeof(state));
+      s_last_sent_brand = brand;
+      s_last_sent_valid = true;
+    } else {
+      // Retransmit the next request even if the state is unchanged
+      s_sched_stats.tx_errors++;
+      s_last_sent_valid = false;
+    }
+    n_wake = app_ac_sched_complete(seq, err, wake);
+    taskEXIT_CRITICAL(&s_ac_lock);
+    app_ac_sched_wake(wake, n_wake);
+
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "AC transmission failed: %s", esp_err_to_name(err));
+    }
+  }
+}
+
+esp_err_t app_ac_init(void) {
+  app_ac_load();
+
+  if (xTaskCreate(app_ac_sched_task, "ac_sched", 4096, NULL, 5,
+                  &s_sched_task) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create AC scheduler task");
+    return ESP_ERR_NO_MEM;
+  }
+
+  esp_timer_create_args_t timer_args = {
+      .callback = app_ac_persist_timer_cb,
+      .name = "ac_persist",
+  };
+  esp_err_t err = esp_timer_create(&timer_args, &s_persist_timer);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Persist timer create failed: %s", esp_err_to_name(err));
+    return err;
+  }
+
+  err = esp_register_shutdown_handler(app_ac_shutdown_handler);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Shutdown flush not registered: %s", esp_err_to_name(err));
   }
+
+  ESP_LOGI(TAG,
+           "AC Logic Initialized (coalesce %d ms, persist delay %d ms)",
+           AC_COALESCE_MS, CONFIG_APP_AC_PERSIST_DELAY_MS);
+  return ESP_OK;
+}
+
+bool app_ac_update_state(const ir_ac_state_t *delta, ac_brand_t brand,
+                         uint32_t fields) {
+  ac_snapshot_t next;
+  bool changed;
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  memcpy(&next, &g_ac, sizeof(next));
+  app_ac_apply_fields(&next, delta, brand, fields);
+  changed = next.brand != g_ac.brand ||
+            memcmp(&next.state, &g_ac.state, sizeof(next.state)) != 0;
+  if (changed)
+    app_ac_publish(&next);
+  taskEXIT_CRITICAL(&s_ac_lock);
+
+  if (changed) {
+    app_ac_schedule_persist();
+    if (s_change_cb)
+      s_change_cb();
+  }
+  return changed;
+}
+
+void app_ac_set_state(const ir_ac_state_t *state) {
+  if (state)
+    app_ac_update_state(state, AC_BRAND_MAX, APP_AC_FIELD_STATE);
 }
 
 void app_ac_get_state(ir_ac_state_t *state) {
   if (state) {
-    memcpy(state, &g_ac_state, sizeof(ir_ac_state_t));
+    ac_snapshot_t snap;
+    app_ac_read(&snap);
+    memcpy(state, &snap.state, sizeof(ir_ac_state_t));
   }
 }
 
 void app_ac_set_brand(ac_brand_t brand) {
-  if (brand < AC_BRAND_MAX) {
-    g_ac_brand = brand;
+  if (brand < AC_BRAND_MAX)
+    app_ac_update_state(NULL, brand, APP_AC_FIELD_BRAND);
+}
+
+ac_brand_t app_ac_get_brand(void) {
+  ac_snapshot_t snap;
+  app_ac_read(&snap);
+  return snap.brand;
+}
+
+void app_ac_set_change_cb(app_ac_change_cb_t cb) { s_change_cb = cb; }
+
+void app_ac_flush(void) {
+  if (s_persist_timer)
+    esp_timer_stop(s_persist_timer);
+  app_ac_persist_now();
+}
+
+void app_ac_get_persist_stats(app_ac_persist_stats_t *stats) {
+  if (!stats)
+    return;
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  memcpy(stats, &s_persist_stats, sizeof(*stats));
+  taskEXIT_CRITICAL(&s_ac_lock);
+}
+
+esp_err_t app_ac_request_send(app_ac_source_t source) {
+  if (source >= APP_AC_SRC_COUNT)
+    return ESP_ERR_INVALID_ARG;
+  if (!s_sched_task)
+    return app_ac_send();
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  s_sched_stats.sources[source].received++;
+  s_pending_sources |= 1u << source;
+  s_req_seq++;
+  taskEXIT_CRITICAL(&s_ac_lock);
+
+  xTaskNotifyGive(s_sched_task);
+  return ESP_OK;
+}
+
+esp_err_t app_ac_request_send_wait(app_ac_source_t source,
+                                   uint32_t timeout_ms) {
+  if (source >= APP_AC_SRC_COUNT)
+    return ESP_ERR_INVALID_ARG;
+  if (!s_sched_task)
+    return app_ac_send();
+
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  ac_waiter_t *w = NULL;
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  for (int i = 0; i < AC_MAX_WAITERS && !w; i++) {
+    if (!s_waiters[i].task)
+      w = &s_waiters[i];
+  }
+  s_sched_stats.sources[source].received++;
+  s_pending_sources |= 1u << source;
+  s_req_seq++;
+  if (w) {
+    w->task = self;
+    w->ticket = s_req_seq;
+    w->done = false;
+    w->err = ESP_OK;
   }
+  taskEXIT_CRITICAL(&s_ac_lock);
+
+  xTaskNotifyGive(s_sched_task);
+  if (!w)
+    return ESP_ERR_TIMEOUT; // Queued, but completion cannot be tracked
+
+  // Stale notifications from an earlier timed-out wait only cause a
+  // re-check of the done flag.
+  TickType_t start = xTaskGetTickCount();
+  TickType_t limit = pdMS_TO_TICKS(timeout_ms);
+  esp_err_t err = ESP_ERR_TIMEOUT;
+  while (1) {
+    taskENTER_CRITICAL(&s_ac_lock);
+    bool done = w->done;
+    if (done)
+      err = w->err;
+    taskEXIT_CRITICAL(&s_ac_lock);
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (done || elapsed >= limit)
+      break;
+    ulTaskNotifyTake(pdTRUE, limit - elapsed);
+  }
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  w->task = NULL;
+  taskEXIT_CRITICAL(&s_ac_lock);
+  return err;
 }
 
-ac_brand_t app_ac_get_brand(void) { return g_ac_brand; }
+void app_ac_get_sched_stats(app_ac_sched_stats_t *stats) {
+  if (!stats)
+    return;
+
+  taskENTER_CRITICAL(&s_ac_lock);
+  memcpy(stats, &s_sched_stats, sizeof(*stats));
+  taskEXIT_CRITICAL(&s_ac_lock);
+}
+
+const char *app_ac_source_to_str(app_ac_source_t source) {
+  switch (source) {
+  case APP_AC_SRC_WEB:
+    return "web";
+  case APP_AC_SRC_CLOUD:
+    return "cloud";
+  case APP_AC_SRC_LOCAL:
+    return "local";
+  default:
+    return "unknown";
+  }
+}
 
 esp_err_t app_ac_send(void) {
-  ESP_LOGI(TAG, "Sending AC Command: Brand=%d, P=%d, M=%d, T=%d", g_ac_brand,
-           g_ac_state.power, g_ac_state.mode, g_ac_state.temp);
+  ac_snapshot_t snap;
+  app_ac_read(&snap);
 
-  return ir_engine_send_ac(g_ac_brand, &g_ac_state);
+  ESP_LOGI(TAG, "Sending AC Command: Brand=%d, P=%d, M=%d, T=%d", snap.brand,
+           snap.state.power, snap.state.mode, snap.state.temp);
+
+  esp_err_t err = ir_engine_send_ac(snap.brand, &snap.state);
+
+  // Keep the scheduler's duplicate check in step with what is on the air
+  taskENTER_CRITICAL(&s_ac_lock);
+  if (err == ESP_OK) {
+    memcpy(&s_last_sent_state, &snap.state, sizeof(snap.state));
+    s_last_sent_brand = snap.brand;
+    s_last_sent_valid = true;
+  } else {
+    s_last_sent_valid = false;
+  }
+  taskEXIT_CRITICAL(&s_ac_lock);
+  return err;
 }
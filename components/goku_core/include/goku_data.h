@@ -5,11 +5,18 @@
 
 #pragma once
 
-#include "cJSON.h"
 #include <esp_err.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+/**
+ * @brief Callback invoked after an IR key is written, deleted or renamed
+ *
+ * @param key Key whose stored data changed (both old and new key on rename)
+ */
+typedef void (*app_data_ir_change_cb_t)(const char *key);
+
 /**
  * @brief Initialize Data Storage component (NVS)
  *
@@ -55,8 +62,29 @@ esp_err_t app_data_delete_ir(const char *key);
 esp_err_t app_data_rename_ir(const char *old_key, const char *new_key);
 
 /**
- * @brief Get list of all saved IR keys
+ * @brief Register a callback notified whenever stored IR data changes
+ *
+ * Used by consumers that keep derived copies of IR data (e.g. decoded symbol
+ * caches) to drop stale entries. Only one callback is supported.
+ *
+ * @param cb Callback, or NULL to unregister
+ */
+void app_data_set_ir_change_cb(app_data_ir_change_cb_t cb);
+
+/**
+ * @brief Callback for app_data_foreach_ir_key
+ *
+ * @param key Saved key name (valid only during the call)
+ * @param ctx User context
+ * @return true to continue, false to stop iterating
+ */
+typedef bool (*app_data_ir_key_cb_t)(const char *key, void *ctx);
+
+/**
+ * @brief Visit every saved IR key without building a list
  *
- * @return cJSON* JSON Array containing key strings
+ * @param cb Callback invoked once per key
+ * @param ctx User context passed to cb
+ * @return esp_err_t ESP_OK on success (also when no keys are stored)
  */
-cJSON *app_data_get_ir_keys(void);
+esp_err_t app_data_foreach_ir_key(app_data_ir_key_cb_t cb, void *ctx);
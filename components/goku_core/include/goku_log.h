@@ -1,15 +1,111 @@
 /**
  * @file goku_log.h
  * @brief In-memory Logging System
+ *
+ * Captures ESP_LOG output into a RAM ring shared by all tasks and both
+ * cores. Writers never block: each line is formatted once, then copied into
+ * space claimed with an atomic compare-and-swap. A line is dropped (and
+ * counted) only when the oldest line in the ring is itself still being
+ * written by a preempted task.
+ *
+ * Hot paths log with APP_LOGBI() and friends instead of ESP_LOGI(): the
+ * record keeps the format pointer and the raw argument words, and the text
+ * is produced only when the ring is read or when the drain task copies the
+ * line to the console (up to CONFIG_APP_LOG_DRAIN_MS later). Every argument
+ * must be one 32-bit word (integers, char, pointers) and %s arguments must
+ * point to strings that outlive the ring, such as literals or const tables.
+ * 64-bit and floating point arguments are not supported.
+ *
+ * The ring is kept across panic, watchdog and software resets. At the next
+ * boot app_log_init() writes it as text into the "logs" flash partition,
+ * tagged with the reset reason, where it stays until another such reset
+ * replaces it.
+ *
+ * Per-tag rules set a tag's level through esp_log_level_set() and can keep
+ * only one line in N and at most a number of lines per minute. Sampling and
+ * limits are applied before a line is formatted and never hold back errors.
+ * Rules are stored in the settings snapshot and applied by
+ * app_log_tags_init().
  */
 
 #pragma once
 
 #include "esp_err.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t lines;      // Lines stored in the ring since boot
+  uint32_t dropped;    // Lines not stored because no space could be claimed
+  uint32_t truncated;  // Lines cut to the ring's line length limit
+  uint32_t suppressed; // Lines held back by tag rules
+} app_log_stats_t;
+
+#define APP_LOG_TAG_LEN 16 // Longest tag with a rule, NUL included
+#define APP_LOG_TAGS_MAX 32 // Tags tracked; later ones are never limited
+
+typedef struct {
+  char tag[APP_LOG_TAG_LEN]; // Possibly cut short
+  bool rule;                 // level, sample and per_min come from a rule
+  esp_log_level_t level;     // Rule level, or the default level
+  uint8_t sample;            // Keep one line in N (0 or 1 = all)
+  uint16_t per_min;          // Lines per minute (0 = unlimited)
+  uint32_t emitted;          // Lines that passed since boot
+  uint32_t suppressed;       // Lines held back by sampling or limits
+} app_log_tag_info_t;
+
+typedef struct {
+  esp_reset_reason_t reason; // How the saved boot ended
+  size_t len;                // Bytes of text
+} app_log_previous_t;
+
+#define APP_LOGB_MAX_ARGS 8
+
+// Number of variadic arguments, 0..12
+#define APP_LOGB_NARGS(...)                                                    \
+  APP_LOGB_NARGS_(0, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define APP_LOGB_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, \
+                        N, ...)                                                \
+  N
+
+#if CONFIG_APP_LOG_DEFERRED
+#define APP_LOGB(level, tag, fmt, ...)                                         \
+  do {                                                                         \
+    (void)sizeof(char[APP_LOGB_NARGS(__VA_ARGS__) <= APP_LOGB_MAX_ARGS         \
+                           ? 1                                                 \
+                           : -1]);                                             \
+    if (LOG_LOCAL_LEVEL >= (level))                                            \
+      app_log_deferred((level), (tag), (fmt), APP_LOGB_NARGS(__VA_ARGS__),     \
+                       ##__VA_ARGS__);                                         \
+  } while (0)
+#else
+#define APP_LOGB(level, tag, fmt, ...)                                         \
+  ESP_LOG_LEVEL_LOCAL((level), (tag), fmt, ##__VA_ARGS__)
+#endif
+
+#define APP_LOGBE(tag, fmt, ...)                                               \
+  APP_LOGB(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define APP_LOGBW(tag, fmt, ...)                                               \
+  APP_LOGB(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define APP_LOGBI(tag, fmt, ...)                                               \
+  APP_LOGB(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define APP_LOGBD(tag, fmt, ...)                                               \
+  APP_LOGB(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /**
  * @brief Initialize logging system
+ *
+ * Saves the ring left by the previous boot to flash if it survived the
+ * reset, installs the ESP_LOG hook and, with CONFIG_APP_LOG_DEFERRED, starts
+ * the task that prints deferred lines. Call it first in app_main().
  */
 void app_log_init(void);
 
@@ -22,7 +118,140 @@ void app_log_init(void);
  */
 int app_log_get_buffer(char *dest, size_t max_len);
 
+/**
+ * @brief Read log bytes written at or after a cursor
+ *
+ * Offsets are monotonically increasing positions in the ring. They also
+ * count per-line bookkeeping, so the distance between two offsets is an
+ * upper bound on the text between them, not its exact length, and they wrap
+ * after 4 GiB of ring traffic. Readers keep the returned @p next offset and
+ * pass it back to receive only new output. If the cursor points at data
+ * already overwritten (or cleared), reading resumes at the oldest retained
+ * line and the gap is reported in @p dropped. A line still being written
+ * ends the read early. Deferred lines are never split; @p max_len should
+ * be at least 256 so that none is truncated. The output is not
+ * NUL-terminated.
+ *
+ * @param cursor Offset to read from (0 = oldest retained byte)
+ * @param dest Destination buffer
+ * @param max_len Maximum bytes to copy
+ * @param[out] next Offset following the last copied byte (may be NULL)
+ * @param[out] dropped Offsets skipped because they left the ring (may be
+ *                     NULL)
+ * @return size_t Number of bytes copied
+ */
+size_t app_log_read_since(uint64_t cursor, char *dest, size_t max_len,
+                          uint64_t *next, uint64_t *dropped);
+
+/**
+ * @brief Read log text like app_log_read_since(), stopping at an offset
+ *
+ * Lines starting at or after @p end are left for a later read, so a reader
+ * that announced @p end (from app_log_get_cursor()) as its resume point
+ * neither skips nor repeats output.
+ *
+ * @param cursor Offset to read from
+ * @param end Offset to stop at
+ * @param dest Destination buffer
+ * @param max_len Maximum bytes to copy
+ * @param[out] next Offset following the last copied byte (may be NULL)
+ * @param[out] dropped Offsets skipped because they left the ring (may be
+ *                     NULL)
+ * @return size_t Number of bytes copied
+ */
+size_t app_log_read_until(uint64_t cursor, uint64_t end, char *dest,
+                          size_t max_len, uint64_t *next, uint64_t *dropped);
+
+/**
+ * @brief Offset one past the newest completely written line
+ *
+ * @return uint64_t Current write offset
+ */
+uint64_t app_log_get_cursor(void);
+
 /**
  * @brief Clear in-memory log buffer
+ *
+ * Offsets are not reset; readers simply see no data before this point.
  */
 void app_log_clear(void);
+
+/**
+ * @brief Get line counters of the log ring
+ *
+ * @param[out] out Counters since boot
+ */
+void app_log_get_stats(app_log_stats_t *out);
+
+/**
+ * @brief Describe the log saved from an earlier boot
+ *
+ * @param[out] out Reset reason and length of the saved text
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if nothing valid is saved
+ */
+esp_err_t app_log_get_previous(app_log_previous_t *out);
+
+/**
+ * @brief Read the text of the log saved from an earlier boot
+ *
+ * @param offset Byte offset into the saved text
+ * @param dest Destination buffer
+ * @param max_len Maximum bytes to copy
+ * @return size_t Number of bytes copied, 0 at the end or on a flash error
+ */
+size_t app_log_read_previous(size_t offset, char *dest, size_t max_len);
+
+/**
+ * @brief Apply the tag rules stored in the settings
+ *
+ * Call after app_settings_init().
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if a rule found no free tag slot
+ */
+esp_err_t app_log_tags_init(void);
+
+/**
+ * @brief Set the level, sampling and rate limit of a tag and store them
+ *
+ * @param tag Tag, shorter than APP_LOG_TAG_LEN
+ * @param level Most verbose level printed
+ * @param sample Keep one line in N (0 or 1 = all)
+ * @param per_min Lines per minute after sampling (0 = unlimited)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM when the runtime or
+ *         stored rule table is full, or an NVS error
+ */
+esp_err_t app_log_set_tag(const char *tag, esp_log_level_t level,
+                          uint8_t sample, uint16_t per_min);
+
+/**
+ * @brief Remove the rule of a tag, restoring the default level
+ *
+ * @param tag Tag
+ * @return ESP_OK, ESP_ERR_INVALID_ARG or an NVS error
+ */
+esp_err_t app_log_reset_tag(const char *tag);
+
+/**
+ * @brief List the tags seen since boot with their rules and counters
+ *
+ * @param[out] out Destination array
+ * @param max Entries in out
+ * @return size_t Entries written
+ */
+size_t app_log_get_tags(app_log_tag_info_t *out, size_t max);
+
+/**
+ * @brief Store a line for deferred formatting (use APP_LOGB*)
+ *
+ * @param level Log level
+ * @param tag Tag, must outlive the ring
+ * @param fmt printf format, must outlive the ring
+ * @param nargs Number of variadic arguments (at most APP_LOGB_MAX_ARGS)
+ */
+void app_log_deferred(esp_log_level_t level, const char *tag,
+                      const char *fmt, int nargs, ...)
+    __attribute__((format(printf, 3, 5)));
+
+#ifdef __cplusplus
+}
+#endif
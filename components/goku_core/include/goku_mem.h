@@ -6,6 +6,42 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Subsystem an allocation is charged to
+ */
+typedef enum {
+  APP_MEM_TAG_IR,   // IR symbol, learning and encoding buffers
+  APP_MEM_TAG_WEB,  // Batch jobs and WebSocket frames
+  APP_MEM_TAG_DATA, // NVS staging buffers
+  APP_MEM_TAG_COUNT
+} app_mem_tag_t;
+
+/**
+ * @brief Memory an allocation landed in
+ */
+typedef enum {
+  APP_MEM_CLASS_INTERNAL, // Internal RAM
+  APP_MEM_CLASS_PSRAM,    // External RAM
+  APP_MEM_CLASS_DMA,      // Internal RAM requested with MALLOC_CAP_DMA
+  APP_MEM_CLASS_TOTAL,    // All of the above
+  APP_MEM_CLASS_COUNT
+} app_mem_class_t;
+
+/**
+ * @brief Usage counters of one tag in one memory class
+ */
+typedef struct {
+  uint32_t bytes;  // Currently allocated (headers excluded)
+  uint32_t peak;   // Highest value of bytes since boot
+  uint32_t live;   // Allocations not freed yet
+  uint32_t allocs; // Successful allocations since boot
+  uint32_t failed; // Allocations that returned NULL
+} app_mem_usage_t;
+
 /**
  * @brief Initialize memory monitoring task
  *
@@ -36,4 +72,65 @@ size_t app_mem_get_free_psram(void);
  */
 bool app_mem_is_safe(size_t size, bool use_psram);
 
+/**
+ * @brief Allocate memory charged to a subsystem
+ *
+ * Like heap_caps_malloc(), with 8 bytes of bookkeeping in front of the
+ * block. Free the result with app_mem_free() only.
+ *
+ * @param tag Subsystem to charge
+ * @param size Bytes
+ * @param caps MALLOC_CAP_* flags
+ * @return void* Block, or NULL
+ */
+void *app_mem_malloc(app_mem_tag_t tag, size_t size, uint32_t caps);
+
+/**
+ * @brief Allocate with preferred caps, falling back to other caps
+ *
+ * A failure of the preferred caps alone is not counted as failed.
+ *
+ * @param tag Subsystem to charge
+ * @param size Bytes
+ * @param caps Caps tried first (e.g. MALLOC_CAP_SPIRAM)
+ * @param fallback_caps Caps tried next
+ * @return void* Block, or NULL
+ */
+void *app_mem_malloc_prefer(app_mem_tag_t tag, size_t size, uint32_t caps,
+                            uint32_t fallback_caps);
+
+/**
+ * @brief Zeroed app_mem_malloc() of n elements of size bytes
+ */
+void *app_mem_calloc(app_mem_tag_t tag, size_t n, size_t size, uint32_t caps);
+
+/**
+ * @brief Free a block from app_mem_malloc() and friends (NULL is ignored)
+ */
+void app_mem_free(void *ptr);
+
+/**
+ * @brief Get usage counters of a tag
+ *
+ * @param tag Subsystem
+ * @param cls Memory class, or APP_MEM_CLASS_TOTAL for all of them
+ * @param[out] out Counters
+ */
+void app_mem_get_usage(app_mem_tag_t tag, app_mem_class_t cls,
+                       app_mem_usage_t *out);
+
+/**
+ * @brief Short name of a tag ("ir", "web", ...)
+ */
+const char *app_mem_tag_name(app_mem_tag_t tag);
+
+/**
+ * @brief Short name of a memory class ("internal", "psram", ...)
+ */
+const char *app_mem_class_name(app_mem_class_t cls);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // APP_MEM_H
@@ -0,0 +1,163 @@
+/**
+ * @file goku_settings.h
+ * @brief Unified Versioned Settings Store
+ *
+ * All device settings live in a single typed snapshot that is loaded with one
+ * NVS read at boot and written back with one blob write + commit. The blob is
+ * prefixed with a header carrying a schema version and CRC32, so a torn or
+ * stale write is detected and older layouts are migrated forward.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_SETTINGS_LED_EFFECT_COUNT 13
+#define APP_SETTINGS_LED_STATE_COUNT 10
+#define APP_SETTINGS_LED_PIXELS 8
+#define APP_SETTINGS_LOG_TAGS 8
+#define APP_SETTINGS_LOG_TAG_LEN 16
+
+/**
+ * @brief Per-effect LED configuration
+ */
+typedef struct {
+  uint8_t colors[APP_SETTINGS_LED_PIXELS][3]; // [led_index][rgb]
+  uint8_t speed;                              // 1-100
+} app_settings_led_effect_t;
+
+/**
+ * @brief RGB color
+ */
+typedef struct {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+} app_settings_rgb_t;
+
+/**
+ * @brief LED section
+ */
+typedef struct {
+  app_settings_led_effect_t effects[APP_SETTINGS_LED_EFFECT_COUNT];
+  app_settings_rgb_t state_colors[APP_SETTINGS_LED_STATE_COUNT];
+  uint8_t effect;     // Active effect
+  uint8_t brightness; // 0-100
+} app_settings_led_t;
+
+/**
+ * @brief AC section (mirrors ir_ac_state_t + brand)
+ */
+typedef struct {
+  uint8_t valid; // Non-zero once an AC state has been stored
+  uint8_t power;
+  uint8_t temp;
+  uint8_t mode;
+  uint8_t fan;
+  uint8_t swing_v;
+  uint8_t swing_h;
+  uint8_t brand;
+} app_settings_ac_t;
+
+/**
+ * @brief Log rule for one tag
+ */
+typedef struct {
+  char tag[APP_SETTINGS_LOG_TAG_LEN]; // Empty for an unused entry
+  uint8_t level;                      // esp_log_level_t
+  uint8_t sample;                     // Keep one line in N (0 or 1 = all)
+  uint16_t per_min;                   // Lines per minute (0 = unlimited)
+} app_settings_log_tag_t;
+
+/**
+ * @brief Log section
+ */
+typedef struct {
+  app_settings_log_tag_t tags[APP_SETTINGS_LOG_TAGS];
+} app_settings_log_t;
+
+/**
+ * @brief Complete settings snapshot (schema version 2)
+ *
+ * New fields must only be appended; an older, shorter blob is copied over
+ * the defaults, so appended fields start at their default values, and the
+ * per-version migration steps then run.
+ */
+typedef struct {
+  app_settings_led_t led;
+  app_settings_ac_t ac;
+  app_settings_log_t log; // Since v2
+} app_settings_t;
+
+/**
+ * @brief Settings store counters
+ */
+typedef struct {
+  uint32_t commits;       // Snapshot writes issued to NVS
+  uint32_t commit_errors; // Failed snapshot writes
+  uint32_t bytes_written; // Total blob bytes written
+  uint16_t loaded_version; // Schema version found at boot (0 = none)
+  bool dirty;              // Unsaved changes pending
+} app_settings_stats_t;
+
+/**
+ * @brief Load the settings snapshot (one NVS read)
+ *
+ * Must be called after app_data_init(). Falls back to defaults when no valid
+ * snapshot exists and imports legacy per-key settings on first boot.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t app_settings_init(void);
+
+/**
+ * @brief Copy the current snapshot
+ *
+ * @param out Destination
+ */
+void app_settings_get(app_settings_t *out);
+
+/**
+ * @brief Replace the LED section (in RAM, marks dirty)
+ *
+ * @param led New LED settings
+ */
+void app_settings_set_led(const app_settings_led_t *led);
+
+/**
+ * @brief Replace the AC section (in RAM, marks dirty)
+ *
+ * @param ac New AC settings
+ */
+void app_settings_set_ac(const app_settings_ac_t *ac);
+
+/**
+ * @brief Replace the log section (in RAM, marks dirty)
+ *
+ * @param log New log rules
+ */
+void app_settings_set_log(const app_settings_log_t *log);
+
+/**
+ * @brief Write the snapshot to NVS if it changed
+ *
+ * @return esp_err_t ESP_OK on success (or nothing to write)
+ */
+esp_err_t app_settings_commit(void);
+
+/**
+ * @brief Get store counters
+ *
+ * @param stats Destination
+ */
+void app_settings_get_stats(app_settings_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,7 @@
 #include "goku_data.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "goku_mem.h"
 #include "nvs.h"
 #include "nvs_flash.h"
 #include <malloc.h>
@@ -8,6 +10,17 @@
 #define TAG "goku_data"
 #define NVS_NAMESPACE "ir_data"
 
+static app_data_ir_change_cb_t s_ir_change_cb = NULL;
+
+static void app_data_notify_ir_change(const char *key) {
+  if (s_ir_change_cb)
+    s_ir_change_cb(key);
+}
+
+void app_data_set_ir_change_cb(app_data_ir_change_cb_t cb) {
+  s_ir_change_cb = cb;
+}
+
 esp_err_t app_data_init(void) {
   esp_err_t err = nvs_flash_init();
   if (err == ESP_ERR_NVS_NO_FREE_PAGES ||
@@ -35,6 +48,7 @@ esp_err_t app_data_save_ir(const char *key, const void *data, size_t len) {
     ESP_LOGE(TAG, "NVS Set Blob failed: %s", esp_err_to_name(err));
   }
   nvs_close(my_handle);
+  app_data_notify_ir_change(key);
   return err;
 }
 
@@ -67,6 +81,7 @@ esp_err_t app_data_delete_ir(const char *key) {
     err = nvs_commit(my_handle);
   }
   nvs_close(my_handle);
+  app_data_notify_ir_change(key);
   return err;
 }
 
@@ -78,7 +93,7 @@ esp_err_t app_data_rename_ir(const char *old_key, const char *new_key) {
     return err;
 
   // Load old data
-  void *data = malloc(len);
+  void *data = app_mem_malloc(APP_MEM_TAG_DATA, len, MALLOC_CAP_DEFAULT);
   if (!data)
     return ESP_ERR_NO_MEM;
 
@@ -86,7 +101,7 @@ esp_err_t app_data_rename_ir(const char *old_key, const char *new_key) {
 
   // Save with new key
   err = app_data_save_ir(new_key, data, len);
-  free(data);
+  app_mem_free(data);
 
   if (err != ESP_OK)
     return err;
@@ -95,17 +110,20 @@ esp_err_t app_data_rename_ir(const char *old_key, const char *new_key) {
   return app_data_delete_ir(old_key);
 }
 
-cJSON *app_data_get_ir_keys(void) {
-  cJSON *list = cJSON_CreateArray();
+esp_err_t app_data_foreach_ir_key(app_data_ir_key_cb_t cb, void *ctx) {
+  if (!cb)
+    return ESP_ERR_INVALID_ARG;
+
   nvs_iterator_t it = NULL;
   esp_err_t res =
       nvs_entry_find(NVS_DEFAULT_PART_NAME, NVS_NAMESPACE, NVS_TYPE_BLOB, &it);
   while (res == ESP_OK) {
     nvs_entry_info_t info;
     nvs_entry_info(it, &info);
-    cJSON_AddItemToArray(list, cJSON_CreateString(info.key));
+    if (!cb(info.key, ctx))
+      break;
     res = nvs_entry_next(&it);
   }
   nvs_release_iterator(it);
-  return list;
+  return (res == ESP_OK || res == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : res;
 }
@@ -1,102 +1,624 @@
 #include "goku_log.h"
+#include "goku_log_tag.h"
+#include "esp_app_desc.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <inttypes.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
-#define LOG_BUFFER_SIZE 4096
+#define LOG_BUFFER_SIZE 4096 // Power of two, so positions survive u32 wrap
+#define LOG_LINE_MAX 256     // Longer lines are truncated in the ring
+#define LOG_ALIGN 4
+#define LOG_REC_DEFERRED 0x80 // Level flag: payload is log_deferred_t
+#define LOG_DRAIN_STACK 4096
+#define LOG_RING_MAGIC 0x474C5247  // "GRLG": ring left by the previous boot
+#define LOG_SAVED_MAGIC 0x474C5356 // "GSLV": complete copy in flash
+#define LOG_SAVED_PARTITION "logs"
 
-static char s_log_buffer[LOG_BUFFER_SIZE];
-static size_t s_log_head = 0; // Write index
-static bool s_log_wrapped = false;
-static SemaphoreHandle_t s_log_mutex = NULL;
+// Every line is one record: header, text, padding to LOG_ALIGN. Records
+// never straddle the end of the ring; the space left before the wrap is
+// covered by a text-less record, or skipped outright when it is too small
+// to hold a header.
+typedef struct {
+  _Atomic uint32_t pos; // Set to the record's position last, as the commit
+  uint16_t len;         // Record bytes, header and padding included
+  uint16_t text_len;    // 0 for the filler before a wrap
+  uint32_t ts_ms;       // esp_log_timestamp()
+  uint8_t level; // esp_log_level_t (ESP_LOG_NONE if not from ESP_LOG) and
+                 // LOG_REC_DEFERRED
+  uint8_t core;
+  uint8_t tag_off; // Tag within the text; tag_len 0 if there is none
+  uint8_t tag_len;
+} log_hdr_t;
+
+#define LOG_HDR_SIZE sizeof(log_hdr_t)
+
+// Payload of an APP_LOGB record, formatted when it is read
+typedef struct {
+  const char *fmt;
+  const char *tag;
+  uint32_t args[];
+} log_deferred_t;
+
+// Header of the previous boot's log in the "logs" partition, written after
+// the text so a save cut short by a reset is never served
+typedef struct {
+  uint32_t magic;  // LOG_SAVED_MAGIC
+  uint32_t reason; // esp_reset_reason_t that ended that boot
+  uint32_t len;    // Text bytes following the header
+  uint32_t crc;    // esp_rom_crc32_le() of the text
+} log_saved_hdr_t;
+
+_Static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0,
+               "LOG_BUFFER_SIZE must be a power of two");
+_Static_assert(LOG_HDR_SIZE % LOG_ALIGN == 0, "Header breaks alignment");
+
+// The ring and its positions are not cleared at startup: after a panic,
+// watchdog or software reset they still hold the end of the previous boot,
+// which app_log_init() copies to flash before starting over.
+static __NOINIT_ATTR uint8_t s_log_buffer[LOG_BUFFER_SIZE]
+    __attribute__((aligned(4)));
+// Positions count ring bytes since boot (mod 2^32). The ring holds the
+// records in [max(tail, base), head); producers claim space by moving head
+// and retire the oldest records by moving tail, both with compare-and-swap.
+static __NOINIT_ATTR _Atomic uint32_t s_log_head;
+static __NOINIT_ATTR _Atomic uint32_t s_log_tail;
+static __NOINIT_ATTR _Atomic uint32_t s_log_base; // Position of the last clear
+static __NOINIT_ATTR uint32_t s_log_magic;        // LOG_RING_MAGIC once set up
+static __NOINIT_ATTR uint8_t s_log_image[8]; // ELF hash prefix of the writer
+static _Atomic uint32_t s_log_lines = 0;
+static _Atomic uint32_t s_log_dropped = 0;
+static _Atomic uint32_t s_log_truncated = 0;
 static vprintf_like_t s_prev_vprintf = NULL;
+static bool s_log_foreign = false; // Deferred pointers are from other firmware
+static const esp_partition_t *s_saved_part = NULL;
+static log_saved_hdr_t s_saved_hdr;
 
-static int app_log_vprintf(const char *fmt, va_list ap) {
-  // First, print to standard output (UART/USB)
-  int ret = 0;
-  if (s_prev_vprintf) {
-    ret = s_prev_vprintf(fmt, ap);
-  } else {
-    ret = vprintf(fmt, ap);
-  }
+static log_hdr_t *log_hdr_at(uint32_t pos) {
+  return (log_hdr_t *)&s_log_buffer[pos % LOG_BUFFER_SIZE];
+}
+
+// Mark a freshly reserved header as uncommitted before filling it in. The
+// ring is not cleared at boot, so a stale header may already carry this
+// very position; readers must not accept it while it is half written.
+static log_hdr_t *log_hdr_claim(uint32_t pos) {
+  log_hdr_t *hdr = log_hdr_at(pos);
+  atomic_store_explicit(&hdr->pos, pos + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  return hdr;
+}
+
+// A committed header whose length keeps the walk inside the ring; checked
+// because a ring inherited from the previous boot may hold anything
+static bool log_hdr_valid(const log_hdr_t *hdr, uint32_t rec) {
+  return atomic_load_explicit(&hdr->pos, memory_order_acquire) == rec &&
+         hdr->len >= LOG_HDR_SIZE && hdr->len % LOG_ALIGN == 0 &&
+         hdr->len <= LOG_BUFFER_SIZE - rec % LOG_BUFFER_SIZE &&
+         hdr->text_len <= hdr->len - LOG_HDR_SIZE;
+}
 
-  if (s_log_mutex && xSemaphoreTake(s_log_mutex, 0) == pdTRUE) {
-    // Format string into a temporary buffer
-    char temp_buf[256];
-    int len = vsnprintf(temp_buf, sizeof(temp_buf), fmt, ap);
-    if (len > 0) {
-      for (int i = 0; i < len; i++) {
-        s_log_buffer[s_log_head++] = temp_buf[i];
-        if (s_log_head >= LOG_BUFFER_SIZE) {
-          s_log_head = 0;
-          s_log_wrapped = true;
+// Bytes from pos to the end of the ring
+static uint32_t log_room(uint32_t pos) {
+  return LOG_BUFFER_SIZE - pos % LOG_BUFFER_SIZE;
+}
+
+// Position a is before b, valid across u32 wrap for positions in the ring
+static bool log_before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+// Claim len contiguous bytes. Fails only when the oldest record must be
+// retired but its writer has not committed it yet; the caller drops the line
+// rather than wait.
+static bool log_reserve(uint32_t len, uint32_t *out) {
+  while (1) {
+    uint32_t head = atomic_load_explicit(&s_log_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&s_log_tail, memory_order_acquire);
+    uint32_t skip = (log_room(head) < len) ? log_room(head) : 0;
+
+    if (head + skip + len - tail > LOG_BUFFER_SIZE) {
+      uint32_t step = log_room(tail);
+      if (step >= LOG_HDR_SIZE) {
+        log_hdr_t *old = log_hdr_at(tail);
+        if (atomic_load_explicit(&old->pos, memory_order_acquire) != tail) {
+          if (atomic_load(&s_log_tail) != tail)
+            continue; // Retired by another producer meanwhile
+          return false;
         }
+        step = old->len;
+      }
+      // Only valid if tail has not moved since the header was read
+      atomic_compare_exchange_weak(&s_log_tail, &tail, tail + step);
+      continue;
+    }
+
+    if (atomic_compare_exchange_weak_explicit(&s_log_head, &head,
+                                              head + skip + len,
+                                              memory_order_acq_rel,
+                                              memory_order_relaxed)) {
+      if (skip >= LOG_HDR_SIZE) {
+        log_hdr_t *fill = log_hdr_claim(head);
+        fill->len = skip;
+        fill->text_len = 0;
+        fill->level = ESP_LOG_NONE; // Never mistaken for a deferred record
+        atomic_store_explicit(&fill->pos, head, memory_order_release);
       }
+      *out = head + skip;
+      return true;
     }
-    xSemaphoreGive(s_log_mutex);
   }
+}
+
+// ESP_LOG lines read "[color]L (time) tag: message"
+static void log_parse(const char *s, size_t len, log_hdr_t *hdr) {
+  static const char levels[] = "EWIDV"; // ESP_LOG_ERROR..ESP_LOG_VERBOSE
+  hdr->level = ESP_LOG_NONE;
+  hdr->tag_off = 0;
+  hdr->tag_len = 0;
+
+  size_t i = 0;
+  if (len > 0 && s[0] == '\033') {
+    const char *m = memchr(s, 'm', len);
+    if (!m)
+      return;
+    i = m - s + 1;
+  }
+  if (i + 2 >= len || s[i + 1] != ' ' || s[i + 2] != '(')
+    return;
+  const char *lvl = s[i] ? strchr(levels, s[i]) : NULL;
+  if (!lvl)
+    return;
+  hdr->level = ESP_LOG_ERROR + (lvl - levels);
+
+  const char *close = memchr(s + i, ')', len - i);
+  if (!close || close + 2 >= s + len || close[1] != ' ')
+    return;
+  const char *tag = close + 2;
+  for (const char *p = tag; p + 1 < s + len; p++) {
+    if (p[0] == ':' && p[1] == ' ') {
+      hdr->tag_off = tag - s;
+      hdr->tag_len = p - tag;
+      return;
+    }
+  }
+}
+
+static void log_store(const char *line, size_t text_len) {
+  uint32_t len = (LOG_HDR_SIZE + text_len + LOG_ALIGN - 1) & ~(LOG_ALIGN - 1);
+  uint32_t pos;
+  if (!log_reserve(len, &pos)) {
+    atomic_fetch_add_explicit(&s_log_dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  log_hdr_t *hdr = log_hdr_claim(pos);
+  hdr->len = len;
+  hdr->text_len = text_len;
+  hdr->ts_ms = esp_log_timestamp();
+  hdr->core = xPortGetCoreID();
+  log_parse(line, text_len, hdr);
+  memcpy((uint8_t *)hdr + LOG_HDR_SIZE, line, text_len);
+  atomic_store_explicit(&hdr->pos, pos, memory_order_release);
+  atomic_fetch_add_explicit(&s_log_lines, 1, memory_order_relaxed);
+}
+
+void app_log_deferred(esp_log_level_t level, const char *tag,
+                      const char *fmt, int nargs, ...) {
+  // The runtime level filter ESP_LOG applies, tag rules included
+  if (level > esp_log_level_get(tag) || !log_tag_admit(tag, level))
+    return;
+  if (nargs > APP_LOGB_MAX_ARGS)
+    nargs = APP_LOGB_MAX_ARGS;
+  uint32_t text_len = sizeof(log_deferred_t) + nargs * sizeof(uint32_t);
+  uint32_t len = (LOG_HDR_SIZE + text_len + LOG_ALIGN - 1) & ~(LOG_ALIGN - 1);
+  uint32_t pos;
+  if (!log_reserve(len, &pos)) {
+    atomic_fetch_add_explicit(&s_log_dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  log_hdr_t *hdr = log_hdr_claim(pos);
+  hdr->len = len;
+  hdr->text_len = text_len;
+  hdr->ts_ms = esp_log_timestamp();
+  hdr->level = level | LOG_REC_DEFERRED;
+  hdr->core = xPortGetCoreID();
+  hdr->tag_off = 0;
+  hdr->tag_len = 0;
+  log_deferred_t *d = (log_deferred_t *)((uint8_t *)hdr + LOG_HDR_SIZE);
+  d->fmt = fmt;
+  d->tag = tag;
+  va_list ap;
+  va_start(ap, nargs);
+  for (int i = 0; i < nargs; i++)
+    d->args[i] = va_arg(ap, uint32_t);
+  va_end(ap);
+  atomic_store_explicit(&hdr->pos, pos, memory_order_release);
+  atomic_fetch_add_explicit(&s_log_lines, 1, memory_order_relaxed);
+}
+
+// Render a deferred record the way ESP_LOG would have. Returns 0 if the
+// record was retired while its payload was being copied.
+static size_t log_format_deferred(uint32_t rec, const log_hdr_t *hdr,
+                                  char *out, size_t cap) {
+  uint32_t ts_ms = hdr->ts_ms;
+  uint8_t level = hdr->level & ~LOG_REC_DEFERRED;
+  size_t nargs = (hdr->text_len - sizeof(log_deferred_t)) / sizeof(uint32_t);
+  union {
+    log_deferred_t d;
+    uint8_t raw[sizeof(log_deferred_t) + APP_LOGB_MAX_ARGS * sizeof(uint32_t)];
+  } p = {0};
+  if (nargs > APP_LOGB_MAX_ARGS)
+    nargs = APP_LOGB_MAX_ARGS;
+  memcpy(&p, (const uint8_t *)hdr + LOG_HDR_SIZE,
+         sizeof(log_deferred_t) + nargs * sizeof(uint32_t));
+  // Torn pointers must never reach snprintf
+  if (log_before(rec, atomic_load_explicit(&s_log_tail, memory_order_acquire)))
+    return 0;
+
+#if CONFIG_LOG_COLORS
+  // LOG_COLOR_D and LOG_COLOR_V are empty
+  static const char *const colors[] = {"",
+                                       LOG_COLOR_E,
+                                       LOG_COLOR_W,
+                                       LOG_COLOR_I,
+                                       "" LOG_COLOR_D,
+                                       "" LOG_COLOR_V};
+  const char *color = level < 6 ? colors[level] : "";
+  const char *reset = color[0] ? LOG_RESET_COLOR : "";
+#else
+  const char *color = "";
+  const char *reset = "";
+#endif
+  char letter = (level >= ESP_LOG_ERROR && level <= ESP_LOG_VERBOSE)
+                    ? "EWIDV"[level - ESP_LOG_ERROR]
+                    : '?';
+
+  // Format and tag point into the image that wrote the record, and a ring
+  // left by a crash may hold anything: only flash rodata is dereferenced
+  const char *bad = NULL;
+  if (s_log_foreign)
+    bad = "deferred line of the previous firmware";
+  else if (!esp_ptr_in_drom(p.d.fmt) || !esp_ptr_in_drom(p.d.tag))
+    bad = "deferred line with a corrupt format";
+  if (bad) {
+    int r = snprintf(out, cap, "%s%c (%" PRIu32 ") [%s]%s\n", color, letter,
+                     ts_ms, bad, reset);
+    return r < 0 ? 0 : ((size_t)r < cap ? (size_t)r : cap - 1);
+  }
+
+  // Missing arguments read as 0; every argument is one word
+  const uint32_t *a = p.d.args;
+  size_t n = 0;
+  int r = snprintf(out, cap, "%s%c (%" PRIu32 ") %s: ", color, letter, ts_ms,
+                   p.d.tag);
+  if (r > 0)
+    n += (size_t)r < cap ? (size_t)r : cap - 1;
+  r = snprintf(out + n, cap - n, p.d.fmt, a[0], a[1], a[2], a[3], a[4], a[5],
+               a[6], a[7]);
+  if (r > 0)
+    n += (size_t)r < cap - n ? (size_t)r : cap - n - 1;
+  r = snprintf(out + n, cap - n, "%s\n", reset);
+  if (r > 0)
+    n += (size_t)r < cap - n ? (size_t)r : cap - n - 1;
+  if (n == cap - 1)
+    out[n - 1] = '\n';
+  return n;
+}
+
+static int log_console(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int ret = s_prev_vprintf ? s_prev_vprintf(fmt, ap) : vprintf(fmt, ap);
+  va_end(ap);
   return ret;
 }
 
-void app_log_init(void) {
-  if (!s_log_mutex) {
-    s_log_mutex = xSemaphoreCreateMutex();
-    s_prev_vprintf = esp_log_set_vprintf(app_log_vprintf);
+static int app_log_vprintf(const char *fmt, va_list ap) {
+  // Tag rules decide before anything is formatted
+  esp_log_level_t level;
+  const char *tag = log_tag_from_fmt(fmt, ap, &level);
+  if (tag && !log_tag_admit(tag, level))
+    return 0;
+
+  // Format once; the console gets the finished line
+  char line[LOG_LINE_MAX];
+  va_list copy;
+  va_copy(copy, ap);
+  int len = vsnprintf(line, sizeof(line), fmt, copy);
+  va_end(copy);
+  if (len <= 0)
+    return len;
+
+  int ret;
+  if (len >= (int)sizeof(line)) {
+    // Only the ring copy is cut short; the console still gets all of it
+    ret = s_prev_vprintf ? s_prev_vprintf(fmt, ap) : vprintf(fmt, ap);
+    len = sizeof(line) - 1;
+    line[len - 1] = '\n'; // Keep lines separated in the ring
+    atomic_fetch_add_explicit(&s_log_truncated, 1, memory_order_relaxed);
+  } else {
+    ret = log_console("%.*s", len, line);
   }
+
+  log_store(line, len);
+  return ret;
 }
 
-int app_log_get_buffer(char *dest, size_t max_len) {
-  int total_len = 0;
-  if (s_log_mutex &&
-      xSemaphoreTake(s_log_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-    if (!s_log_wrapped) {
-      size_t copy_len = (s_log_head < max_len) ? s_log_head : max_len - 1;
-      memcpy(dest, s_log_buffer, copy_len);
-      dest[copy_len] = 0;
-      total_len = copy_len;
-    } else {
-      // Buffer wrapped: Read from head to end, then 0 to head
-      // To simplify display, we just linearize the ring buffer into dest
-      // Start from s_log_head (oldest data) to end
-      size_t part1_len = LOG_BUFFER_SIZE - s_log_head;
-      size_t part2_len = s_log_head;
-
-      size_t copied = 0;
-
-      // Copy part 1
-      if (part1_len > 0 && copied < max_len - 1) {
-        size_t to_copy = (part1_len < (max_len - 1 - copied))
-                             ? part1_len
-                             : (max_len - 1 - copied);
-        memcpy(dest + copied, s_log_buffer + s_log_head, to_copy);
-        copied += to_copy;
-      }
+static uint32_t app_log_oldest(void) {
+  uint32_t tail = atomic_load_explicit(&s_log_tail, memory_order_acquire);
+  uint32_t base = atomic_load_explicit(&s_log_base, memory_order_relaxed);
+  return log_before(tail, base) ? base : tail;
+}
+
+// Copy the text of the records between cursor and end. Text records may be
+// split across reads; deferred records are formatted here and copied whole
+// (or truncated when dest cannot hold even one line). With deferred_only,
+// text records are passed over.
+static size_t log_read(uint64_t cursor, uint64_t end, bool deferred_only,
+                       char *dest, size_t max_len, uint64_t *next,
+                       uint64_t *dropped) {
+  uint32_t head = atomic_load_explicit(&s_log_head, memory_order_acquire);
+  uint32_t stop = (end < head) ? (uint32_t)end : head;
+  uint32_t oldest = app_log_oldest();
+  uint32_t cur = (uint32_t)cursor;
+  uint64_t skipped = 0;
+  size_t copied = 0;
 
-      // Copy part 2
-      if (part2_len > 0 && copied < max_len - 1) {
-        size_t to_copy = (part2_len < (max_len - 1 - copied))
-                             ? part2_len
-                             : (max_len - 1 - copied);
-        memcpy(dest + copied, s_log_buffer, to_copy);
-        copied += to_copy;
+  if (cursor > head) {
+    // Cursor from before a reboot: restart from the oldest record
+    cur = oldest;
+  } else if (log_before(cur, oldest)) {
+    skipped = oldest - cur;
+    cur = oldest;
+  }
+
+  uint32_t rec = oldest;
+  while (dest && copied < max_len && log_before(rec, stop)) {
+    uint32_t room = log_room(rec);
+    if (room < LOG_HDR_SIZE) {
+      rec += room;
+      if (log_before(cur, rec))
+        cur = rec;
+      continue;
+    }
+
+    const log_hdr_t *hdr = log_hdr_at(rec);
+    if (!log_hdr_valid(hdr, rec))
+      break; // Still being written
+    uint32_t rec_end = rec + hdr->len;
+    uint32_t text = rec + LOG_HDR_SIZE;
+    uint32_t text_end = text + hdr->text_len;
+    bool deferred = hdr->level & LOG_REC_DEFERRED;
+
+    if (!log_before(cur, text_end) || (deferred && log_before(text, cur)) ||
+        (deferred_only && !deferred)) {
+      // Already read, or not wanted
+      if (log_before(cur, rec_end))
+        cur = rec_end;
+    } else if (deferred) {
+      char line[LOG_LINE_MAX];
+      size_t n = log_format_deferred(rec, hdr, line, sizeof(line));
+      if (n == 0)
+        break; // Retired: the next read reports it as dropped
+      if (n > max_len - copied) {
+        if (copied > 0)
+          break;
+        n = max_len;
       }
-      dest[copied] = 0;
-      total_len = copied;
+      memcpy(dest + copied, line, n);
+      copied += n;
+      cur = rec_end;
+    } else {
+      uint32_t from = log_before(cur, text) ? text : cur;
+      size_t n = text_end - from;
+      if (n > max_len - copied)
+        n = max_len - copied;
+      memcpy(dest + copied, &s_log_buffer[from % LOG_BUFFER_SIZE], n);
+      // Retired while copying: the bytes may be torn, so leave them for the
+      // next read to report as dropped
+      if (log_before(rec, atomic_load_explicit(&s_log_tail,
+                                               memory_order_acquire)))
+        break;
+      copied += n;
+      cur = (from + n == text_end) ? rec_end : from + n;
     }
-    xSemaphoreGive(s_log_mutex);
+    rec = rec_end;
   }
-  return total_len;
+
+  if (next)
+    *next = cur;
+  if (dropped)
+    *dropped = skipped;
+  return copied;
 }
 
-void app_log_clear(void) {
-  if (s_log_mutex &&
-      xSemaphoreTake(s_log_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-    s_log_head = 0;
-    s_log_wrapped = false;
-    memset(s_log_buffer, 0, LOG_BUFFER_SIZE);
-    xSemaphoreGive(s_log_mutex);
+size_t app_log_read_since(uint64_t cursor, char *dest, size_t max_len,
+                          uint64_t *next, uint64_t *dropped) {
+  return log_read(cursor, UINT64_MAX, false, dest, max_len, next, dropped);
+}
+
+size_t app_log_read_until(uint64_t cursor, uint64_t end, char *dest,
+                          size_t max_len, uint64_t *next, uint64_t *dropped) {
+  return log_read(cursor, end, false, dest, max_len, next, dropped);
+}
+
+#if CONFIG_APP_LOG_DEFERRED
+// Deferred lines reach the console from here, formatted off the hot path
+static void app_log_drain_task(void *arg) {
+  uint64_t cursor = app_log_get_cursor();
+  char buf[512];
+  while (1) {
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_APP_LOG_DRAIN_MS));
+    uint64_t dropped;
+    size_t len;
+    do {
+      len = log_read(cursor, UINT64_MAX, true, buf, sizeof(buf), &cursor,
+                     &dropped);
+      if (dropped > 0)
+        log_console("[... log overwritten before the console drained it]\n");
+      if (len > 0)
+        log_console("%.*s", (int)len, buf);
+    } while (len > 0);
+  }
+}
+#endif
+
+// The ring survived the reset if its magic is set and its positions make
+// sense; a power-on leaves RAM random
+static bool log_ring_retained(esp_reset_reason_t reason) {
+  if (reason == ESP_RST_POWERON || s_log_magic != LOG_RING_MAGIC)
+    return false;
+  uint32_t head = atomic_load(&s_log_head);
+  uint32_t tail = atomic_load(&s_log_tail);
+  return head - tail <= LOG_BUFFER_SIZE && tail % LOG_ALIGN == 0 &&
+         head % LOG_ALIGN == 0;
+}
+
+// Write the retained ring as text into the "logs" partition. Runs before
+// the hook is installed, so nothing else touches the ring meanwhile.
+static void log_save_previous(esp_reset_reason_t reason) {
+  const esp_partition_t *part = s_saved_part;
+  const esp_app_desc_t *app = esp_app_get_description();
+  s_log_foreign =
+      memcmp(s_log_image, app->app_elf_sha256, sizeof(s_log_image)) != 0;
+
+  log_saved_hdr_t hdr = {.magic = LOG_SAVED_MAGIC, .reason = reason};
+  esp_err_t err = esp_partition_erase_range(part, 0, part->size);
+  uint64_t cursor = app_log_oldest();
+  char buf[512];
+  while (err == ESP_OK) {
+    size_t room = part->size - sizeof(hdr) - hdr.len;
+    size_t len = log_read(cursor, UINT64_MAX, false, buf,
+                          room < sizeof(buf) ? room : sizeof(buf), &cursor,
+                          NULL);
+    if (len == 0)
+      break;
+    err = esp_partition_write(part, sizeof(hdr) + hdr.len, buf, len);
+    hdr.crc = esp_rom_crc32_le(hdr.crc, (const uint8_t *)buf, len);
+    hdr.len += len;
+  }
+  if (err == ESP_OK)
+    err = esp_partition_write(part, 0, &hdr, sizeof(hdr));
+  s_log_foreign = false;
+  if (err == ESP_OK)
+    s_saved_hdr = hdr;
+}
+
+// Load the header of the saved log, dropping it if the text does not match
+static void log_load_saved(void) {
+  log_saved_hdr_t hdr;
+  if (esp_partition_read(s_saved_part, 0, &hdr, sizeof(hdr)) != ESP_OK ||
+      hdr.magic != LOG_SAVED_MAGIC ||
+      hdr.len > s_saved_part->size - sizeof(hdr))
+    return;
+
+  uint32_t crc = 0;
+  char buf[256];
+  for (uint32_t off = 0; off < hdr.len; off += sizeof(buf)) {
+    size_t n = hdr.len - off < sizeof(buf) ? hdr.len - off : sizeof(buf);
+    if (esp_partition_read(s_saved_part, sizeof(hdr) + off, buf, n) != ESP_OK)
+      return;
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)buf, n);
   }
+  if (crc == hdr.crc)
+    s_saved_hdr = hdr;
+}
+
+void app_log_init(void) {
+  if (s_prev_vprintf)
+    return;
+
+  esp_reset_reason_t reason = esp_reset_reason();
+  s_saved_part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, LOG_SAVED_PARTITION);
+  if (s_saved_part && log_ring_retained(reason)) {
+    // Cleared first: should the replay fault, the next boot skips it
+    // instead of faulting again
+    s_log_magic = 0;
+    log_save_previous(reason);
+  } else if (s_saved_part) {
+    log_load_saved(); // Keep what an earlier boot saved
+  }
+
+  // Start this boot's ring
+  const esp_app_desc_t *app = esp_app_get_description();
+  memcpy(s_log_image, app->app_elf_sha256, sizeof(s_log_image));
+  atomic_store(&s_log_head, 0);
+  atomic_store(&s_log_tail, 0);
+  atomic_store(&s_log_base, 0);
+  s_log_magic = LOG_RING_MAGIC;
+
+  s_prev_vprintf = esp_log_set_vprintf(app_log_vprintf);
+#if CONFIG_APP_LOG_DEFERRED
+  xTaskCreate(app_log_drain_task, "log_drain", LOG_DRAIN_STACK, NULL, 1, NULL);
+#endif
+}
+
+uint64_t app_log_get_cursor(void) {
+  // End of the committed lines, so a reader that stops here skips nothing
+  uint32_t head = atomic_load_explicit(&s_log_head, memory_order_acquire);
+  uint32_t rec = app_log_oldest();
+  while (log_before(rec, head)) {
+    if (log_room(rec) < LOG_HDR_SIZE) {
+      rec += log_room(rec);
+      continue;
+    }
+    const log_hdr_t *hdr = log_hdr_at(rec);
+    if (!log_hdr_valid(hdr, rec))
+      break;
+    rec += hdr->len;
+  }
+  return rec;
+}
+
+int app_log_get_buffer(char *dest, size_t max_len) {
+  if (!dest || max_len == 0)
+    return 0;
+
+  // Cursor 0 always starts at the oldest retained byte
+  size_t len = app_log_read_since(0, dest, max_len - 1, NULL, NULL);
+  dest[len] = 0;
+  return len;
+}
+
+void app_log_clear(void) {
+  // Positions stay monotonic so existing cursors remain valid
+  atomic_store(&s_log_base, atomic_load(&s_log_head));
+}
+
+void app_log_get_stats(app_log_stats_t *out) {
+  out->lines = atomic_load_explicit(&s_log_lines, memory_order_relaxed);
+  out->dropped = atomic_load_explicit(&s_log_dropped, memory_order_relaxed);
+  out->truncated =
+      atomic_load_explicit(&s_log_truncated, memory_order_relaxed);
+  out->suppressed = log_tag_suppressed();
+}
+
+esp_err_t app_log_get_previous(app_log_previous_t *out) {
+  if (s_saved_hdr.magic != LOG_SAVED_MAGIC)
+    return ESP_ERR_NOT_FOUND;
+  out->reason = (esp_reset_reason_t)s_saved_hdr.reason;
+  out->len = s_saved_hdr.len;
+  return ESP_OK;
+}
+
+size_t app_log_read_previous(size_t offset, char *dest, size_t max_len) {
+  if (s_saved_hdr.magic != LOG_SAVED_MAGIC || offset >= s_saved_hdr.len)
+    return 0;
+  size_t len = s_saved_hdr.len - offset;
+  if (len > max_len)
+    len = max_len;
+  if (esp_partition_read(s_saved_part, sizeof(log_saved_hdr_t) + offset, dest,
+                         len) != ESP_OK)
+    return 0;
+  return len;
 }
@@ -0,0 +1,301 @@
+#include "goku_log_tag.h"
+#include "freertos/FreeRTOS.h"
+#include "goku_log.h"
+#include "goku_settings.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#define LOG_TAG_NO_RULE 0
+
+// A rule packed into one word so the hook reads it consistently. The level
+// is stored plus one, so a zeroed slot has no rule.
+#define LOG_RULE(level, sample, per_min)                                       \
+  (((uint32_t)(level) + 1) | (uint32_t)(sample) << 8 |                        \
+   (uint32_t)(per_min) << 16)
+#define LOG_RULE_LEVEL(rule) (((rule) & 0xFF) - 1)
+#define LOG_RULE_SAMPLE(rule) (((rule) >> 8) & 0xFF)
+#define LOG_RULE_PER_MIN(rule) ((rule) >> 16)
+
+_Static_assert(APP_LOG_TAG_LEN == APP_SETTINGS_LOG_TAG_LEN,
+               "Tag length differs from the settings");
+
+// Slots are claimed in order and never released, so the hook can search
+// them without a lock. A slot names the tag by the pointer of the first
+// line that used it (tags are string literals, as esp_log's own cache
+// assumes) or, for a rule set before any such line, by its own copy.
+typedef struct {
+  _Atomic(const char *) name; // NULL while free
+  char copy[APP_LOG_TAG_LEN];
+  _Atomic uint32_t rule;      // LOG_RULE() or LOG_TAG_NO_RULE
+  _Atomic uint32_t seq;       // Lines considered for sampling
+  _Atomic uint32_t window;    // Minute since boot the count belongs to
+  _Atomic uint32_t in_window; // Lines sampled in during that minute
+  _Atomic uint32_t emitted;
+  _Atomic uint32_t suppressed;
+} log_tag_t;
+
+// Direct-mapped cache from a tag pointer to its slot, so a line usually
+// costs one pointer compare instead of a search of the table
+#define LOG_TAG_CACHE_BITS 6
+
+static log_tag_t s_tags[APP_LOG_TAGS_MAX];
+static _Atomic(log_tag_t *) s_cache[1 << LOG_TAG_CACHE_BITS];
+static _Atomic uint32_t s_suppressed = 0;
+// Taken by the setters and by the per-minute window of a rate limit
+static portMUX_TYPE s_tag_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Find the slot of tag, claiming a free one for it if claim is set. With
+// copy the slot refers to its own copy of the name, for tags that come
+// from a request rather than from code.
+static log_tag_t *log_tag_find(const char *tag, bool claim, bool copy) {
+  for (size_t i = 0; i < APP_LOG_TAGS_MAX; i++) {
+    log_tag_t *t = &s_tags[i];
+    const char *name = atomic_load_explicit(&t->name, memory_order_acquire);
+    if (!name) {
+      if (!claim)
+        return NULL;
+      const char *mine = tag;
+      if (copy) {
+        strlcpy(t->copy, tag, sizeof(t->copy));
+        mine = t->copy;
+      }
+      if (atomic_compare_exchange_strong(&t->name, &name, mine))
+        return t;
+      // Lost the slot: name is the winner's tag, which may be ours
+    }
+    if (name == tag || strcmp(name, tag) == 0)
+      return t;
+  }
+  return NULL;
+}
+
+static size_t log_tag_hash(const char *tag) {
+  return ((uint32_t)(uintptr_t)tag * 2654435761u) >>
+         (32 - LOG_TAG_CACHE_BITS);
+}
+
+// log_tag_find() for the hook. Entries are only hints: a slot's name never
+// changes once set, so a hit is confirmed against it, and a colliding tag
+// just replaces the entry.
+static log_tag_t *log_tag_lookup(const char *tag) {
+  _Atomic(log_tag_t *) *entry = &s_cache[log_tag_hash(tag)];
+  log_tag_t *t = atomic_load_explicit(entry, memory_order_acquire);
+  if (t) {
+    const char *name = atomic_load_explicit(&t->name, memory_order_relaxed);
+    if (name == tag || strcmp(name, tag) == 0)
+      return t;
+  }
+  t = log_tag_find(tag, true, false);
+  if (t)
+    atomic_store_explicit(entry, t, memory_order_release);
+  return t;
+}
+
+const char *log_tag_from_fmt(const char *fmt, va_list ap,
+                             esp_log_level_t *level) {
+  // LOG_FORMAT(): "[color]L (%" PRIu32 ") %s: ..." with the timestamp and
+  // tag as the first two arguments, or " (%s) " for the system time
+  static const char levels[] = "EWIDV";
+  if (fmt[0] == '\033') {
+    fmt = strchr(fmt, 'm');
+    if (!fmt)
+      return NULL;
+    fmt++;
+  }
+  const char *lvl = fmt[0] ? strchr(levels, fmt[0]) : NULL;
+  if (!lvl || strncmp(fmt + 1, " (%", 3) != 0)
+    return NULL;
+  const char *close = strchr(fmt + 4, ')');
+  if (!close || strncmp(close, ") %s: ", 6) != 0)
+    return NULL;
+
+  va_list copy;
+  va_copy(copy, ap);
+  if (close[-1] == 's')
+    (void)va_arg(copy, const char *);
+  else
+    (void)va_arg(copy, uint32_t);
+  const char *tag = va_arg(copy, const char *);
+  va_end(copy);
+  *level = ESP_LOG_ERROR + (lvl - levels);
+  return tag;
+}
+
+// Every sample-th line passes, then at most per_min of those in each
+// minute since boot. Errors are never held back.
+static bool log_tag_keep(log_tag_t *t, uint32_t rule, esp_log_level_t level) {
+  if (level <= ESP_LOG_ERROR)
+    return true;
+
+  uint32_t sample = LOG_RULE_SAMPLE(rule);
+  if (sample > 1 &&
+      atomic_fetch_add_explicit(&t->seq, 1, memory_order_relaxed) % sample)
+    return false;
+
+  uint32_t per_min = LOG_RULE_PER_MIN(rule);
+  if (per_min == 0)
+    return true;
+  // Reset and count together, or two cores could each open the new minute
+  uint32_t minute = esp_log_timestamp() / 60000;
+  taskENTER_CRITICAL(&s_tag_lock);
+  if (atomic_load_explicit(&t->window, memory_order_relaxed) != minute) {
+    atomic_store_explicit(&t->window, minute, memory_order_relaxed);
+    atomic_store_explicit(&t->in_window, 0, memory_order_relaxed);
+  }
+  uint32_t count = atomic_load_explicit(&t->in_window, memory_order_relaxed);
+  bool keep = count < per_min;
+  if (keep)
+    atomic_store_explicit(&t->in_window, count + 1, memory_order_relaxed);
+  taskEXIT_CRITICAL(&s_tag_lock);
+  return keep;
+}
+
+bool log_tag_admit(const char *tag, esp_log_level_t level) {
+  log_tag_t *t = log_tag_lookup(tag);
+  if (!t)
+    return true; // Table full: untracked tags always pass
+
+  uint32_t rule = atomic_load_explicit(&t->rule, memory_order_relaxed);
+  if (rule != LOG_TAG_NO_RULE) {
+    // The rule's level reaches both ESP_LOG and deferred lines through
+    // esp_log_level_set(); only sampling and limits are left
+    if (!log_tag_keep(t, rule, level)) {
+      atomic_fetch_add_explicit(&t->suppressed, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&s_suppressed, 1, memory_order_relaxed);
+      return false;
+    }
+  }
+  atomic_fetch_add_explicit(&t->emitted, 1, memory_order_relaxed);
+  return true;
+}
+
+uint32_t log_tag_suppressed(void) {
+  return atomic_load_explicit(&s_suppressed, memory_order_relaxed);
+}
+
+// Install a rule in the runtime table and in esp_log's level filter. The
+// rule it replaced goes to prev, for rolling back.
+static esp_err_t log_tag_apply(const char *tag, uint32_t rule,
+                               uint32_t *prev) {
+  taskENTER_CRITICAL(&s_tag_lock);
+  log_tag_t *t = log_tag_find(tag, rule != LOG_TAG_NO_RULE, true);
+  uint32_t old = LOG_TAG_NO_RULE;
+  if (t)
+    old = atomic_exchange_explicit(&t->rule, rule, memory_order_relaxed);
+  taskEXIT_CRITICAL(&s_tag_lock);
+  if (prev)
+    *prev = old;
+  if (!t && rule != LOG_TAG_NO_RULE)
+    return ESP_ERR_NO_MEM;
+
+  esp_log_level_set(tag, rule == LOG_TAG_NO_RULE ? CONFIG_LOG_DEFAULT_LEVEL
+                                                 : LOG_RULE_LEVEL(rule));
+  return ESP_OK;
+}
+
+// Store or remove the rule for tag in the settings snapshot
+static esp_err_t log_tag_persist(const char *tag, const uint32_t *rule) {
+  app_settings_t s;
+  app_settings_get(&s);
+
+  app_settings_log_tag_t *slot = NULL;
+  for (size_t i = 0; i < APP_SETTINGS_LOG_TAGS; i++) {
+    app_settings_log_tag_t *e = &s.log.tags[i];
+    if (strncmp(e->tag, tag, sizeof(e->tag)) == 0) {
+      slot = e;
+      break;
+    }
+    if (!slot && !e->tag[0])
+      slot = e;
+  }
+  if (!slot)
+    return rule ? ESP_ERR_NO_MEM : ESP_OK;
+
+  app_settings_log_tag_t old = *slot;
+  memset(slot, 0, sizeof(*slot));
+  if (rule) {
+    strlcpy(slot->tag, tag, sizeof(slot->tag));
+    slot->level = LOG_RULE_LEVEL(*rule);
+    slot->sample = LOG_RULE_SAMPLE(*rule);
+    slot->per_min = LOG_RULE_PER_MIN(*rule);
+  }
+  app_settings_set_log(&s.log);
+  esp_err_t err = app_settings_commit();
+  if (err != ESP_OK) {
+    // Leave the snapshot as it was rather than retry this rule later
+    *slot = old;
+    app_settings_set_log(&s.log);
+  }
+  return err;
+}
+
+esp_err_t app_log_tags_init(void) {
+  app_settings_t s;
+  app_settings_get(&s);
+  esp_err_t ret = ESP_OK;
+  for (size_t i = 0; i < APP_SETTINGS_LOG_TAGS; i++) {
+    const app_settings_log_tag_t *e = &s.log.tags[i];
+    if (!e->tag[0] || !memchr(e->tag, 0, sizeof(e->tag)) ||
+        e->level > ESP_LOG_VERBOSE)
+      continue;
+    esp_err_t err = log_tag_apply(
+        e->tag, LOG_RULE(e->level, e->sample, e->per_min), NULL);
+    if (err != ESP_OK)
+      ret = err;
+  }
+  return ret;
+}
+
+esp_err_t app_log_set_tag(const char *tag, esp_log_level_t level,
+                          uint8_t sample, uint16_t per_min) {
+  if (!tag || !tag[0] || strlen(tag) >= APP_LOG_TAG_LEN ||
+      level > ESP_LOG_VERBOSE)
+    return ESP_ERR_INVALID_ARG;
+
+  // A rule that cannot be stored is not kept running either
+  uint32_t rule = LOG_RULE(level, sample, per_min);
+  uint32_t prev;
+  esp_err_t err = log_tag_apply(tag, rule, &prev);
+  if (err != ESP_OK)
+    return err;
+  err = log_tag_persist(tag, &rule);
+  if (err != ESP_OK)
+    log_tag_apply(tag, prev, NULL);
+  return err;
+}
+
+esp_err_t app_log_reset_tag(const char *tag) {
+  if (!tag || !tag[0] || strlen(tag) >= APP_LOG_TAG_LEN)
+    return ESP_ERR_INVALID_ARG;
+
+  uint32_t prev;
+  esp_err_t err = log_tag_apply(tag, LOG_TAG_NO_RULE, &prev);
+  if (err != ESP_OK)
+    return err;
+  err = log_tag_persist(tag, NULL);
+  if (err != ESP_OK)
+    log_tag_apply(tag, prev, NULL);
+  return err;
+}
+
+size_t app_log_get_tags(app_log_tag_info_t *out, size_t max) {
+  size_t n = 0;
+  for (size_t i = 0; i < APP_LOG_TAGS_MAX && n < max; i++) {
+    log_tag_t *t = &s_tags[i];
+    const char *name = atomic_load_explicit(&t->name, memory_order_acquire);
+    if (!name)
+      break;
+    uint32_t rule = atomic_load_explicit(&t->rule, memory_order_relaxed);
+    app_log_tag_info_t *info = &out[n++];
+    strlcpy(info->tag, name, sizeof(info->tag));
+    info->rule = rule != LOG_TAG_NO_RULE;
+    info->level = info->rule ? (esp_log_level_t)LOG_RULE_LEVEL(rule)
+                             : (esp_log_level_t)CONFIG_LOG_DEFAULT_LEVEL;
+    info->sample = info->rule ? LOG_RULE_SAMPLE(rule) : 0;
+    info->per_min = info->rule ? LOG_RULE_PER_MIN(rule) : 0;
+    info->emitted = atomic_load_explicit(&t->emitted, memory_order_relaxed);
+    info->suppressed =
+        atomic_load_explicit(&t->suppressed, memory_order_relaxed);
+  }
+  return n;
+}
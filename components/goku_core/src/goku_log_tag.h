@@ -0,0 +1,34 @@
+/**
+ * @file goku_log_tag.h
+ * @brief Per-tag sampling and rate limits for the log hook (internal)
+ */
+
+#pragma once
+
+#include "esp_log.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Find the tag and level of an ESP_LOG line without formatting it
+ *
+ * @param fmt Format passed to the vprintf hook
+ * @param ap Its arguments; left untouched
+ * @param[out] level Level letter of the line
+ * @return Tag, or NULL if fmt is not an ESP_LOG line
+ */
+const char *log_tag_from_fmt(const char *fmt, va_list ap,
+                             esp_log_level_t *level);
+
+/**
+ * @brief Count a line of tag and decide whether it is kept
+ *
+ * @return false if the tag's rule suppresses the line
+ */
+bool log_tag_admit(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Lines suppressed by tag rules since boot, all tags together
+ */
+uint32_t log_tag_suppressed(void);
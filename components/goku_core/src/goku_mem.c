@@ -1,8 +1,10 @@
 #include "goku_mem.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_memory_utils.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <string.h>
 
 #define TAG "goku_mem"
 
@@ -10,6 +12,27 @@
 #define INTERNAL_HEAP_CRITICAL_THRESHOLD (20 * 1024) // 20KB
 #define PSRAM_CRITICAL_THRESHOLD (100 * 1024)        // 100KB
 
+#define MEM_MAGIC 0x6B6D // Marks a live tagged block
+
+// Bookkeeping in front of every tagged block; 8 bytes keep the caller's
+// pointer as aligned as the heap's
+typedef struct {
+  uint32_t size;
+  uint16_t magic;
+  uint8_t tag;
+  uint8_t cls;
+} mem_hdr_t;
+
+_Static_assert(sizeof(mem_hdr_t) == 8, "Header must keep 8-byte alignment");
+
+static const char *const s_tag_names[APP_MEM_TAG_COUNT] = {"ir", "web",
+                                                           "data"};
+static const char *const s_class_names[APP_MEM_CLASS_COUNT] = {
+    "internal", "psram", "dma", "total"};
+
+static app_mem_usage_t s_usage[APP_MEM_TAG_COUNT][APP_MEM_CLASS_COUNT];
+static portMUX_TYPE s_usage_lock = portMUX_INITIALIZER_UNLOCKED;
+
 static void app_mem_task(void *pvParameters) {
   while (1) {
     size_t free_internal =
@@ -89,3 +112,107 @@ bool app_mem_is_safe(size_t size, bool use_psram) {
   }
   return true;
 }
+
+// Class a request is charged to when it fails, or where a block landed
+static app_mem_class_t mem_class(const void *ptr, uint32_t caps) {
+  if (ptr ? esp_ptr_external_ram(ptr) : (caps & MALLOC_CAP_SPIRAM))
+    return APP_MEM_CLASS_PSRAM;
+  return (caps & MALLOC_CAP_DMA) ? APP_MEM_CLASS_DMA : APP_MEM_CLASS_INTERNAL;
+}
+
+static void mem_account_alloc(app_mem_usage_t *u, size_t size) {
+  u->bytes += size;
+  if (u->bytes > u->peak)
+    u->peak = u->bytes;
+  u->live++;
+  u->allocs++;
+}
+
+static void *mem_alloc(app_mem_tag_t tag, size_t size, uint32_t caps,
+                       bool count_failure) {
+  if (tag >= APP_MEM_TAG_COUNT || size > UINT32_MAX - sizeof(mem_hdr_t))
+    return NULL;
+
+  mem_hdr_t *hdr = heap_caps_malloc(sizeof(mem_hdr_t) + size, caps);
+  app_mem_class_t cls = mem_class(hdr, caps);
+  if (!hdr) {
+    if (count_failure) {
+      taskENTER_CRITICAL(&s_usage_lock);
+      s_usage[tag][cls].failed++;
+      s_usage[tag][APP_MEM_CLASS_TOTAL].failed++;
+      taskEXIT_CRITICAL(&s_usage_lock);
+    }
+    return NULL;
+  }
+
+  *hdr = (mem_hdr_t){.size = size, .magic = MEM_MAGIC, .tag = tag, .cls = cls};
+  taskENTER_CRITICAL(&s_usage_lock);
+  mem_account_alloc(&s_usage[tag][cls], size);
+  mem_account_alloc(&s_usage[tag][APP_MEM_CLASS_TOTAL], size);
+  taskEXIT_CRITICAL(&s_usage_lock);
+  return hdr + 1;
+}
+
+void *app_mem_malloc(app_mem_tag_t tag, size_t size, uint32_t caps) {
+  return mem_alloc(tag, size, caps, true);
+}
+
+void *app_mem_malloc_prefer(app_mem_tag_t tag, size_t size, uint32_t caps,
+                            uint32_t fallback_caps) {
+  void *ptr = mem_alloc(tag, size, caps, false);
+  return ptr ? ptr : mem_alloc(tag, size, fallback_caps, true);
+}
+
+void *app_mem_calloc(app_mem_tag_t tag, size_t n, size_t size, uint32_t caps) {
+  if (size && n > SIZE_MAX / size)
+    return NULL;
+  void *ptr = mem_alloc(tag, n * size, caps, true);
+  if (ptr)
+    memset(ptr, 0, n * size);
+  return ptr;
+}
+
+void app_mem_free(void *ptr) {
+  if (!ptr)
+    return;
+
+  mem_hdr_t *hdr = (mem_hdr_t *)ptr - 1;
+  if (hdr->magic != MEM_MAGIC || hdr->tag >= APP_MEM_TAG_COUNT ||
+      hdr->cls >= APP_MEM_CLASS_TOTAL) {
+    // A plain heap block or a second free: leaking it is safer than
+    // handing the heap a pointer it may not own
+    ESP_LOGE(TAG, "Untagged or freed block %p passed to app_mem_free", ptr);
+    return;
+  }
+
+  taskENTER_CRITICAL(&s_usage_lock);
+  app_mem_usage_t *u = &s_usage[hdr->tag][hdr->cls];
+  app_mem_usage_t *total = &s_usage[hdr->tag][APP_MEM_CLASS_TOTAL];
+  u->bytes -= hdr->size;
+  u->live--;
+  total->bytes -= hdr->size;
+  total->live--;
+  taskEXIT_CRITICAL(&s_usage_lock);
+
+  hdr->magic = 0; // Catch a second free
+  heap_caps_free(hdr);
+}
+
+void app_mem_get_usage(app_mem_tag_t tag, app_mem_class_t cls,
+                       app_mem_usage_t *out) {
+  if (tag >= APP_MEM_TAG_COUNT || cls >= APP_MEM_CLASS_COUNT) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  taskENTER_CRITICAL(&s_usage_lock);
+  *out = s_usage[tag][cls];
+  taskEXIT_CRITICAL(&s_usage_lock);
+}
+
+const char *app_mem_tag_name(app_mem_tag_t tag) {
+  return tag < APP_MEM_TAG_COUNT ? s_tag_names[tag] : "unknown";
+}
+
+const char *app_mem_class_name(app_mem_class_t cls) {
+  return cls < APP_MEM_CLASS_COUNT ? s_class_names[cls] : "unknown";
+}
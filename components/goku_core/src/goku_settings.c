@@ -0,0 +1,312 @@
+#include "goku_settings.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "goku_settings"
+
+#define SETTINGS_NAMESPACE "settings"
+#define SETTINGS_KEY "snapshot"
+#define SETTINGS_MAGIC 0x54534B47 // "GKST"
+#define SETTINGS_VERSION 2
+
+// Pre-snapshot storage used by goku_led (imported once)
+#define LEGACY_NAMESPACE "storage"
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t length; // Payload bytes following the header
+  uint32_t crc;    // CRC32 of the payload
+} settings_header_t;
+
+typedef struct {
+  settings_header_t hdr;
+  app_settings_t data;
+} settings_blob_t;
+
+static app_settings_t s_settings;
+static app_settings_stats_t s_stats;
+static SemaphoreHandle_t s_settings_mutex = NULL;
+static bool s_loaded = false;
+
+static const app_settings_rgb_t s_default_state_colors[] = {
+    {0, 0, 0},  {0, 0, 0},  {0, 0, 20}, {0, 20, 20}, {10, 0, 10},
+    {20, 0, 0}, {20, 20, 0}, {20, 0, 0}, {0, 20, 0}, {0, 20, 0},
+};
+
+static void app_settings_lock(void) {
+  if (s_settings_mutex)
+    xSemaphoreTake(s_settings_mutex, portMAX_DELAY);
+}
+
+static void app_settings_unlock(void) {
+  if (s_settings_mutex)
+    xSemaphoreGive(s_settings_mutex);
+}
+
+static void app_settings_set_defaults(app_settings_t *s) {
+  memset(s, 0, sizeof(*s));
+
+  for (int i = 0; i < APP_SETTINGS_LED_EFFECT_COUNT; i++) {
+    s->led.effects[i].speed = 50;
+    for (int j = 0; j < APP_SETTINGS_LED_PIXELS; j++) {
+      s->led.effects[i].colors[j][1] = 20; // Dim green
+    }
+  }
+  memcpy(s->led.state_colors, s_default_state_colors,
+         sizeof(s->led.state_colors));
+  s->led.effect = 0; // Static
+  s->led.brightness = 100;
+
+  s->ac.valid = 0;
+  s->ac.temp = 24;
+  s->ac.mode = 1; // Cool
+
+  // The memory monitor reports every 10 s; one report a minute is plenty
+  strcpy(s->log.tags[0].tag, "goku_mem");
+  s->log.tags[0].level = ESP_LOG_INFO;
+  s->log.tags[0].sample = 6;
+}
+
+/**
+ * @brief Upgrade a snapshot loaded from an older schema version.
+ *
+ * The stored payload has already been copied over the defaults, so fields
+ * appended after @p from hold their defaults. Each step only needs to fix up
+ * values whose meaning changed.
+ */
+static void app_settings_migrate(app_settings_t *s, uint16_t from) {
+  switch (from) {
+  case 1:
+    // v2 appended the log section; its defaults need no fixing up
+  case SETTINGS_VERSION:
+  default:
+    break;
+  }
+}
+
+// Import the per-key LED settings written before the snapshot existed
+static bool app_settings_import_legacy(app_settings_t *s) {
+  nvs_handle_t handle;
+  if (nvs_open(LEGACY_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    return false;
+
+  bool found = false;
+  size_t size = sizeof(s->led.effects);
+  if (nvs_get_blob(handle, "led_configs_v2", s->led.effects, &size) ==
+      ESP_OK) {
+    found = true;
+  }
+
+  uint8_t val = 0;
+  if (nvs_get_u8(handle, "led_effect", &val) == ESP_OK) {
+    s->led.effect = (val < APP_SETTINGS_LED_EFFECT_COUNT) ? val : 0;
+    found = true;
+  }
+  if (nvs_get_u8(handle, "led_bright", &val) == ESP_OK) {
+    s->led.brightness = val;
+    found = true;
+  }
+
+  // Legacy keys are left in place so a rollback to older firmware still
+  // finds its settings.
+  nvs_close(handle);
+  return found;
+}
+
+static esp_err_t app_settings_load(app_settings_t *s, uint16_t *version) {
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open(SETTINGS_NAMESPACE, NVS_READONLY, &handle);
+  if (err != ESP_OK)
+    return err;
+
+  size_t size = 0;
+  err = nvs_get_blob(handle, SETTINGS_KEY, NULL, &size);
+  if (err != ESP_OK || size < sizeof(settings_header_t)) {
+    nvs_close(handle);
+    return (err == ESP_OK) ? ESP_ERR_INVALID_SIZE : err;
+  }
+
+  uint8_t *buf = malloc(size);
+  if (!buf) {
+    nvs_close(handle);
+    return ESP_ERR_NO_MEM;
+  }
+
+  err = nvs_get_blob(handle, SETTINGS_KEY, buf, &size);
+  nvs_close(handle);
+  if (err != ESP_OK) {
+    free(buf);
+    return err;
+  }
+
+  settings_header_t hdr;
+  memcpy(&hdr, buf, sizeof(hdr));
+  const uint8_t *payload = buf + sizeof(hdr);
+
+  if (hdr.magic != SETTINGS_MAGIC ||
+      hdr.length != size - sizeof(settings_header_t)) {
+    err = ESP_ERR_INVALID_SIZE;
+  } else if (esp_rom_crc32_le(0, payload, hdr.length) != hdr.crc) {
+    err = ESP_ERR_INVALID_CRC;
+  } else {
+    // Append-only schema: newer blobs are truncated, older ones keep the
+    // defaults for the fields they lack.
+    size_t copy = hdr.length < sizeof(*s) ? hdr.length : sizeof(*s);
+    memcpy(s, payload, copy);
+    *version = hdr.version;
+    err = ESP_OK;
+  }
+
+  free(buf);
+  return err;
+}
+
+esp_err_t app_settings_init(void) {
+  if (!s_settings_mutex) {
+    s_settings_mutex = xSemaphoreCreateMutex();
+    if (!s_settings_mutex)
+      return ESP_ERR_NO_MEM;
+  }
+
+  app_settings_t loaded;
+  app_settings_set_defaults(&loaded);
+
+  uint16_t version = 0;
+  bool rewrite = false; // Persist migrated, imported or repaired data
+  esp_err_t err = app_settings_load(&loaded, &version);
+  if (err == ESP_OK) {
+    if (version < SETTINGS_VERSION) {
+      ESP_LOGI(TAG, "Migrating settings v%u -> v%u", version,
+               SETTINGS_VERSION);
+      app_settings_migrate(&loaded, version);
+      rewrite = true;
+    }
+  } else {
+    if (err != ESP_ERR_NVS_NOT_FOUND) {
+      ESP_LOGW(TAG, "Stored settings invalid (%s), using defaults",
+               esp_err_to_name(err));
+      rewrite = true;
+    }
+    version = 0;
+    app_settings_set_defaults(&loaded);
+    if (app_settings_import_legacy(&loaded)) {
+      ESP_LOGI(TAG, "Imported legacy LED settings");
+      rewrite = true;
+    }
+  }
+
+  app_settings_lock();
+  memcpy(&s_settings, &loaded, sizeof(s_settings));
+  s_stats.loaded_version = version;
+  s_stats.dirty = rewrite;
+  s_loaded = true;
+  app_settings_unlock();
+
+  ESP_LOGI(TAG, "Settings loaded (stored v%u, schema v%u)", version,
+           SETTINGS_VERSION);
+
+  return rewrite ? app_settings_commit() : ESP_OK;
+}
+
+void app_settings_get(app_settings_t *out) {
+  if (!out)
+    return;
+
+  app_settings_lock();
+  if (!s_loaded) {
+    app_settings_set_defaults(&s_settings);
+    s_loaded = true;
+  }
+  memcpy(out, &s_settings, sizeof(*out));
+  app_settings_unlock();
+}
+
+void app_settings_set_led(const app_settings_led_t *led) {
+  if (!led)
+    return;
+
+  app_settings_lock();
+  if (memcmp(&s_settings.led, led, sizeof(*led)) != 0) {
+    memcpy(&s_settings.led, led, sizeof(*led));
+    s_stats.dirty = true;
+  }
+  app_settings_unlock();
+}
+
+void app_settings_set_ac(const app_settings_ac_t *ac) {
+  if (!ac)
+    return;
+
+  app_settings_lock();
+  if (memcmp(&s_settings.ac, ac, sizeof(*ac)) != 0) {
+    memcpy(&s_settings.ac, ac, sizeof(*ac));
+    s_stats.dirty = true;
+  }
+  app_settings_unlock();
+}
+
+void app_settings_set_log(const app_settings_log_t *log) {
+  if (!log)
+    return;
+
+  app_settings_lock();
+  if (memcmp(&s_settings.log, log, sizeof(*log)) != 0) {
+    memcpy(&s_settings.log, log, sizeof(*log));
+    s_stats.dirty = true;
+  }
+  app_settings_unlock();
+}
+
+esp_err_t app_settings_commit(void) {
+  static settings_blob_t blob; // Guarded by the settings mutex
+
+  app_settings_lock();
+  if (!s_stats.dirty) {
+    app_settings_unlock();
+    return ESP_OK;
+  }
+
+  blob.hdr.magic = SETTINGS_MAGIC;
+  blob.hdr.version = SETTINGS_VERSION;
+  blob.hdr.length = sizeof(blob.data);
+  memcpy(&blob.data, &s_settings, sizeof(blob.data));
+  blob.hdr.crc =
+      esp_rom_crc32_le(0, (const uint8_t *)&blob.data, sizeof(blob.data));
+
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &handle);
+  if (err == ESP_OK) {
+    // A single blob write is atomic in NVS: after a brown-out either the
+    // previous or the new snapshot is readable, never a mix.
+    err = nvs_set_blob(handle, SETTINGS_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK)
+      err = nvs_commit(handle);
+    nvs_close(handle);
+  }
+
+  if (err == ESP_OK) {
+    s_stats.dirty = false;
+    s_stats.commits++;
+    s_stats.bytes_written += sizeof(blob);
+  } else {
+    s_stats.commit_errors++;
+    ESP_LOGE(TAG, "Settings commit failed: %s", esp_err_to_name(err));
+  }
+  app_settings_unlock();
+  return err;
+}
+
+void app_settings_get_stats(app_settings_stats_t *stats) {
+  if (!stats)
+    return;
+
+  app_settings_lock();
+  memcpy(stats, &s_stats, sizeof(*stats));
+  app_settings_unlock();
+}
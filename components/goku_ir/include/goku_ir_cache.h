@@ -0,0 +1,96 @@
+/**
+ * @file goku_ir_cache.h
+ * @brief Hot cache of decoded, transmit-ready IR symbol buffers
+ *
+ * Learned keys are stored palette-compressed in NVS. Decoding them on every
+ * send costs an NVS read plus two allocations, so frequently replayed keys
+ * are kept decoded (in PSRAM when available) and evicted LRU-first once the
+ * configured byte budget is exceeded.
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cache counters
+ */
+typedef struct {
+  uint32_t hits;          // Lookups served from the cache
+  uint32_t misses;        // Lookups that required NVS load + decode
+  uint32_t inserts;       // Buffers adopted by the cache
+  uint32_t evictions;     // Entries dropped to stay within budget
+  uint32_t invalidations; // Entries dropped because the key changed
+  uint32_t rejects;       // Buffers too large for the budget
+  size_t bytes_used;      // Bytes currently held
+  size_t budget;          // Configured budget in bytes
+  uint8_t entries;        // Entries currently held
+} app_ir_cache_stats_t;
+
+/**
+ * @brief Initialize the cache
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t app_ir_cache_init(void);
+
+/**
+ * @brief Look up a key and pin its buffer for transmission
+ *
+ * A successful lookup must be paired with app_ir_cache_release().
+ *
+ * @param key IR key name
+ * @param[out] symbols Decoded RMT symbol buffer
+ * @param[out] word_count Number of 32-bit RMT words in the buffer
+ * @return true on hit, false on miss
+ */
+bool app_ir_cache_acquire(const char *key, const void **symbols,
+                          size_t *word_count);
+
+/**
+ * @brief Offer a freshly decoded buffer to the cache
+ *
+ * On success the cache takes ownership of @p symbols and returns it pinned,
+ * as if app_ir_cache_acquire() had been called. On failure the caller keeps
+ * ownership and must free the buffer with app_mem_free().
+ *
+ * @param key IR key name
+ * @param symbols Buffer from app_mem_malloc() holding the decoded symbols
+ * @param word_count Number of 32-bit RMT words
+ * @param bytes Allocated size of the buffer
+ * @return true if the buffer was adopted
+ */
+bool app_ir_cache_insert(const char *key, void *symbols, size_t word_count,
+                         size_t bytes);
+
+/**
+ * @brief Unpin a buffer obtained from acquire/insert
+ *
+ * @param symbols Buffer returned by the cache
+ */
+void app_ir_cache_release(const void *symbols);
+
+/**
+ * @brief Drop a cached key
+ *
+ * @param key IR key name, or NULL to drop everything
+ */
+void app_ir_cache_invalidate(const char *key);
+
+/**
+ * @brief Get cache counters
+ *
+ * @param[out] stats Destination
+ */
+void app_ir_cache_get_stats(app_ir_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
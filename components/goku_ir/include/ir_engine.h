@@ -32,12 +32,29 @@ esp_err_t ir_engine_send_nec(uint16_t address, uint16_t command);
 /**
  * @brief Send raw RMT symbols
  *
+ * Waits for the frame to finish, giving up a little after its own length.
+ * The caller keeps ownership of symbols.
+ *
  * @param symbols Pointer to RMT symbols
  * @param count Number of symbols
- * @return esp_err_t ESP_OK on success
+ * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT if the frame did not
+ *         finish, or the RMT driver's error
  */
 esp_err_t ir_engine_send_raw(const void *symbols, size_t count);
 
+/**
+ * @brief Keep the transmitter for a sequence of frames
+ *
+ * Frames sent by other tasks wait until ir_engine_tx_release(); the holder
+ * can still send. Nests.
+ */
+void ir_engine_tx_hold(void);
+
+/**
+ * @brief End a sequence started with ir_engine_tx_hold()
+ */
+void ir_engine_tx_release(void);
+
 /**
  * @brief Send Daikin AC Command
  *
@@ -10,7 +10,7 @@ extern "C" {
 
 /**
  * @brief Generate RMT symbols for Daikin AC based on state.
- *        Caller must free the returned buffer.
+ *        Caller must free the returned buffer with app_mem_free().
  *
  * @param state AC State (Power, Mode, Temp, Fan, Swing)
  * @param[out] out_size Number of RMT words generated
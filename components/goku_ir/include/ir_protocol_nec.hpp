@@ -10,7 +10,7 @@ extern "C" {
 
 /**
  * @brief Generate RMT symbols for a NEC command.
- *        Caller must free the returned buffer.
+ *        Caller must free the returned buffer with app_mem_free().
  *
  * @param address 16-bit Address
  * @param command 16-bit Command
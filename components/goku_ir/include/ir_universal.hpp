@@ -16,8 +16,8 @@ extern "C" {
  * @param payload Pointer to the raw data bytes to send.
  * @param payload_len Length of the payload in bytes.
  * @param out_size [Out] Number of 32-bit RMT words generated.
- * @return rmt_symbol_word_t* Pointer to allocated buffer (Must be free() by
- * caller).
+ * @return rmt_symbol_word_t* Pointer to allocated buffer (Must be freed by
+ * caller with app_mem_free()).
  */
 rmt_symbol_word_t *
 ir_universal_generate_symbols(const ir_protocol_config_t *config,
@@ -7,11 +7,13 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "goku_data.h"
+#include "goku_log.h"
+#include "goku_ir_cache.h"
 #include "goku_led.h"
+#include "goku_mem.h"
 #include "sdkconfig.h"
 // #include "ir_encoder.h" // Removed external dependency
 #include "ir_engine.h"
-#include <esp_rom_sys.h> // For ets_printf
 #include <inttypes.h>
 #include <string.h>
 
@@ -26,7 +28,7 @@ static rmt_channel_handle_t s_rx_channel = NULL;
 // static rmt_encoder_handle_t s_ir_encoder = NULL;
 static esp_timer_handle_t s_restart_timer = NULL;
 
-#include "esp_heap_caps.h" // Added for heap_caps_malloc
+#include "esp_heap_caps.h" // MALLOC_CAP_*
 
 // Data storage
 #define MAX_IR_SYMBOLS 600 // Safe size for DMA (Max < 4095 bytes)
@@ -35,20 +37,21 @@ static esp_timer_handle_t s_restart_timer = NULL;
 static rmt_symbol_word_t *s_learning_symbols = NULL;
 static uint32_t s_learning_num_symbols = 0;
 static bool s_is_learning = false;
+// Symbols of the last capture, reported by the restart timer: the RX
+// callback runs in an ISR, where neither the UART nor the log ring may wait
+static volatile uint32_t s_rx_report = 0;
 
 // Forward declaration
 static void app_ir_restart_reception(void *arg);
+static void app_ir_on_data_change(const char *key);
 
 // --- Memory Helper ---
+// Free with app_mem_free()
 static void *app_ir_malloc(size_t size) {
-  // Try PSRAM first (if configured and available)
-  // MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT handles external RAM
-  void *ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (ptr == NULL) {
-    // Fallback to internal memory
-    ptr = malloc(size);
-  }
-  return ptr;
+  // Try PSRAM first (if configured and available), then internal memory
+  return app_mem_malloc_prefer(APP_MEM_TAG_IR, size,
+                               MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+                               MALLOC_CAP_DEFAULT);
 }
 
 // --- Palette-based Compression ---
@@ -113,7 +116,7 @@ static size_t app_ir_encode(const rmt_symbol_word_t *src, uint32_t count,
   }
 
   if (!success) {
-    free(indices);
+    app_mem_free(indices);
     return 0;
   }
 
@@ -122,7 +125,7 @@ static size_t app_ir_encode(const rmt_symbol_word_t *src, uint32_t count,
   size_t total_len = 1 + 4 + 1 + (palette_size * 2) + data_len;
 
   if (total_len > max_len) {
-    free(indices);
+    app_mem_free(indices);
     return 0; // Buffer too small
   }
 
@@ -148,7 +151,7 @@ static size_t app_ir_encode(const rmt_symbol_word_t *src, uint32_t count,
     }
   }
 
-  free(indices);
+  app_mem_free(indices);
   return total_len;
 }
 
@@ -223,8 +226,7 @@ static bool app_ir_rx_done_callback(rmt_channel_handle_t rx_chan,
                                     void *user_ctx) {
   if (s_is_learning) {
     if (edata->num_symbols < APP_IR_MIN_SYMBOLS) {
-      esp_rom_printf("IR Noise: %d symbols. Relearning...\n",
-                     (int)edata->num_symbols);
+      s_rx_report = edata->num_symbols;
       app_led_set_state(APP_LED_IR_FAIL);            // Set fail LED
       esp_timer_start_once(s_restart_timer, 500000); // 500ms delay
     } else {
@@ -236,9 +238,7 @@ static bool app_ir_rx_done_callback(rmt_channel_handle_t rx_chan,
       // No need to memcpy if s_learning_symbols was passed to rmt_receive
       // The driver writes directly to it.
 
-      esp_rom_printf("IR RX Valid! Symbols: %d\n", (int)s_learning_num_symbols);
-
-      // Removed verbose logging
+      s_rx_report = edata->num_symbols;
 
       // Auto-stop learning with success indication
       s_is_learning = false;
@@ -250,6 +250,13 @@ static bool app_ir_rx_done_callback(rmt_channel_handle_t rx_chan,
 }
 
 static void app_ir_restart_reception(void *arg) {
+  uint32_t report = s_rx_report;
+  s_rx_report = 0;
+  if (report >= APP_IR_MIN_SYMBOLS)
+    APP_LOGBI(TAG, "IR RX valid, %d symbols", (int)report);
+  else if (report > 0)
+    APP_LOGBW(TAG, "IR noise: %d symbols, relearning", (int)report);
+
   if (!s_is_learning) {
     app_led_set_state(APP_LED_IDLE);
     return;
@@ -275,8 +282,8 @@ esp_err_t app_ir_init(void) {
   // Alloc Learning Buffer
   // RMT driver requires internal RAM for receive buffer even with DMA on some
   // targets/versions
-  s_learning_symbols = (rmt_symbol_word_t *)heap_caps_malloc(
-      MAX_IR_SYMBOLS * sizeof(rmt_symbol_word_t),
+  s_learning_symbols = (rmt_symbol_word_t *)app_mem_malloc(
+      APP_MEM_TAG_IR, MAX_IR_SYMBOLS * sizeof(rmt_symbol_word_t),
       MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
   if (!s_learning_symbols) {
     ESP_LOGE(TAG, "Failed to alloc learning buffer");
@@ -329,6 +336,11 @@ esp_err_t app_ir_init(void) {
   };
   ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_restart_timer));
 
+  // 5. Decoded symbol cache, invalidated on NVS changes
+  if (app_ir_cache_init() == ESP_OK) {
+    app_data_set_ir_change_cb(app_ir_on_data_change);
+  }
+
   ESP_LOGI(TAG, "IR Initialized (Native RMT + Copy Encoder)");
   return ESP_OK;
 }
@@ -393,7 +405,7 @@ esp_err_t app_ir_save_learned_result(const char *key) {
 
   if (encoded_len == 0) {
     ESP_LOGE(TAG, "IR Encoding Failed");
-    free(buffer);
+    app_mem_free(buffer);
     return ESP_FAIL;
   }
 
@@ -411,14 +423,14 @@ esp_err_t app_ir_save_learned_result(const char *key) {
   }
   printf("\n");
 
-  free(buffer);
+  app_mem_free(buffer);
   return err;
 }
 
-esp_err_t app_ir_send_key(const char *key) {
-  // if (!s_tx_channel || !s_ir_encoder)
-  //   return ESP_ERR_INVALID_STATE;
-
+// Load a key from NVS and decode it into a transmit-ready symbol buffer
+static esp_err_t app_ir_load_symbols(const char *key,
+                                     rmt_symbol_word_t **out_symbols,
+                                     size_t *out_words, size_t *out_bytes) {
   size_t loaded_size = 0;
   // First, get the size
   if (app_data_load_ir(key, NULL, &loaded_size) != ESP_OK || loaded_size == 0) {
@@ -431,14 +443,14 @@ esp_err_t app_ir_send_key(const char *key) {
     return ESP_ERR_NO_MEM;
 
   if (app_data_load_ir(key, buffer, &loaded_size) != ESP_OK) {
-    free(buffer);
+    app_mem_free(buffer);
     return ESP_FAIL;
   }
 
   // Check Format
   if (buffer[0] != IR_DATA_MAGIC) {
     ESP_LOGE(TAG, "Invalid IR Data Format (Magic mismatch)");
-    free(buffer);
+    app_mem_free(buffer);
     return ESP_FAIL;
   }
 
@@ -457,43 +469,76 @@ esp_err_t app_ir_send_key(const char *key) {
       (rmt_symbol_word_t *)app_ir_malloc(alloc_size);
 
   if (!tx_symbols) {
-    free(buffer);
+    app_mem_free(buffer);
     return ESP_ERR_NO_MEM;
   }
 
+  // Zero the pad half-word of odd-length signals
+  if (num_symbols % 2 != 0)
+    ((uint16_t *)tx_symbols)[num_symbols] = 0;
+
   size_t decoded_count =
       app_ir_decode(buffer, loaded_size, tx_symbols, alloc_size);
+  app_mem_free(buffer);
   if (decoded_count != num_symbols) {
     ESP_LOGE(TAG, "IR Decode Mismatch (Exp: %" PRIu32 ", Got: %d)", num_symbols,
              (int)decoded_count);
-    free(buffer);
-    free(tx_symbols);
+    app_mem_free(tx_symbols);
     return ESP_FAIL;
   }
 
-  ESP_LOGI(TAG, "Sending %s (%" PRIu32 " symbols)...", key, num_symbols);
+  *out_symbols = tx_symbols;
+  // Convert 16-bit symbol count to 32-bit word count
+  *out_words = (num_symbols + 1) / 2;
+  *out_bytes = alloc_size;
+  return ESP_OK;
+}
+
+// Drop cached decodes whenever the stored key changes
+static void app_ir_on_data_change(const char *key) {
+  app_ir_cache_invalidate(key);
+}
+
+esp_err_t app_ir_send_key(const char *key) {
+  // if (!s_tx_channel || !s_ir_encoder)
+  //   return ESP_ERR_INVALID_STATE;
+
+  const void *tx_symbols = NULL;
+  size_t word_count = 0;
+  rmt_symbol_word_t *owned = NULL; // Set only if the cache did not adopt it
+  bool cached = app_ir_cache_acquire(key, &tx_symbols, &word_count);
+
+  if (!cached) {
+    rmt_symbol_word_t *decoded = NULL;
+    size_t alloc_size = 0;
+    esp_err_t err =
+        app_ir_load_symbols(key, &decoded, &word_count, &alloc_size);
+    if (err != ESP_OK)
+      return err;
+
+    cached = app_ir_cache_insert(key, decoded, word_count, alloc_size);
+    if (!cached)
+      owned = decoded;
+    tx_symbols = decoded;
+  }
+
+  ESP_LOGI(TAG, "Sending %s (%d words%s)...", key, (int)word_count,
+           cached ? ", cached" : "");
 
   app_led_set_state(APP_LED_IR_TX);
 
   // Use new Engine
-  // Convert 16-bit symbol count to 32-bit word count
-  size_t word_count = (num_symbols + 1) / 2;
   esp_err_t err = ir_engine_send_raw(tx_symbols, word_count);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "IR Send Failed: %s", esp_err_to_name(err));
   }
 
-  // rmt_transmit_config_t tx_config = {.loop_count = 0};
-  // ESP_ERROR_CHECK(
-  //     rmt_transmit(s_tx_channel, s_ir_encoder, tx_symbols,
-  //                  num_symbols * sizeof(uint16_t), // Pass BYTES of payload
-  //                  &tx_config));
-  // ESP_ERROR_CHECK(rmt_tx_wait_all_done(s_tx_channel, -1));
-
   app_led_set_state(APP_LED_IDLE);
-  free(tx_symbols);
-  free(buffer);
-  return ESP_OK;
+  if (cached)
+    app_ir_cache_release(tx_symbols);
+  else
+    app_mem_free(owned);
+  return err;
 }
 
 esp_err_t app_ir_send_raw(const uint16_t *durations, size_t count) {
@@ -503,7 +548,6 @@ esp_err_t app_ir_send_raw(const uint16_t *durations, size_t count) {
   if (count == 0 || durations == NULL)
     return ESP_ERR_INVALID_ARG;
 
-  // Allocate RMT symbols
   // Allocate RMT symbols
   size_t alloc_size = (count * sizeof(uint16_t));
   if (alloc_size % 4 != 0)
@@ -525,8 +569,10 @@ esp_err_t app_ir_send_raw(const uint16_t *durations, size_t count) {
     uint16_t duration = durations[i];
     tx_raw[i] = duration | (level << 15);
   }
+  if (count % 2 != 0)
+    tx_raw[count] = 0; // Padding half-word: zero duration ends the frame
 
-  ESP_LOGI(TAG, "Sending Raw IR Signal (%d pulses/spaces)...", (int)count);
+  APP_LOGBI(TAG, "Sending Raw IR Signal (%d pulses/spaces)...", (int)count);
   app_led_set_state(APP_LED_IR_TX);
 
   size_t word_count = (alloc_size / sizeof(rmt_symbol_word_t));
@@ -541,8 +587,8 @@ esp_err_t app_ir_send_raw(const uint16_t *durations, size_t count) {
   // ESP_ERROR_CHECK(rmt_tx_wait_all_done(s_tx_channel, -1));
 
   app_led_set_state(APP_LED_IDLE);
-  free(tx_symbols);
-  return ESP_OK;
+  app_mem_free(tx_symbols);
+  return err;
 }
 
 esp_err_t app_ir_send_cmd(app_ir_cmd_t cmd) {
@@ -0,0 +1,218 @@
+#include "goku_ir_cache.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "goku_mem.h"
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "app_ir_cache"
+
+#define IR_CACHE_BUDGET_BYTES (CONFIG_APP_IR_CACHE_BUDGET_KB * 1024)
+#define IR_CACHE_MAX_ENTRIES CONFIG_APP_IR_CACHE_MAX_ENTRIES
+#define IR_CACHE_KEY_LEN 16 // NVS key limit (15 chars + NUL)
+
+typedef struct {
+  char key[IR_CACHE_KEY_LEN];
+  void *symbols;
+  size_t word_count;
+  size_t bytes;
+  uint32_t last_use; // LRU stamp
+  uint16_t refs;     // Pinned while being transmitted
+  bool used;
+  bool stale; // Invalidated while pinned, freed on last release
+} ir_cache_entry_t;
+
+static ir_cache_entry_t s_entries[IR_CACHE_MAX_ENTRIES];
+static app_ir_cache_stats_t s_stats;
+static uint32_t s_clock = 0;
+static SemaphoreHandle_t s_cache_mutex = NULL;
+
+static void ir_cache_drop(ir_cache_entry_t *e) {
+  s_stats.bytes_used -= e->bytes;
+  s_stats.entries--;
+  app_mem_free(e->symbols);
+  memset(e, 0, sizeof(*e));
+}
+
+// Invalidate an entry now, or defer the free until it is unpinned
+static void ir_cache_retire(ir_cache_entry_t *e) {
+  if (e->refs > 0) {
+    e->stale = true;
+  } else {
+    ir_cache_drop(e);
+  }
+}
+
+static ir_cache_entry_t *ir_cache_find(const char *key) {
+  for (int i = 0; i < IR_CACHE_MAX_ENTRIES; i++) {
+    ir_cache_entry_t *e = &s_entries[i];
+    if (e->used && !e->stale && strcmp(e->key, key) == 0)
+      return e;
+  }
+  return NULL;
+}
+
+// Evict the least recently used unpinned entry
+static bool ir_cache_evict_one(void) {
+  ir_cache_entry_t *victim = NULL;
+  for (int i = 0; i < IR_CACHE_MAX_ENTRIES; i++) {
+    ir_cache_entry_t *e = &s_entries[i];
+    if (!e->used || e->refs > 0)
+      continue;
+    if (!victim || (int32_t)(e->last_use - victim->last_use) < 0)
+      victim = e;
+  }
+  if (!victim)
+    return false;
+
+  ESP_LOGD(TAG, "Evict %s (%u B)", victim->key, (unsigned int)victim->bytes);
+  ir_cache_drop(victim);
+  s_stats.evictions++;
+  return true;
+}
+
+static ir_cache_entry_t *ir_cache_free_slot(void) {
+  for (int i = 0; i < IR_CACHE_MAX_ENTRIES; i++) {
+    if (!s_entries[i].used)
+      return &s_entries[i];
+  }
+  return NULL;
+}
+
+esp_err_t app_ir_cache_init(void) {
+  if (s_cache_mutex)
+    return ESP_OK;
+
+  s_cache_mutex = xSemaphoreCreateMutex();
+  if (!s_cache_mutex)
+    return ESP_ERR_NO_MEM;
+
+  s_stats.budget = IR_CACHE_BUDGET_BYTES;
+  ESP_LOGI(TAG, "IR symbol cache: %u bytes, %d entries",
+           (unsigned int)s_stats.budget, IR_CACHE_MAX_ENTRIES);
+  return ESP_OK;
+}
+
+bool app_ir_cache_acquire(const char *key, const void **symbols,
+                          size_t *word_count) {
+  if (!s_cache_mutex || !key)
+    return false;
+
+  bool hit = false;
+  xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+  ir_cache_entry_t *e = ir_cache_find(key);
+  if (e) {
+    e->refs++;
+    e->last_use = ++s_clock;
+    *symbols = e->symbols;
+    *word_count = e->word_count;
+    s_stats.hits++;
+    hit = true;
+  } else {
+    s_stats.misses++;
+  }
+  xSemaphoreGive(s_cache_mutex);
+  return hit;
+}
+
+bool app_ir_cache_insert(const char *key, void *symbols, size_t word_count,
+                         size_t bytes) {
+  if (!s_cache_mutex || !key || !symbols ||
+      strlen(key) >= IR_CACHE_KEY_LEN)
+    return false;
+
+  if (bytes > IR_CACHE_BUDGET_BYTES) {
+    xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+    s_stats.rejects++;
+    xSemaphoreGive(s_cache_mutex);
+    return false;
+  }
+
+  bool adopted = false;
+  xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+
+  // A concurrent sender may have inserted the same key meanwhile
+  ir_cache_entry_t *old = ir_cache_find(key);
+  if (old)
+    ir_cache_retire(old);
+
+  while (s_stats.bytes_used + bytes > IR_CACHE_BUDGET_BYTES) {
+    if (!ir_cache_evict_one())
+      break;
+  }
+
+  ir_cache_entry_t *slot = NULL;
+  if (s_stats.bytes_used + bytes <= IR_CACHE_BUDGET_BYTES) {
+    slot = ir_cache_free_slot();
+    if (!slot && ir_cache_evict_one())
+      slot = ir_cache_free_slot();
+  }
+
+  if (slot) {
+    strncpy(slot->key, key, IR_CACHE_KEY_LEN - 1);
+    slot->symbols = symbols;
+    slot->word_count = word_count;
+    slot->bytes = bytes;
+    slot->last_use = ++s_clock;
+    slot->refs = 1;
+    slot->used = true;
+    s_stats.bytes_used += bytes;
+    s_stats.entries++;
+    s_stats.inserts++;
+    adopted = true;
+  } else {
+    s_stats.rejects++;
+  }
+  xSemaphoreGive(s_cache_mutex);
+  return adopted;
+}
+
+void app_ir_cache_release(const void *symbols) {
+  if (!s_cache_mutex || !symbols)
+    return;
+
+  xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+  for (int i = 0; i < IR_CACHE_MAX_ENTRIES; i++) {
+    ir_cache_entry_t *e = &s_entries[i];
+    if (e->used && e->symbols == symbols) {
+      if (e->refs > 0)
+        e->refs--;
+      if (e->refs == 0 && e->stale)
+        ir_cache_drop(e);
+      break;
+    }
+  }
+  xSemaphoreGive(s_cache_mutex);
+}
+
+void app_ir_cache_invalidate(const char *key) {
+  if (!s_cache_mutex)
+    return;
+
+  xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+  for (int i = 0; i < IR_CACHE_MAX_ENTRIES; i++) {
+    ir_cache_entry_t *e = &s_entries[i];
+    if (!e->used || e->stale)
+      continue;
+    if (key == NULL || strcmp(e->key, key) == 0) {
+      ir_cache_retire(e);
+      s_stats.invalidations++;
+    }
+  }
+  xSemaphoreGive(s_cache_mutex);
+}
+
+void app_ir_cache_get_stats(app_ir_cache_stats_t *stats) {
+  if (!stats)
+    return;
+  if (!s_cache_mutex) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+
+  xSemaphoreTake(s_cache_mutex, portMAX_DELAY);
+  memcpy(stats, &s_stats, sizeof(*stats));
+  xSemaphoreGive(s_cache_mutex);
+}
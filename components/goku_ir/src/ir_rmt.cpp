@@ -1,6 +1,10 @@
 #include "driver/rmt_encoder.h"
 #include "driver/rmt_tx.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "goku_log.h"
+#include "goku_mem.h"
 #include "ir_ac_registry.hpp"
 #include "ir_engine.h"
 #include "ir_protocol_nec.hpp"
@@ -10,6 +14,13 @@ static const char *TAG = "goku_ir_rmt";
 
 static rmt_channel_handle_t g_tx_channel = NULL;
 static rmt_encoder_handle_t g_copy_encoder = NULL;
+// One frame on the air at a time (AC scheduler and web IR workers).
+// Recursive so a sequence held with ir_engine_tx_hold() can still send.
+static SemaphoreHandle_t g_tx_lock = NULL;
+static uint32_t g_resolution_hz = 0;
+
+// Slack on top of a frame's own length before a transmission is abandoned
+#define IR_TX_MARGIN_MS 100
 
 extern "C" esp_err_t ir_engine_init(const ir_engine_config_t *config) {
   if (!config)
@@ -38,20 +49,60 @@ extern "C" esp_err_t ir_engine_init(const ir_engine_config_t *config) {
   rmt_copy_encoder_config_t copy_encoder_config = {};
   ESP_ERROR_CHECK(rmt_new_copy_encoder(&copy_encoder_config, &g_copy_encoder));
 
+  g_tx_lock = xSemaphoreCreateRecursiveMutex();
+  if (!g_tx_lock)
+    return ESP_ERR_NO_MEM;
+  g_resolution_hz = (uint32_t)config->resolution_hz;
+
   return ESP_OK;
 }
 
+// Time the frame takes on the air, plus IR_TX_MARGIN_MS
+static int ir_tx_timeout_ms(const rmt_symbol_word_t *symbols, size_t count) {
+  uint64_t ticks = 0;
+  for (size_t i = 0; i < count; i++)
+    ticks += symbols[i].duration0 + symbols[i].duration1;
+  return (int)(ticks * 1000 / g_resolution_hz) + IR_TX_MARGIN_MS;
+}
+
 extern "C" esp_err_t ir_engine_send_raw(const void *symbols, size_t count) {
-  if (!g_tx_channel || !g_copy_encoder) {
+  if (!g_tx_channel || !g_copy_encoder || !g_tx_lock) {
     return ESP_ERR_INVALID_STATE;
   }
 
+  const rmt_symbol_word_t *words = (const rmt_symbol_word_t *)symbols;
+  int timeout_ms = ir_tx_timeout_ms(words, count);
+
+  xSemaphoreTakeRecursive(g_tx_lock, portMAX_DELAY);
   rmt_transmit_config_t tx_config = {.loop_count = 0};
-  ESP_ERROR_CHECK(rmt_transmit(g_tx_channel, g_copy_encoder, symbols,
-                               count * sizeof(rmt_symbol_word_t), &tx_config));
-  ESP_ERROR_CHECK(rmt_tx_wait_all_done(g_tx_channel, -1));
+  esp_err_t err =
+      rmt_transmit(g_tx_channel, g_copy_encoder, symbols,
+                   count * sizeof(rmt_symbol_word_t), &tx_config);
+  if (err == ESP_OK) {
+    err = rmt_tx_wait_all_done(g_tx_channel, timeout_ms);
+    if (err != ESP_OK) {
+      // The encoder may still be reading the caller's buffer: drop the
+      // transaction before handing the buffer back
+      rmt_disable(g_tx_channel);
+      rmt_enable(g_tx_channel);
+    }
+  }
+  xSemaphoreGiveRecursive(g_tx_lock);
 
-  return ESP_OK;
+  if (err != ESP_OK)
+    ESP_LOGE(TAG, "Transmit of %d symbols failed: %s", (int)count,
+             esp_err_to_name(err));
+  return err;
+}
+
+extern "C" void ir_engine_tx_hold(void) {
+  if (g_tx_lock)
+    xSemaphoreTakeRecursive(g_tx_lock, portMAX_DELAY);
+}
+
+extern "C" void ir_engine_tx_release(void) {
+  if (g_tx_lock)
+    xSemaphoreGiveRecursive(g_tx_lock);
 }
 
 extern "C" esp_err_t ir_engine_send_nec(uint16_t address, uint16_t command) {
@@ -65,14 +116,14 @@ extern "C" esp_err_t ir_engine_send_nec(uint16_t address, uint16_t command) {
 
   if (!symbols || symbol_count == 0) {
     if (symbols)
-      free(symbols);
+      app_mem_free(symbols);
     return ESP_FAIL;
   }
 
-  ESP_LOGI(TAG, "Sending NEC: Addr=0x%04X, Cmd=0x%04X, Symbols=%d", address,
-           command, (int)symbol_count);
+  APP_LOGBI(TAG, "Sending NEC: Addr=0x%04X, Cmd=0x%04X, Symbols=%d", address,
+            command, (int)symbol_count);
   esp_err_t err = ir_engine_send_raw(symbols, symbol_count);
-  free(symbols);
+  app_mem_free(symbols);
   return err;
 }
 
@@ -88,11 +139,11 @@ extern "C" esp_err_t ir_engine_send_daikin(const ir_ac_state_t *state) {
   if (!symbols)
     return ESP_FAIL;
 
-  ESP_LOGI(TAG, "Sending Daikin AC: P=%d T=%d M=%d", state->power, state->temp,
-           state->mode);
+  APP_LOGBI(TAG, "Sending Daikin AC: P=%d T=%d M=%d", state->power, state->temp,
+            state->mode);
 
   esp_err_t err = ir_engine_send_raw(symbols, symbol_count);
-  free(symbols);
+  app_mem_free(symbols);
   return err;
 }
 
@@ -107,9 +158,9 @@ extern "C" esp_err_t ir_engine_send_samsung(const ir_ac_state_t *state) {
       ir_samsung_generate_symbols(state, &symbol_count);
   if (!symbols)
     return ESP_FAIL;
-  ESP_LOGI(TAG, "Sending Samsung AC");
+  APP_LOGBI(TAG, "Sending Samsung AC");
   esp_err_t err = ir_engine_send_raw(symbols, symbol_count);
-  free(symbols);
+  app_mem_free(symbols);
   return err;
 }
 
@@ -121,9 +172,9 @@ extern "C" esp_err_t ir_engine_send_mitsubishi(const ir_ac_state_t *state) {
       ir_mitsubishi_generate_symbols(state, &symbol_count);
   if (!symbols)
     return ESP_FAIL;
-  ESP_LOGI(TAG, "Sending Mitsubishi AC");
+  APP_LOGBI(TAG, "Sending Mitsubishi AC");
   esp_err_t err = ir_engine_send_raw(symbols, symbol_count);
-  free(symbols);
+  app_mem_free(symbols);
   return err;
 }
 
@@ -135,8 +186,8 @@ extern "C" esp_err_t ir_engine_send_ac(ac_brand_t brand,
   // 1. Try Universal Registry first
   const ir_ac_definition_t *def = ir_ac_registry_get(brand);
   if (def) {
-    ESP_LOGI(TAG, "Using Universal Engine for Brand %d (%s)", brand,
-             def->protocol.name);
+    APP_LOGBI(TAG, "Using Universal Engine for Brand %d (%s)", brand,
+              def->protocol.name);
 
     // Translate State -> Bytes
     uint8_t payload[32] = {0}; // Reasonable max for AC
@@ -160,7 +211,7 @@ extern "C" esp_err_t ir_engine_send_ac(ac_brand_t brand,
       return ESP_ERR_NO_MEM;
 
     esp_err_t err = ir_engine_send_raw(symbols, symbol_count);
-    free(symbols);
+    app_mem_free(symbols);
     return err;
   }
 
@@ -1,5 +1,7 @@
 #include "ir_universal.hpp"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "goku_mem.h"
 #include <cstdlib>
 #include <cstring>
 
@@ -40,7 +42,8 @@ ir_universal_generate_symbols(const ir_protocol_config_t *config,
   if (alloc_bytes % 4 != 0)
     alloc_bytes += 2;
 
-  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)calloc(1, alloc_bytes);
+  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)app_mem_calloc(
+      APP_MEM_TAG_IR, 1, alloc_bytes, MALLOC_CAP_DEFAULT);
   if (!buffer) {
     ESP_LOGE(TAG, "No memory");
     return NULL;
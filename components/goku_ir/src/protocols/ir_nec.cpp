@@ -1,4 +1,6 @@
 #include "ir_protocol_nec.hpp"
+#include "esp_heap_caps.h"
+#include "goku_mem.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -29,7 +31,8 @@ rmt_symbol_word_t *ir_nec_generate_symbols(uint16_t address, uint16_t command,
     num_items++; // Align to even number for full 32-bit words
 
   size_t buffer_size_bytes = num_items * sizeof(uint16_t);
-  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)calloc(1, buffer_size_bytes);
+  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)app_mem_calloc(
+      APP_MEM_TAG_IR, 1, buffer_size_bytes, MALLOC_CAP_DEFAULT);
   if (!buffer)
     return NULL;
 
@@ -1,5 +1,7 @@
 #include "ir_protocol_daikin.hpp"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "goku_mem.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -117,8 +119,8 @@ rmt_symbol_word_t *ir_daikin_generate_symbols(const ir_ac_state_t *state,
   // Frame 2: Header(2) + 19*16 + Stop(1) = 307
   // Total approx 440 items -> 220 words
   size_t max_words = 300;
-  rmt_symbol_word_t *buffer =
-      (rmt_symbol_word_t *)calloc(max_words, sizeof(rmt_symbol_word_t));
+  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)app_mem_calloc(
+      APP_MEM_TAG_IR, max_words, sizeof(rmt_symbol_word_t), MALLOC_CAP_DEFAULT);
   if (!buffer)
     return NULL;
 
@@ -1,5 +1,7 @@
 #include "ir_protocol_mitsubishi.hpp"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "goku_mem.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -68,8 +70,9 @@ rmt_symbol_word_t *ir_mitsubishi_generate_symbols(const ir_ac_state_t *state,
 
   // Generation
   int max_items = 400;
-  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)calloc(
-      max_items / 2 + 10, sizeof(rmt_symbol_word_t));
+  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)app_mem_calloc(
+      APP_MEM_TAG_IR, max_items / 2 + 10, sizeof(rmt_symbol_word_t),
+      MALLOC_CAP_DEFAULT);
   if (!buffer)
     return NULL;
 
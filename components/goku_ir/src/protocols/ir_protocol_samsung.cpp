@@ -1,6 +1,9 @@
 #include "ir_protocol_samsung.hpp"
 #include "driver/rmt_types.h" // Required for rmt_symbol_word_t
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "goku_log.h"
+#include "goku_mem.h"
 #include <cstdlib>
 #include <cstring>
 
@@ -96,7 +99,7 @@ rmt_symbol_word_t *ir_samsung_generate_symbols(const ir_ac_state_t *state,
   payload[4] = data2;
   payload[5] = ~data2;
 
-  ESP_LOGI(
+  APP_LOGBI(
       TAG, "Sending Samsung (Legacy 48-bit): %02X %02X %02X %02X %02X %02X",
       payload[0], payload[1], payload[2], payload[3], payload[4], payload[5]);
 
@@ -110,7 +113,8 @@ rmt_symbol_word_t *ir_samsung_generate_symbols(const ir_ac_state_t *state,
   if (alloc_bytes % 4 != 0)
     alloc_bytes += 2;
 
-  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)calloc(1, alloc_bytes);
+  rmt_symbol_word_t *buffer = (rmt_symbol_word_t *)app_mem_calloc(
+      APP_MEM_TAG_IR, 1, alloc_bytes, MALLOC_CAP_DEFAULT);
   if (!buffer)
     return NULL;
 
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <esp_err.h>
+#include <stdbool.h>
 
 /**
  * @brief LED System States
@@ -42,6 +43,23 @@ typedef enum {
   APP_LED_EFFECT_AUTO_CYCLE,
 } app_led_effect_t;
 
+/**
+ * @brief Name of an effect as used by the web API ("rainbow", ...)
+ *
+ * @param effect Effect
+ * @return const char* Name, "static" for out-of-range values
+ */
+const char *app_led_effect_to_str(app_led_effect_t effect);
+
+/**
+ * @brief Look up an effect by name
+ *
+ * @param name Effect name
+ * @param out Matching effect
+ * @return true if the name is known
+ */
+bool app_led_effect_from_str(const char *name, app_led_effect_t *out);
+
 /**
  * @brief Initialize LED strip
  *
@@ -7,11 +7,11 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "led_strip.h"
-#include "nvs.h"
 #include "sdkconfig.h"
 
 #include "goku_led.h"
 #include "goku_log.h"
+#include "goku_settings.h"
 
 #define TAG "app_led"
 #define RGB_LED_GPIO CONFIG_APP_LED_GPIO
@@ -27,16 +27,40 @@ typedef struct {
 } app_led_effect_config_t;
 
 static app_led_effect_config_t g_effect_configs[13]; // 13 effects (0-12)
+
+// Indexed by app_led_effect_t
+static const char *const g_effect_names[] = {
+    "static",
+    "rainbow",
+    "running",
+    "breathing",
+    "blink",
+    "knight_rider",
+    "loading",
+    "color_wipe",
+    "theater_chase",
+    "fire",
+    "sparkle",
+    "random",
+    "auto_cycle",
+};
+_Static_assert(sizeof(g_effect_names) / sizeof(g_effect_names[0]) ==
+                   sizeof(g_effect_configs) / sizeof(g_effect_configs[0]),
+               "Effect name table out of sync");
+
 static app_led_effect_t g_current_effect = APP_LED_EFFECT_STATIC;
 static uint8_t g_brightness = 100; // Global brightness
 
-static app_led_state_config_t g_state_configs[10] = {
-    [APP_LED_OFF] = {0, 0, 0},         [APP_LED_STARTUP] = {0, 0, 0},
-    [APP_LED_WIFI_PROV] = {0, 0, 20},  [APP_LED_WIFI_CONN] = {0, 20, 20},
-    [APP_LED_OTA] = {10, 0, 10},       [APP_LED_IR_TX] = {20, 0, 0},
-    [APP_LED_IR_LEARN] = {20, 20, 0},  [APP_LED_IR_FAIL] = {20, 0, 0},
-    [APP_LED_IR_SUCCESS] = {0, 20, 0}, [APP_LED_IDLE] = {0, 20, 0},
-};
+// Defaults come from the settings snapshot (see goku_settings.c)
+static app_led_state_config_t g_state_configs[10];
+
+// Settings snapshot stores these tables verbatim
+_Static_assert(sizeof(g_effect_configs) ==
+                   sizeof(((app_settings_led_t *)0)->effects),
+               "LED effect layout mismatch");
+_Static_assert(sizeof(g_state_configs) ==
+                   sizeof(((app_settings_led_t *)0)->state_colors),
+               "LED state color layout mismatch");
 
 static void led_strip_set_pixel_scaled(int index, uint8_t r, uint8_t g,
                                        uint8_t b) {
@@ -442,71 +466,39 @@ esp_err_t app_led_init(void) {
       led_strip_new_spi_device(&strip_config, &spi_config, &led_strip));
   led_strip_clear(led_strip);
 
-  // Init default configs
-  for (int i = 0; i < 13; i++) {
-    g_effect_configs[i].speed = 50;
-    for (int j = 0; j < 8; j++) {
-      g_effect_configs[i].colors[j][0] = 0;
-      g_effect_configs[i].colors[j][1] = 20;
-      g_effect_configs[i].colors[j][2] = 0;
-    }
-  }
+  // Load configs (defaults if nothing stored) before the task starts
+  app_led_load_settings();
 
   xTaskCreate(led_task_entry, "led_task", 4096, NULL, 5, &g_led_task_handle);
 
-  app_led_load_settings();
-
   return ESP_OK;
 }
 
 esp_err_t app_led_save_settings(void) {
-  nvs_handle_t my_handle;
-  esp_err_t err;
-
-  err = nvs_open("storage", NVS_READWRITE, &my_handle);
-  if (err != ESP_OK)
-    return err;
-
-  err = nvs_set_blob(my_handle, "led_configs_v2", g_effect_configs,
-                     sizeof(g_effect_configs));
-  if (err == ESP_OK)
-    err = nvs_set_u8(my_handle, "led_effect", g_current_effect);
+  app_settings_led_t led;
 
-  if (err == ESP_OK)
-    err = nvs_set_u8(my_handle, "led_bright", (uint8_t)g_brightness);
+  memcpy(led.effects, g_effect_configs, sizeof(led.effects));
+  memcpy(led.state_colors, g_state_configs, sizeof(led.state_colors));
+  led.effect = (uint8_t)g_current_effect;
+  led.brightness = g_brightness;
 
-  if (err == ESP_OK)
-    err = nvs_commit(my_handle);
-  nvs_close(my_handle);
-  return err;
+  app_settings_set_led(&led);
+  return app_settings_commit();
 }
 
 esp_err_t app_led_load_settings(void) {
-  nvs_handle_t my_handle;
-  esp_err_t err;
+  app_settings_t settings;
+  app_settings_get(&settings);
 
-  err = nvs_open("storage", NVS_READWRITE, &my_handle);
-  if (err != ESP_OK)
-    return err;
+  memcpy(g_effect_configs, settings.led.effects, sizeof(g_effect_configs));
+  memcpy(g_state_configs, settings.led.state_colors, sizeof(g_state_configs));
 
-  size_t required_size = sizeof(g_effect_configs);
-  if (nvs_get_blob(my_handle, "led_configs_v2", g_effect_configs,
-                   &required_size) != ESP_OK) {
-  }
-
-  uint8_t effect = 0;
-  if (nvs_get_u8(my_handle, "led_effect", &effect) == ESP_OK) {
-    if (effect >= 13)
-      effect = APP_LED_EFFECT_STATIC;
-    g_current_effect = (app_led_effect_t)effect;
-  }
-
-  uint8_t bright = 100;
-  if (nvs_get_u8(my_handle, "led_bright", &bright) == ESP_OK) {
-    g_brightness = bright;
-  }
+  uint8_t effect = settings.led.effect;
+  if (effect >= 13)
+    effect = APP_LED_EFFECT_STATIC;
+  g_current_effect = (app_led_effect_t)effect;
+  g_brightness = settings.led.brightness;
 
-  nvs_close(my_handle);
   return ESP_OK;
 }
 
@@ -627,3 +619,21 @@ esp_err_t app_led_get_state_color(app_led_state_t state, uint8_t *r, uint8_t *g,
   }
   return ESP_FAIL;
 }
+
+const char *app_led_effect_to_str(app_led_effect_t effect) {
+  if ((unsigned int)effect >=
+      sizeof(g_effect_names) / sizeof(g_effect_names[0]))
+    return g_effect_names[APP_LED_EFFECT_STATIC];
+  return g_effect_names[effect];
+}
+
+bool app_led_effect_from_str(const char *name, app_led_effect_t *out) {
+  for (size_t i = 0; i < sizeof(g_effect_names) / sizeof(g_effect_names[0]);
+       i++) {
+    if (strcmp(name, g_effect_names[i]) == 0) {
+      *out = (app_led_effect_t)i;
+      return true;
+    }
+  }
+  return false;
+}
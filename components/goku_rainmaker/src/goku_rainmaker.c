@@ -117,68 +117,79 @@ static esp_err_t write_cb(const esp_rmaker_device_t *device,
   }
   const char *param_name = esp_rmaker_param_get_name(param);
 
-  // Get current state
-  ir_ac_state_t state;
-  app_ac_get_state(&state);
+  // Collect only the changed field; applied atomically below so concurrent
+  // web changes to other fields are preserved
+  ir_ac_state_t delta = {0};
+  ac_brand_t brand = AC_BRAND_MAX;
+  uint32_t fields = 0;
 
   if (strcmp(param_name, ESP_RMAKER_DEF_POWER_NAME) == 0) {
     ESP_LOGI(TAG, "Received '%s' = %s", param_name,
              val.val.b ? "true" : "false");
-    state.power = val.val.b;
-    app_ac_set_state(&state);
+    delta.power = val.val.b;
+    fields = APP_AC_FIELD_POWER;
     esp_rmaker_param_update_and_report(param, val);
 
   } else if (strcmp(param_name, ESP_RMAKER_DEF_TEMPERATURE_NAME) == 0) {
     ESP_LOGI(TAG, "Received '%s' = %.1f", param_name, val.val.f);
-    state.temp = (uint8_t)val.val.f;
-    app_ac_set_state(&state);
+    delta.temp = (uint8_t)val.val.f;
+    fields = APP_AC_FIELD_TEMP;
     esp_rmaker_param_update_and_report(param, val);
 
   } else if (strcmp(param_name, "Mode") == 0) {
     ESP_LOGI(TAG, "Received '%s' = %s", param_name, val.val.s);
+    fields = APP_AC_FIELD_MODE;
     if (strcmp(val.val.s, "Auto") == 0)
-      state.mode = 0;
+      delta.mode = 0;
     else if (strcmp(val.val.s, "Cool") == 0)
-      state.mode = 1;
+      delta.mode = 1;
     else if (strcmp(val.val.s, "Heat") == 0)
-      state.mode = 2;
+      delta.mode = 2;
     else if (strcmp(val.val.s, "Fan") == 0)
-      state.mode = 3;
+      delta.mode = 3;
     else if (strcmp(val.val.s, "Dry") == 0)
-      state.mode = 4;
-    app_ac_set_state(&state);
+      delta.mode = 4;
+    else
+      fields = 0;
     esp_rmaker_param_update_and_report(param, val);
 
   } else if (strcmp(param_name, "Fan Speed") == 0) {
     ESP_LOGI(TAG, "Received '%s' = %s", param_name, val.val.s);
+    fields = APP_AC_FIELD_FAN;
     if (strcmp(val.val.s, "Auto") == 0)
-      state.fan = 0;
+      delta.fan = 0;
     else if (strcmp(val.val.s, "Low") == 0)
-      state.fan = 1;
+      delta.fan = 1;
     else if (strcmp(val.val.s, "Medium") == 0)
-      state.fan = 2;
+      delta.fan = 2;
     else if (strcmp(val.val.s, "High") == 0)
-      state.fan = 3;
-    app_ac_set_state(&state);
+      delta.fan = 3;
+    else
+      fields = 0;
     esp_rmaker_param_update_and_report(param, val);
 
   } else if (strcmp(param_name, "Brand") == 0) {
     ESP_LOGI(TAG, "Received Brand = %s", val.val.s);
     if (strcmp(val.val.s, "Daikin") == 0)
-      app_ac_set_brand(AC_BRAND_DAIKIN);
+      brand = AC_BRAND_DAIKIN;
     else if (strcmp(val.val.s, "Samsung") == 0)
-      app_ac_set_brand(AC_BRAND_SAMSUNG);
+      brand = AC_BRAND_SAMSUNG;
     else if (strcmp(val.val.s, "Mitsubishi") == 0)
-      app_ac_set_brand(AC_BRAND_MITSUBISHI);
+      brand = AC_BRAND_MITSUBISHI;
     else if (strcmp(val.val.s, "Panasonic") == 0)
-      app_ac_set_brand(AC_BRAND_PANASONIC);
+      brand = AC_BRAND_PANASONIC;
     else if (strcmp(val.val.s, "LG") == 0)
-      app_ac_set_brand(AC_BRAND_LG);
+      brand = AC_BRAND_LG;
+    if (brand != AC_BRAND_MAX)
+      fields = APP_AC_FIELD_BRAND;
     esp_rmaker_param_update_and_report(param, val);
   }
 
-  // Send Command via Shared Logic
-  app_ac_send();
+  if (fields)
+    app_ac_update_state(&delta, brand, fields);
+
+  // Send Command via Shared Logic (coalesced with other pending changes)
+  app_ac_request_send(APP_AC_SRC_CLOUD);
 
   return ESP_OK;
 }
@@ -0,0 +1,348 @@
+#include "web_batch.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "goku_ac.h"
+#include "goku_data.h"
+#include "goku_ir_app.h"
+#include "goku_mem.h"
+#include "ir_engine.h"
+#include "web_ir.h"
+#include "web_json.h"
+#include "web_limit.h"
+#include "web_req.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "web_batch"
+
+#define BATCH_MAX_BODY 2048
+#define BATCH_MAX_TOKENS 320
+#define BATCH_MAX_OPS 16
+#define BATCH_MAX_RAW 256       // Durations per raw operation
+#define BATCH_MAX_DELAY_MS 10000 // Sum of all delays in one batch
+#define BATCH_KEY_MAX 32
+
+_Static_assert(BATCH_MAX_OPS <= WEB_LIMIT_MAX_TARGETS,
+               "Every op of a batch may transmit");
+
+typedef enum {
+  BATCH_OP_AC,
+  BATCH_OP_SEND,
+  BATCH_OP_RAW,
+  BATCH_OP_DELAY,
+} batch_op_type_t;
+
+static const char *const s_op_names[] = {"ac", "send", "raw", "delay"};
+
+typedef struct {
+  uint8_t type; // batch_op_type_t
+  int16_t obj;  // Token index of the item object
+  esp_err_t err;
+  int32_t at_ms; // Start offset from the beginning of the batch
+  char key[BATCH_KEY_MAX]; // BATCH_OP_SEND only
+} batch_op_t;
+
+struct web_batch {
+  int ntok;
+  int nops;
+  batch_op_t ops[BATCH_MAX_OPS];
+  uint16_t raw[BATCH_MAX_RAW];
+  web_req_tok_t toks[BATCH_MAX_TOKENS];
+  char body[BATCH_MAX_BODY];
+};
+
+static const struct {
+  const char *name;
+  uint32_t field;
+} s_ac_fields[] = {
+    {"power", APP_AC_FIELD_POWER},     {"mode", APP_AC_FIELD_MODE},
+    {"temp", APP_AC_FIELD_TEMP},       {"fan", APP_AC_FIELD_FAN},
+    {"swing_v", APP_AC_FIELD_SWING_V}, {"swing_h", APP_AC_FIELD_SWING_H},
+    {"brand", APP_AC_FIELD_BRAND},
+};
+
+void web_batch_free(web_batch_t *batch) { app_mem_free(batch); }
+
+// An AC op transmits unless it says "send":0
+static bool batch_ac_sends(const web_batch_t *b, const batch_op_t *op) {
+  int send = 1;
+  web_req_json_int(b->body, b->toks, b->ntok, op->obj, "send", &send);
+  return send != 0;
+}
+
+// Check one item; on error returns a short reason for the 400 response
+static const char *batch_validate_item(web_batch_t *b, int obj,
+                                       batch_op_t *op, int *delay_ms) {
+  const char *js = b->body;
+  char name[8];
+  if (b->toks[obj].type != WEB_REQ_TOK_OBJECT)
+    return "item is not an object";
+  if (web_req_json_str(js, b->toks, b->ntok, obj, "op", name, sizeof(name)) !=
+      ESP_OK)
+    return "missing op";
+
+  op->obj = obj;
+  op->type = 0xff;
+  for (size_t i = 0; i < sizeof(s_op_names) / sizeof(s_op_names[0]); i++) {
+    if (strcmp(name, s_op_names[i]) == 0)
+      op->type = i;
+  }
+
+  int val;
+  switch (op->type) {
+  case BATCH_OP_AC:
+    for (size_t i = 0; i < sizeof(s_ac_fields) / sizeof(s_ac_fields[0]); i++) {
+      esp_err_t err = web_req_json_int(js, b->toks, b->ntok, obj,
+                                       s_ac_fields[i].name, &val);
+      if (err == ESP_ERR_INVALID_ARG)
+        return "ac field is not a number";
+    }
+    return NULL;
+
+  case BATCH_OP_SEND:
+    if (web_req_json_str(js, b->toks, b->ntok, obj, "key", op->key,
+                         sizeof(op->key)) != ESP_OK ||
+        op->key[0] == '\0')
+      return "send needs a key";
+    // Checked here so a missing key cannot stop the batch halfway
+    size_t size = 0;
+    if (app_data_load_ir(op->key, NULL, &size) != ESP_OK || size == 0)
+      return "unknown key";
+    return NULL;
+
+  case BATCH_OP_RAW: {
+    int arr = web_req_json_find(js, b->toks, b->ntok, obj, "data");
+    if (arr < 0 || b->toks[arr].type != WEB_REQ_TOK_ARRAY ||
+        b->toks[arr].size == 0)
+      return "raw needs a data array";
+    if (b->toks[arr].size > BATCH_MAX_RAW)
+      return "raw data too long";
+    for (int i = arr + 1; i < web_req_json_skip(b->toks, b->ntok, arr); i++) {
+      if (web_req_json_tok_int(js, &b->toks[i], &val) != ESP_OK || val <= 0 ||
+          val > 0x7fff)
+        return "raw durations must be 1..32767 us";
+    }
+    return NULL;
+  }
+
+  case BATCH_OP_DELAY:
+    if (web_req_json_int(js, b->toks, b->ntok, obj, "ms", &val) != ESP_OK ||
+        val < 0)
+      return "delay needs ms";
+    *delay_ms += val;
+    if (*delay_ms > BATCH_MAX_DELAY_MS)
+      return "total delay too long";
+    return NULL;
+
+  default:
+    return "unknown op";
+  }
+}
+
+esp_err_t web_batch_handler(httpd_req_t *req) {
+  // Sized for the largest raw op, so kept off the httpd stack
+  web_batch_t *b = app_mem_malloc_prefer(APP_MEM_TAG_WEB, sizeof(*b),
+                                         MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+  if (!b) {
+    httpd_resp_send_500(req);
+    return ESP_OK;
+  }
+
+  size_t len;
+  if (web_req_recv_body(req, b->body, sizeof(b->body), &len) != ESP_OK) {
+    web_batch_free(b);
+    return ESP_OK; // Error response already sent
+  }
+
+  b->ntok = web_req_json_parse(b->body, len, b->toks, BATCH_MAX_TOKENS);
+  if (b->ntok < 1 || b->toks[0].type != WEB_REQ_TOK_ARRAY) {
+    web_batch_free(b);
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                        "Expected a JSON array of operations");
+    return ESP_OK;
+  }
+  if (b->toks[0].size == 0 || b->toks[0].size > BATCH_MAX_OPS) {
+    web_batch_free(b);
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                        "Batch must hold 1-16 operations");
+    return ESP_OK;
+  }
+
+  // Validate everything up front so a bad item never leaves a half-run batch
+  int delay_ms = 0;
+  b->nops = 0;
+  for (int i = 1; i < b->ntok; i = web_req_json_skip(b->toks, b->ntok, i)) {
+    const char *why =
+        batch_validate_item(b, i, &b->ops[b->nops], &delay_ms);
+    if (why) {
+      char msg[64];
+      snprintf(msg, sizeof(msg), "Item %d: %s", b->nops, why);
+      web_batch_free(b);
+      httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, msg);
+      return ESP_OK;
+    }
+    b->nops++;
+  }
+
+  // Each transmission is charged to its own target, as if sent alone
+  web_limit_target_t targets[BATCH_MAX_OPS];
+  size_t ntargets = 0;
+  for (int i = 0; i < b->nops; i++) {
+    const batch_op_t *op = &b->ops[i];
+    if (op->type == BATCH_OP_SEND)
+      targets[ntargets++] =
+          (web_limit_target_t){.kind = WEB_LIMIT_KEY, .key = op->key};
+    else if (op->type == BATCH_OP_RAW)
+      targets[ntargets++] = (web_limit_target_t){.kind = WEB_LIMIT_RAW};
+    else if (op->type == BATCH_OP_AC && batch_ac_sends(b, op))
+      targets[ntargets++] = (web_limit_target_t){.kind = WEB_LIMIT_AC};
+  }
+
+  if (web_ir_admit(req, targets, ntargets) != ESP_OK) {
+    web_batch_free(b);
+    return ESP_OK;
+  }
+
+  web_req_query_t q;
+  web_req_query_load(req, &q);
+  web_ir_submit_batch(req, b, web_req_query_flag(&q, "async"));
+  return ESP_OK;
+}
+
+// Sleep whole ticks, then spin out only the sub-tick remainder. The first
+// one-tick sleep lines the task up with the tick, so the sleeps after it
+// end exactly on a tick boundary.
+static void batch_wait_until(int64_t target_us) {
+  const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+  int64_t remain = target_us - esp_timer_get_time();
+  if (remain <= 0)
+    return; // Already late, e.g. the previous op was preempted
+  if (remain >= tick_us) {
+    vTaskDelay(1);
+    remain = target_us - esp_timer_get_time();
+    if (remain >= tick_us)
+      vTaskDelay((TickType_t)(remain / tick_us));
+  }
+  while ((remain = target_us - esp_timer_get_time()) > 0)
+    esp_rom_delay_us(remain > 1000 ? 1000 : (uint32_t)remain);
+}
+
+static esp_err_t batch_exec(web_batch_t *b, const batch_op_t *op,
+                            int64_t *mark_us) {
+  const char *js = b->body;
+  int val;
+  esp_err_t err = ESP_OK;
+
+  switch (op->type) {
+  case BATCH_OP_AC: {
+    ir_ac_state_t delta = {0};
+    ac_brand_t brand = AC_BRAND_MAX;
+    uint32_t fields = 0;
+    for (size_t i = 0; i < sizeof(s_ac_fields) / sizeof(s_ac_fields[0]); i++) {
+      if (web_req_json_int(js, b->toks, b->ntok, op->obj, s_ac_fields[i].name,
+                           &val) != ESP_OK)
+        continue;
+      fields |= s_ac_fields[i].field;
+      switch (s_ac_fields[i].field) {
+      case APP_AC_FIELD_POWER:
+        delta.power = val;
+        break;
+      case APP_AC_FIELD_MODE:
+        delta.mode = val;
+        break;
+      case APP_AC_FIELD_TEMP:
+        delta.temp = val;
+        break;
+      case APP_AC_FIELD_FAN:
+        delta.fan = val;
+        break;
+      case APP_AC_FIELD_SWING_V:
+        delta.swing_v = val;
+        break;
+      case APP_AC_FIELD_SWING_H:
+        delta.swing_h = val;
+        break;
+      default:
+        brand = (ac_brand_t)val;
+        break;
+      }
+    }
+    app_ac_update_state(&delta, brand, fields);
+
+    // Transmit directly: the coalescing scheduler would shift the timing
+    if (batch_ac_sends(b, op))
+      err = app_ac_send();
+    break;
+  }
+
+  case BATCH_OP_SEND:
+    err = app_ir_send_key(op->key);
+    break;
+
+  case BATCH_OP_RAW: {
+    int arr = web_req_json_find(js, b->toks, b->ntok, op->obj, "data");
+    size_t n = 0;
+    for (int i = arr + 1; i < web_req_json_skip(b->toks, b->ntok, arr); i++) {
+      web_req_json_tok_int(js, &b->toks[i], &val);
+      b->raw[n++] = val;
+    }
+    err = app_ir_send_raw(b->raw, n);
+    break;
+  }
+
+  case BATCH_OP_DELAY:
+    web_req_json_int(js, b->toks, b->ntok, op->obj, "ms", &val);
+    *mark_us += (int64_t)val * 1000;
+    batch_wait_until(*mark_us);
+    return ESP_OK; // Consecutive delays add up exactly
+  }
+
+  *mark_us = esp_timer_get_time();
+  return err;
+}
+
+esp_err_t web_batch_run(web_batch_t *b, httpd_req_t *req) {
+  esp_err_t result = ESP_OK;
+  int64_t start_us = esp_timer_get_time();
+  int64_t mark_us = start_us; // End of the previous operation
+  // No other frame may land between two ops; other senders wait
+  ir_engine_tx_hold();
+  for (int i = 0; i < b->nops; i++) {
+    batch_op_t *op = &b->ops[i];
+    op->at_ms = (esp_timer_get_time() - start_us) / 1000;
+    op->err = batch_exec(b, op, &mark_us);
+    if (op->err != ESP_OK) {
+      ESP_LOGW(TAG, "Item %d (%s) failed: %s", i, s_op_names[op->type],
+               esp_err_to_name(op->err));
+      result = ESP_FAIL;
+    }
+  }
+  ir_engine_tx_release();
+
+  // Results go out only after the last operation, so a slow client cannot
+  // stretch the spacing between transmissions
+  if (req) {
+    web_json_t w;
+    web_json_begin(&w, req);
+    web_json_arr_open(&w, NULL);
+    for (int i = 0; i < b->nops; i++) {
+      const batch_op_t *op = &b->ops[i];
+      web_json_obj_open(&w, NULL);
+      web_json_str(&w, "op", s_op_names[op->type]);
+      web_json_bool(&w, "ok", op->err == ESP_OK);
+      web_json_int(&w, "at_ms", op->at_ms);
+      if (op->err != ESP_OK)
+        web_json_str(&w, "error", esp_err_to_name(op->err));
+      web_json_obj_close(&w);
+    }
+    web_json_arr_close(&w);
+    web_json_end(&w);
+  }
+  web_batch_free(b);
+  return result;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file web_batch.h
+ * @brief POST /api/batch: several IR operations in one request
+ *
+ * The body is a JSON array executed in order by an IR worker:
+ *   {"op":"ac", "power":1, "temp":24, ..., "send":true}  patch AC state
+ *   {"op":"send", "key":"tv_power"}                     stored key
+ *   {"op":"raw", "data":[9000,4500,560,...]}            durations in us
+ *   {"op":"delay", "ms":250}                            pause
+ * A delay is measured from the end of the previous operation. The batch
+ * keeps the transmitter throughout, so no other frame lands between its
+ * operations. The response is an array with one {"op","ok","at_ms"
+ * [,"error"]} entry per operation.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct web_batch web_batch_t;
+
+/**
+ * @brief POST /api/batch handler
+ *
+ * Validates the whole batch before anything is transmitted, stored keys
+ * included, and answers 400 if an item is malformed.
+ */
+esp_err_t web_batch_handler(httpd_req_t *req);
+
+/**
+ * @brief Execute a validated batch and free it (IR worker context)
+ *
+ * @param batch Batch from web_batch_handler()
+ * @param req Detached request to write the result array to, or NULL
+ * @return esp_err_t ESP_OK if every operation succeeded
+ */
+esp_err_t web_batch_run(web_batch_t *batch, httpd_req_t *req);
+
+/**
+ * @brief Free a batch that will not be run
+ */
+void web_batch_free(web_batch_t *batch);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+#include "web_conn.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/sockets.h"
+#include "sdkconfig.h"
+#include <errno.h>
+#include <stdbool.h>
+
+#define CONN_MAX CONFIG_APP_WEB_MAX_SOCKETS
+
+// httpd keeps three sockets of its own (listen, control send and receive)
+#define CONN_HTTPD_SOCKETS 3
+// Sockets the rest of the firmware may hold while the server is full:
+// the RainMaker MQTT connection, its SNTP client, and the OTA version
+// check plus image download
+#define CONN_OTHER_SOCKETS 4
+
+#if CONN_MAX + CONN_HTTPD_SOCKETS + CONN_OTHER_SOCKETS >                     \
+    CONFIG_LWIP_MAX_SOCKETS
+#error "APP_WEB_MAX_SOCKETS + 7 exceeds LWIP_MAX_SOCKETS"
+#endif
+
+static web_conn_stats_t s_stats = {.limit = CONN_MAX};
+static portMUX_TYPE s_conn_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static esp_err_t web_conn_open(httpd_handle_t hd, int sockfd) {
+  taskENTER_CRITICAL(&s_conn_lock);
+  s_stats.active++;
+  s_stats.opened++;
+  if (s_stats.active > s_stats.peak)
+    s_stats.peak = s_stats.active;
+  taskEXIT_CRITICAL(&s_conn_lock);
+  return ESP_OK;
+}
+
+// httpd leaves closing the socket to this hook once it is installed
+static void web_conn_close(httpd_handle_t hd, int sockfd) {
+  // httpd does not say why a session ends, so an LRU purge cannot be told
+  // from a timeout; both count when the peer still holds the socket open
+  // and every slot was taken.
+  char c;
+  int ret = recv(sockfd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  bool peer_open =
+      ret > 0 || (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+
+  taskENTER_CRITICAL(&s_conn_lock);
+  bool full = s_stats.active >= CONN_MAX;
+  if (s_stats.active > 0)
+    s_stats.active--;
+  s_stats.closed++;
+  if (full && peer_open)
+    s_stats.closed_full++;
+  taskEXIT_CRITICAL(&s_conn_lock);
+
+  close(sockfd);
+}
+
+void web_conn_configure(httpd_config_t *config) {
+  config->max_open_sockets = CONN_MAX;
+#if CONFIG_APP_WEB_LRU_PURGE
+  config->lru_purge_enable = true;
+#endif
+  config->recv_wait_timeout = CONFIG_APP_WEB_RECV_TIMEOUT_S;
+  config->send_wait_timeout = CONFIG_APP_WEB_SEND_TIMEOUT_S;
+#if CONFIG_APP_WEB_KEEPALIVE
+  config->keep_alive_enable = true;
+  config->keep_alive_idle = CONFIG_APP_WEB_KEEPALIVE_IDLE_S;
+  config->keep_alive_interval = CONFIG_APP_WEB_KEEPALIVE_INTERVAL_S;
+  config->keep_alive_count = CONFIG_APP_WEB_KEEPALIVE_COUNT;
+#endif
+  config->open_fn = web_conn_open;
+  config->close_fn = web_conn_close;
+}
+
+void web_conn_get_stats(web_conn_stats_t *out) {
+  taskENTER_CRITICAL(&s_conn_lock);
+  *out = s_stats;
+  taskEXIT_CRITICAL(&s_conn_lock);
+}
@@ -0,0 +1,48 @@
+/**
+ * @file web_conn.h
+ * @brief HTTP server socket budget and connection accounting
+ *
+ * Applies the socket limit, LRU purge, TCP keep-alive and socket timeouts
+ * from Kconfig to the server configuration, and counts connections through
+ * the httpd open/close hooks. When every socket is taken, LRU purge closes
+ * the least recently used connection so a new client is served instead of
+ * hanging in the accept backlog; keep-alive probes reclaim sockets of
+ * clients that vanished (phones leaving Wi-Fi) without closing them.
+ */
+
+#pragma once
+
+#include "esp_http_server.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint32_t limit;  // max_open_sockets
+  uint32_t active; // Sessions open now
+  uint32_t peak;   // Highest simultaneous sessions since boot
+  uint32_t opened;
+  uint32_t closed;
+  // Connections the server closed while every slot was taken and the peer
+  // was still connected: LRU purges, and timeouts that hit at such a time
+  uint32_t closed_full;
+} web_conn_stats_t;
+
+/**
+ * @brief Fill socket-related fields of an httpd configuration
+ *
+ * Sets max_open_sockets, lru_purge_enable, recv/send timeouts, TCP
+ * keep-alive and the open/close hooks.
+ */
+void web_conn_configure(httpd_config_t *config);
+
+/**
+ * @brief Snapshot of the connection counters
+ */
+void web_conn_get_stats(web_conn_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
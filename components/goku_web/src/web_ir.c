@@ -0,0 +1,311 @@
+#include "web_ir.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "goku_ac.h"
+#include "goku_ir_app.h"
+#include "sdkconfig.h"
+#include "web_json.h"
+#include "web_limit.h"
+#include "web_perf.h"
+#include "web_req.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "web_ir"
+
+#define IR_WORKERS CONFIG_APP_WEB_IR_WORKERS
+#define IR_QUEUE_LEN CONFIG_APP_WEB_IR_QUEUE_LEN
+#define IR_WAIT_MS CONFIG_APP_WEB_IR_WAIT_MS
+#define IR_JOB_HISTORY 16 // Finished jobs still answerable on /api/ir/job
+#define IR_KEY_MAX 32
+
+typedef enum {
+  IR_JOB_QUEUED,
+  IR_JOB_RUNNING,
+  IR_JOB_DONE,
+  IR_JOB_FAILED,
+  IR_JOB_PENDING, // AC flush still outstanding after the wait limit
+} ir_job_state_t;
+
+typedef struct {
+  uint32_t id;
+  web_ir_job_type_t type;
+  char key[IR_KEY_MAX];
+  web_batch_t *batch; // WEB_IR_JOB_BATCH only, owned by the job
+  httpd_req_t *req;   // Detached request to answer, NULL if already answered
+  web_perf_mark_t mark; // Timing of req, finished when it is answered
+} ir_job_t;
+
+typedef struct {
+  uint32_t id; // 0 = unused slot
+  uint8_t type;
+  uint8_t state;
+  esp_err_t err;
+} ir_job_record_t;
+
+static QueueHandle_t s_ir_queue = NULL;
+static ir_job_record_t s_history[IR_JOB_HISTORY];
+static uint32_t s_next_id = 1;
+static portMUX_TYPE s_ir_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *ir_job_state_str(uint8_t state) {
+  switch (state) {
+  case IR_JOB_QUEUED:
+    return "queued";
+  case IR_JOB_RUNNING:
+    return "running";
+  case IR_JOB_DONE:
+    return "done";
+  case IR_JOB_PENDING:
+    return "pending";
+  default:
+    return "failed";
+  }
+}
+
+static uint32_t ir_job_create(web_ir_job_type_t type) {
+  taskENTER_CRITICAL(&s_ir_lock);
+  uint32_t id = s_next_id++;
+  if (s_next_id == 0)
+    s_next_id = 1;
+  s_history[id % IR_JOB_HISTORY] = (ir_job_record_t){
+      .id = id, .type = type, .state = IR_JOB_QUEUED, .err = ESP_OK};
+  taskEXIT_CRITICAL(&s_ir_lock);
+  return id;
+}
+
+static void ir_job_set_state(uint32_t id, ir_job_state_t state,
+                             esp_err_t err) {
+  taskENTER_CRITICAL(&s_ir_lock);
+  ir_job_record_t *rec = &s_history[id % IR_JOB_HISTORY];
+  if (rec->id == id) { // Not yet overwritten by a newer job
+    rec->state = state;
+    rec->err = err;
+  }
+  taskEXIT_CRITICAL(&s_ir_lock);
+}
+
+static esp_err_t ir_job_send_accepted(httpd_req_t *req, uint32_t id) {
+  httpd_resp_set_status(req, "202 Accepted");
+  web_json_t w;
+  web_json_begin(&w, req);
+  web_json_obj_open(&w, NULL);
+  web_json_uint(&w, "job", id);
+  web_json_str(&w, "state", ir_job_state_str(IR_JOB_QUEUED));
+  web_json_obj_close(&w);
+  return web_json_end(&w);
+}
+
+static void ir_job_respond(const ir_job_t *job, ir_job_state_t state,
+                           esp_err_t err) {
+  httpd_req_t *req = job->req;
+  if (state == IR_JOB_PENDING) {
+    ir_job_send_accepted(req, job->id);
+  } else if (err != ESP_OK) {
+    httpd_resp_send_500(req);
+  } else {
+    const char *body = (job->type == WEB_IR_JOB_KEY) ? "Sent" : "OK";
+    httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+  }
+  web_perf_complete(&job->mark, state == IR_JOB_FAILED ? err : ESP_OK);
+  httpd_req_async_handler_complete(req);
+}
+
+static void web_ir_worker(void *arg) {
+  ir_job_t job;
+  while (1) {
+    if (xQueueReceive(s_ir_queue, &job, portMAX_DELAY) != pdTRUE)
+      continue;
+
+    ir_job_set_state(job.id, IR_JOB_RUNNING, ESP_OK);
+
+    esp_err_t err;
+    ir_job_state_t state;
+    if (job.type == WEB_IR_JOB_BATCH) {
+      // Writes its own per-item response
+      err = web_batch_run(job.batch, job.req);
+      state = (err == ESP_OK) ? IR_JOB_DONE : IR_JOB_FAILED;
+      ir_job_set_state(job.id, state, err);
+      if (job.req) {
+        web_perf_complete(&job.mark, err);
+        httpd_req_async_handler_complete(job.req);
+      }
+      continue;
+    } else if (job.type == WEB_IR_JOB_KEY) {
+      err = app_ir_send_key(job.key);
+      state = (err == ESP_OK) ? IR_JOB_DONE : IR_JOB_FAILED;
+    } else {
+      // The scheduler may merge this with other requests; wait for the
+      // flush that covers it
+      err = app_ac_request_send_wait(APP_AC_SRC_WEB, IR_WAIT_MS);
+      if (err == ESP_ERR_TIMEOUT)
+        state = IR_JOB_PENDING;
+      else
+        state = (err == ESP_OK) ? IR_JOB_DONE : IR_JOB_FAILED;
+    }
+
+    ir_job_set_state(job.id, state, err);
+    if (job.req)
+      ir_job_respond(&job, state, err);
+  }
+}
+
+esp_err_t web_ir_init(void) {
+  if (s_ir_queue)
+    return ESP_OK;
+
+  s_ir_queue = xQueueCreate(IR_QUEUE_LEN, sizeof(ir_job_t));
+  if (!s_ir_queue)
+    return ESP_ERR_NO_MEM;
+
+  int started = 0;
+  for (int i = 0; i < IR_WORKERS; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "web_ir%d", i);
+    if (xTaskCreate(web_ir_worker, name, 4096, NULL, 5, NULL) == pdPASS)
+      started++;
+  }
+  if (started == 0) {
+    vQueueDelete(s_ir_queue);
+    s_ir_queue = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  ESP_LOGI(TAG, "%d IR worker(s), queue %d", started, IR_QUEUE_LEN);
+  return ESP_OK;
+}
+
+static void ir_send_busy(httpd_req_t *req) {
+  httpd_resp_set_status(req, "503 Service Unavailable");
+  httpd_resp_set_hdr(req, "Retry-After", "1");
+  httpd_resp_send(req, "IR busy", HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t web_ir_admit(httpd_req_t *req, const web_limit_target_t *targets,
+                       size_t n) {
+  // Refuse while the queue is full rather than parking more clients on
+  // httpd sockets that will only get a 503 later
+  if (s_ir_queue && uxQueueSpacesAvailable(s_ir_queue) == 0) {
+    ir_send_busy(req);
+    return ESP_ERR_NO_MEM;
+  }
+
+  uint32_t retry_s;
+  esp_err_t err = web_limit_ir_take(req, targets, n, &retry_s);
+  if (err == ESP_ERR_INVALID_SIZE) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                        "More transmissions than the rate limit allows");
+    return err;
+  }
+  if (err != ESP_OK) {
+    char val[12];
+    snprintf(val, sizeof(val), "%" PRIu32, retry_s);
+    ESP_LOGW(TAG, "Rate limited: %s%s (retry in %" PRIu32 " s)",
+             targets[0].kind == WEB_LIMIT_KEY ? targets[0].key
+             : targets[0].kind == WEB_LIMIT_AC ? "ac"
+                                               : "raw",
+             n > 1 ? " and others" : "", retry_s);
+    httpd_resp_set_status(req, "429 Too Many Requests");
+    httpd_resp_set_hdr(req, "Retry-After", val);
+    httpd_resp_send(req, "Too many IR requests", HTTPD_RESP_USE_STRLEN);
+    return err;
+  }
+  return ESP_OK;
+}
+
+static esp_err_t web_ir_enqueue(httpd_req_t *req, ir_job_t job, bool async) {
+  if (!s_ir_queue) {
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                        "IR workers not running");
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  // A backlog means the client would wait for other jobs' airtime as well
+  if (uxQueueMessagesWaiting(s_ir_queue) >= IR_WORKERS)
+    async = true;
+
+  if (uxQueueSpacesAvailable(s_ir_queue) == 0) {
+    ir_send_busy(req);
+    return ESP_ERR_NO_MEM;
+  }
+
+  job.id = ir_job_create(job.type);
+  if (!async) {
+    if (httpd_req_async_handler_begin(req, &job.req) == ESP_OK)
+      job.mark = web_perf_detach();
+    else
+      async = true; // Could not detach: fall back to answering now
+  }
+
+  if (xQueueSend(s_ir_queue, &job, 0) != pdTRUE) {
+    ir_job_set_state(job.id, IR_JOB_FAILED, ESP_ERR_NO_MEM);
+    if (job.req) {
+      httpd_resp_send_err(job.req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                          "IR queue full");
+      web_perf_complete(&job.mark, ESP_ERR_NO_MEM);
+      httpd_req_async_handler_complete(job.req);
+    } else {
+      httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                          "IR queue full");
+    }
+    return ESP_ERR_NO_MEM;
+  }
+
+  if (async)
+    ir_job_send_accepted(req, job.id);
+  return ESP_OK;
+}
+
+esp_err_t web_ir_submit(httpd_req_t *req, web_ir_job_type_t type,
+                        const char *key, bool async) {
+  ir_job_t job = {.type = type};
+  if (key)
+    strncpy(job.key, key, sizeof(job.key) - 1);
+  return web_ir_enqueue(req, job, async);
+}
+
+esp_err_t web_ir_submit_batch(httpd_req_t *req, web_batch_t *batch,
+                              bool async) {
+  ir_job_t job = {.type = WEB_IR_JOB_BATCH, .batch = batch};
+  esp_err_t err = web_ir_enqueue(req, job, async);
+  if (err != ESP_OK)
+    web_batch_free(batch);
+  return err;
+}
+
+esp_err_t web_ir_job_handler(httpd_req_t *req) {
+  web_req_query_t q;
+  char val[12];
+  web_req_query_load(req, &q);
+  if (web_req_query_str(&q, "id", val, sizeof(val)) != ESP_OK) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing id");
+    return ESP_OK;
+  }
+
+  uint32_t id = strtoul(val, NULL, 10);
+  ir_job_record_t rec;
+  taskENTER_CRITICAL(&s_ir_lock);
+  rec = s_history[id % IR_JOB_HISTORY];
+  taskEXIT_CRITICAL(&s_ir_lock);
+  if (id == 0 || rec.id != id) {
+    httpd_resp_send_404(req); // Unknown or aged out of the history
+    return ESP_OK;
+  }
+
+  web_json_t w;
+  web_json_begin(&w, req);
+  web_json_obj_open(&w, NULL);
+  web_json_uint(&w, "job", rec.id);
+  web_json_str(&w, "type", rec.type == WEB_IR_JOB_KEY  ? "key"
+                           : rec.type == WEB_IR_JOB_AC ? "ac"
+                                                       : "batch");
+  web_json_str(&w, "state", ir_job_state_str(rec.state));
+  if (rec.err != ESP_OK)
+    web_json_str(&w, "error", esp_err_to_name(rec.err));
+  web_json_obj_close(&w);
+  return web_json_end(&w);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file web_ir.h
+ * @brief IR transmit jobs for the web API
+ *
+ * Requests that put IR on the air are detached from the httpd task and run
+ * by a small worker pool, so other clients are served while a multi-frame
+ * burst is transmitting. The response is sent when the transmission has
+ * finished, or straight away as 202 with a job id when the caller asked for
+ * ?async=1, the pool is backlogged, or the transmission takes longer than
+ * CONFIG_APP_WEB_IR_WAIT_MS. GET /api/ir/job?id=N reports the outcome.
+ *
+ * Handlers call web_ir_admit() before acting on a request, so a full queue
+ * (503) or an exhausted rate limit (429, see web_limit.h) is answered
+ * before any state changes.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "web_batch.h"
+#include "web_limit.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  WEB_IR_JOB_KEY, // Stored key, by name
+  WEB_IR_JOB_AC,  // Current AC state (already updated by the handler)
+  WEB_IR_JOB_BATCH, // Validated /api/batch body (web_batch.h)
+} web_ir_job_type_t;
+
+/**
+ * @brief Start the worker pool
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t web_ir_init(void);
+
+/**
+ * @brief Check that the transmissions of a request may be queued now
+ *
+ * Answers the request with 503 when the job queue is full, with 429 and
+ * Retry-After when the client or a target is over its rate limit, or with
+ * 400 when it asks for more transmissions than a burst allows.
+ *
+ * @param req Request being handled
+ * @param targets One entry per transmission the request will make
+ * @param n Number of entries; 0 only checks the queue
+ * @return esp_err_t ESP_OK if the caller should go ahead, otherwise the
+ *         response has been sent
+ */
+esp_err_t web_ir_admit(httpd_req_t *req, const web_limit_target_t *targets,
+                       size_t n);
+
+/**
+ * @brief Queue an IR job and answer the request
+ *
+ * Either detaches req (the worker responds once the job is done) or
+ * responds immediately with 202 and the job id. Always produces exactly
+ * one response.
+ *
+ * @param req Request being handled
+ * @param type Job type
+ * @param key Key name for WEB_IR_JOB_KEY, NULL otherwise
+ * @param async Respond with 202 without waiting for the transmission
+ * @return esp_err_t ESP_OK if the job was queued
+ */
+esp_err_t web_ir_submit(httpd_req_t *req, web_ir_job_type_t type,
+                        const char *key, bool async);
+
+/**
+ * @brief Queue a validated batch (see web_batch.h) and answer the request
+ *
+ * Takes ownership of batch, including on failure.
+ *
+ * @param req Request being handled
+ * @param batch Batch to execute
+ * @param async Respond with 202 without waiting for the batch
+ * @return esp_err_t ESP_OK if the job was queued
+ */
+esp_err_t web_ir_submit_batch(httpd_req_t *req, web_batch_t *batch,
+                              bool async);
+
+/**
+ * @brief GET /api/ir/job?id=N handler
+ */
+esp_err_t web_ir_job_handler(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
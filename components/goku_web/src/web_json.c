@@ -0,0 +1,253 @@
+#include "web_json.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static void web_json_flush(web_json_t *w) {
+  if (w->err != ESP_OK || w->len == 0)
+    return;
+  w->err = httpd_resp_send_chunk(w->req, w->buf, w->len);
+  w->chunked = true;
+  w->len = 0;
+}
+
+static void web_json_put(web_json_t *w, const char *s, size_t n) {
+  while (n > 0 && w->err == ESP_OK) {
+    size_t room = sizeof(w->buf) - w->len;
+    if (room == 0) {
+      web_json_flush(w);
+      continue;
+    }
+    size_t take = n < room ? n : room;
+    memcpy(w->buf + w->len, s, take);
+    w->len += take;
+    s += take;
+    n -= take;
+  }
+}
+
+static void web_json_putc(web_json_t *w, char c) {
+  if (w->len == sizeof(w->buf))
+    web_json_flush(w);
+  if (w->err == ESP_OK)
+    w->buf[w->len++] = c;
+}
+
+static void web_json_put_escaped(web_json_t *w, const char *s) {
+  web_json_putc(w, '"');
+  const char *run = s; // Start of bytes that need no escaping
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+    web_json_put(w, run, s - run);
+    char esc[8];
+    int n;
+    if (c == '"' || c == '\\')
+      n = snprintf(esc, sizeof(esc), "\\%c", c);
+    else if (c == '\n')
+      n = snprintf(esc, sizeof(esc), "\\n");
+    else
+      n = snprintf(esc, sizeof(esc), "\\u%04x", c);
+    web_json_put(w, esc, n);
+    run = s + 1;
+  }
+  web_json_put(w, run, s - run);
+  web_json_putc(w, '"');
+}
+
+/* ---- CBOR encoding ---- */
+
+#define CBOR_UINT 0
+#define CBOR_NEGINT 1
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_SIMPLE 7
+#define CBOR_INDEFINITE 31
+#define CBOR_BREAK 0xff
+#define CBOR_FALSE 20
+#define CBOR_TRUE 21
+#define CBOR_FLOAT32 26
+#define CBOR_FLOAT64 27
+
+static void cbor_put_be(web_json_t *w, uint8_t initial, uint64_t val,
+                        int bytes) {
+  char out[9];
+  out[0] = (char)initial;
+  for (int i = 0; i < bytes; i++)
+    out[1 + i] = (char)(val >> (8 * (bytes - 1 - i)));
+  web_json_put(w, out, 1 + bytes);
+}
+
+// Initial byte and argument, in the shortest encoding
+static void cbor_put_head(web_json_t *w, uint8_t major, uint64_t arg) {
+  if (arg < 24) {
+    web_json_putc(w, (char)(major << 5 | arg));
+    return;
+  }
+  int bytes = 1;
+  uint8_t info = 24;
+  while (bytes < 8 && (arg >> (8 * bytes)) != 0) {
+    bytes *= 2;
+    info++;
+  }
+  cbor_put_be(w, major << 5 | info, arg, bytes);
+}
+
+static void cbor_put_text(web_json_t *w, const char *s) {
+  size_t n = strlen(s);
+  cbor_put_head(w, CBOR_TEXT, n);
+  web_json_put(w, s, n);
+}
+
+// Separator and member name before any value
+static void web_json_prefix(web_json_t *w, const char *key) {
+  if (w->cbor) {
+    if (key)
+      cbor_put_text(w, key);
+    return;
+  }
+  uint32_t bit = 1u << w->depth;
+  if (w->has_items & bit)
+    web_json_putc(w, ',');
+  w->has_items |= bit;
+  if (key) {
+    web_json_put_escaped(w, key);
+    web_json_putc(w, ':');
+  }
+}
+
+static void web_json_open(web_json_t *w, const char *key, char c) {
+  web_json_prefix(w, key);
+  if (w->cbor)
+    web_json_putc(w, (char)((c == '{' ? CBOR_MAP : CBOR_ARRAY) << 5 |
+                            CBOR_INDEFINITE));
+  else
+    web_json_putc(w, c);
+  if (w->depth + 1 >= WEB_JSON_MAX_DEPTH) {
+    w->err = ESP_ERR_INVALID_STATE;
+    return;
+  }
+  w->depth++;
+  w->has_items &= ~(1u << w->depth);
+}
+
+static void web_json_close(web_json_t *w, char c) {
+  if (w->depth > 0)
+    w->depth--;
+  web_json_putc(w, w->cbor ? (char)CBOR_BREAK : c);
+}
+
+void web_json_begin(web_json_t *w, httpd_req_t *req) {
+  w->req = req;
+  w->len = 0;
+  w->has_items = 0;
+  w->depth = 0;
+  w->chunked = false;
+  w->err = ESP_OK;
+
+  // API clients send a short Accept; a long browser list may come back
+  // truncated, which only matters to clients that never ask for CBOR
+  char accept[128];
+  esp_err_t err =
+      httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept));
+  w->cbor = (err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC) &&
+            strstr(accept, "application/cbor") != NULL;
+  httpd_resp_set_type(req, w->cbor ? "application/cbor" : "application/json");
+  httpd_resp_set_hdr(req, "Vary", "Accept");
+}
+
+esp_err_t web_json_end(web_json_t *w) {
+  if (w->err != ESP_OK)
+    return w->err;
+  if (!w->chunked) // Fits in the buffer: plain response, no chunk framing
+    return httpd_resp_send(w->req, w->buf, w->len);
+  web_json_flush(w);
+  if (w->err == ESP_OK)
+    w->err = httpd_resp_send_chunk(w->req, NULL, 0);
+  return w->err;
+}
+
+void web_json_obj_open(web_json_t *w, const char *key) {
+  web_json_open(w, key, '{');
+}
+
+void web_json_obj_close(web_json_t *w) { web_json_close(w, '}'); }
+
+void web_json_arr_open(web_json_t *w, const char *key) {
+  web_json_open(w, key, '[');
+}
+
+void web_json_arr_close(web_json_t *w) { web_json_close(w, ']'); }
+
+void web_json_str(web_json_t *w, const char *key, const char *val) {
+  web_json_prefix(w, key);
+  if (w->cbor)
+    cbor_put_text(w, val ? val : "");
+  else
+    web_json_put_escaped(w, val ? val : "");
+}
+
+void web_json_int(web_json_t *w, const char *key, int64_t val) {
+  if (w->cbor) {
+    web_json_prefix(w, key);
+    if (val >= 0)
+      cbor_put_head(w, CBOR_UINT, (uint64_t)val);
+    else
+      cbor_put_head(w, CBOR_NEGINT, (uint64_t)(-(val + 1)));
+    return;
+  }
+  char num[24];
+  int n = snprintf(num, sizeof(num), "%" PRId64, val);
+  web_json_prefix(w, key);
+  web_json_put(w, num, n);
+}
+
+void web_json_uint(web_json_t *w, const char *key, uint64_t val) {
+  if (w->cbor) {
+    web_json_prefix(w, key);
+    cbor_put_head(w, CBOR_UINT, val);
+    return;
+  }
+  char num[24];
+  int n = snprintf(num, sizeof(num), "%" PRIu64, val);
+  web_json_prefix(w, key);
+  web_json_put(w, num, n);
+}
+
+void web_json_double(web_json_t *w, const char *key, double val) {
+  if (w->cbor) {
+    web_json_prefix(w, key);
+    float f = (float)val;
+    if ((double)f == val || isnan(val)) { // Single precision is lossless
+      uint32_t bits;
+      memcpy(&bits, &f, sizeof(bits));
+      cbor_put_be(w, CBOR_SIMPLE << 5 | CBOR_FLOAT32, bits, 4);
+    } else {
+      uint64_t bits;
+      memcpy(&bits, &val, sizeof(bits));
+      cbor_put_be(w, CBOR_SIMPLE << 5 | CBOR_FLOAT64, bits, 8);
+    }
+    return;
+  }
+  char num[32];
+  int n;
+  if (isfinite(val))
+    n = snprintf(num, sizeof(num), "%g", val);
+  else
+    n = snprintf(num, sizeof(num), "null"); // Not representable in JSON
+  web_json_prefix(w, key);
+  web_json_put(w, num, n);
+}
+
+void web_json_bool(web_json_t *w, const char *key, bool val) {
+  web_json_prefix(w, key);
+  if (w->cbor)
+    web_json_putc(w, (char)(CBOR_SIMPLE << 5 | (val ? CBOR_TRUE : CBOR_FALSE)));
+  else if (val)
+    web_json_put(w, "true", 4);
+  else
+    web_json_put(w, "false", 5);
+}
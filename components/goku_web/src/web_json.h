@@ -0,0 +1,93 @@
+/**
+ * @file web_json.h
+ * @brief Allocation-free streaming JSON/CBOR response writer
+ *
+ * Values are serialized straight into a fixed buffer held in the writer
+ * (normally on the handler's stack). When the buffer fills it is flushed as
+ * an HTTP chunk; responses that fit are sent in one piece with a
+ * Content-Length instead. Errors are sticky: after a failed send every
+ * further call is a no-op and web_json_end() reports the error.
+ *
+ * The same calls produce CBOR (RFC 8949) when the client sends
+ * "Accept: application/cbor", so each endpoint describes its schema once.
+ * Objects and arrays are then indefinite-length maps and arrays, since the
+ * member count is not known while streaming.
+ *
+ * @code
+ *   web_json_t w;
+ *   web_json_begin(&w, req);
+ *   web_json_obj_open(&w, NULL);
+ *   web_json_int(&w, "temp", 24);
+ *   web_json_obj_close(&w);
+ *   return web_json_end(&w);
+ * @endcode
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WEB_JSON_BUF_SIZE 512
+#define WEB_JSON_MAX_DEPTH 32
+
+typedef struct {
+  httpd_req_t *req;
+  size_t len;
+  uint32_t has_items; // Bit per nesting level: next value needs a comma
+  uint8_t depth;
+  bool chunked; // At least one chunk already sent
+  bool cbor;    // Encode as CBOR instead of JSON
+  esp_err_t err;
+  char buf[WEB_JSON_BUF_SIZE];
+} web_json_t;
+
+/**
+ * @brief Start a response, choosing JSON or CBOR from the Accept header
+ *
+ * Sets Content-Type and "Vary: Accept".
+ *
+ * @param w Writer
+ * @param req Request being answered
+ */
+void web_json_begin(web_json_t *w, httpd_req_t *req);
+
+/**
+ * @brief Finish the response, sending whatever is buffered
+ *
+ * @param w Writer
+ * @return esp_err_t ESP_OK if the whole document was sent
+ */
+esp_err_t web_json_end(web_json_t *w);
+
+/**
+ * @brief Open an object or array
+ *
+ * @param w Writer
+ * @param key Member name inside an object, NULL inside an array or at the
+ *            top level
+ */
+void web_json_obj_open(web_json_t *w, const char *key);
+void web_json_obj_close(web_json_t *w);
+void web_json_arr_open(web_json_t *w, const char *key);
+void web_json_arr_close(web_json_t *w);
+
+/**
+ * @brief Write a value (key as for web_json_obj_open)
+ */
+void web_json_str(web_json_t *w, const char *key, const char *val);
+void web_json_int(web_json_t *w, const char *key, int64_t val);
+void web_json_uint(web_json_t *w, const char *key, uint64_t val);
+void web_json_double(web_json_t *w, const char *key, double val);
+void web_json_bool(web_json_t *w, const char *key, bool val);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,215 @@
+#include "web_limit.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/sockets.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#define LIMIT_CLIENTS 8
+#define LIMIT_TARGETS 16
+#define LIMIT_MILLI 1000 // Tokens are kept in thousandths
+#define LIMIT_HASH_SEED 2166136261u
+
+_Static_assert(WEB_LIMIT_MAX_TARGETS <= LIMIT_TARGETS,
+               "One request's targets must fit the table at once");
+
+typedef struct {
+  uint32_t key; // Hash of the client address or target
+  bool used;
+  uint32_t pass; // Last web_limit_ir_take() call that used the bucket
+  int32_t tokens; // LIMIT_MILLI per request
+  int64_t last_us;
+} limit_bucket_t;
+
+typedef struct {
+  uint32_t per_min; // 0 = unlimited
+  uint32_t burst;
+} limit_rate_t;
+
+static const limit_rate_t s_client_rate = {CONFIG_APP_WEB_IR_CLIENT_PER_MIN,
+                                           CONFIG_APP_WEB_IR_CLIENT_BURST};
+static const limit_rate_t s_target_rate = {CONFIG_APP_WEB_IR_TARGET_PER_MIN,
+                                           CONFIG_APP_WEB_IR_TARGET_BURST};
+
+static limit_bucket_t s_clients[LIMIT_CLIENTS];
+static limit_bucket_t s_targets[LIMIT_TARGETS];
+static web_limit_stats_t s_stats;
+static uint32_t s_pass;
+static portMUX_TYPE s_limit_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t limit_hash(uint32_t h, const void *data, size_t len) {
+  const uint8_t *p = data;
+  for (size_t i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// Hash of the peer address; IPv4 clients on an IPv6 socket arrive
+// v4-mapped, which is still one stable address per client
+static uint32_t limit_client_key(httpd_req_t *req) {
+  struct sockaddr_storage addr;
+  socklen_t len = sizeof(addr);
+  int fd = httpd_req_to_sockfd(req);
+  if (fd < 0 || getpeername(fd, (struct sockaddr *)&addr, &len) != 0)
+    return 0; // Unknown clients share one bucket
+
+  if (addr.ss_family == AF_INET) {
+    const struct sockaddr_in *in = (const struct sockaddr_in *)&addr;
+    return limit_hash(LIMIT_HASH_SEED, &in->sin_addr, sizeof(in->sin_addr));
+  }
+#ifdef CONFIG_LWIP_IPV6
+  if (addr.ss_family == AF_INET6) {
+    const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)&addr;
+    return limit_hash(LIMIT_HASH_SEED, &in6->sin6_addr, sizeof(in6->sin6_addr));
+  }
+#endif
+  return 0;
+}
+
+// The kind is hashed in, so a key named like another kind's target still
+// has a bucket of its own
+static uint32_t limit_target_key(const web_limit_target_t *t) {
+  uint8_t kind = t->kind;
+  uint32_t h = limit_hash(LIMIT_HASH_SEED, &kind, sizeof(kind));
+  if (t->kind == WEB_LIMIT_KEY)
+    h = limit_hash(h, t->key, strlen(t->key));
+  return h;
+}
+
+// Find the bucket for key, recycling the least recently used one on a miss.
+// Buckets already used in this pass are never recycled. A fresh bucket
+// starts full; a recycled one keeps the level of the bucket it replaces, so
+// a client pushed out of the table cannot come back to a full burst.
+static limit_bucket_t *limit_bucket(limit_bucket_t *table, size_t n,
+                                    uint32_t key, const limit_rate_t *rate,
+                                    int64_t now) {
+  limit_bucket_t *victim = NULL;
+  for (size_t i = 0; i < n; i++) {
+    limit_bucket_t *b = &table[i];
+    if (b->used && b->key == key) {
+      b->pass = s_pass;
+      return b;
+    }
+    if (b->used && b->pass == s_pass)
+      continue;
+    if (!victim || (victim->used && (!b->used || b->last_us < victim->last_us)))
+      victim = b;
+  }
+  if (!victim->used) {
+    victim->tokens = rate->burst * LIMIT_MILLI;
+    victim->last_us = now;
+  }
+  victim->key = key;
+  victim->used = true;
+  victim->pass = s_pass;
+  return victim;
+}
+
+static void limit_refill(limit_bucket_t *b, const limit_rate_t *rate,
+                         int64_t now) {
+  int64_t cap = (int64_t)rate->burst * LIMIT_MILLI;
+  int64_t gained = (now - b->last_us) * rate->per_min / 60000;
+  int64_t tokens = b->tokens + gained;
+  b->tokens = tokens > cap ? cap : tokens;
+  // Keep the remainder of a partial token by only advancing by what it
+  // paid for
+  if (tokens >= cap || rate->per_min == 0)
+    b->last_us = now;
+  else
+    b->last_us += gained * 60000 / rate->per_min;
+}
+
+// Seconds until the bucket holds count whole tokens, rounded up
+static uint32_t limit_wait_s(const limit_bucket_t *b, const limit_rate_t *rate,
+                             uint32_t count) {
+  int64_t need = (int64_t)count * LIMIT_MILLI - b->tokens;
+  int64_t wait_us = need * 60000 / rate->per_min;
+  return (uint32_t)((wait_us + 999999) / 1000000);
+}
+
+esp_err_t web_limit_ir_take(httpd_req_t *req,
+                            const web_limit_target_t *targets, size_t n,
+                            uint32_t *retry_s) {
+  bool limit_client = s_client_rate.per_min > 0;
+  bool limit_target = s_target_rate.per_min > 0;
+  *retry_s = 0;
+  if (n > WEB_LIMIT_MAX_TARGETS)
+    return ESP_ERR_INVALID_SIZE;
+  if (n == 0 || (!limit_client && !limit_target))
+    return ESP_OK;
+
+  // Repeats of a target are charged to its bucket together
+  uint32_t keys[WEB_LIMIT_MAX_TARGETS];
+  uint32_t counts[WEB_LIMIT_MAX_TARGETS];
+  size_t nkeys = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint32_t key = limit_target_key(&targets[i]);
+    size_t j = 0;
+    while (j < nkeys && keys[j] != key)
+      j++;
+    if (j == nkeys) {
+      keys[nkeys] = key;
+      counts[nkeys++] = 0;
+    }
+    if (++counts[j] > s_target_rate.burst && limit_target)
+      return ESP_ERR_INVALID_SIZE;
+  }
+  if (limit_client && n > s_client_rate.burst)
+    return ESP_ERR_INVALID_SIZE;
+
+  uint32_t client_key = limit_client ? limit_client_key(req) : 0;
+  int64_t now = esp_timer_get_time();
+
+  taskENTER_CRITICAL(&s_limit_lock);
+  s_pass++;
+  limit_bucket_t *c = NULL;
+  limit_bucket_t *t[WEB_LIMIT_MAX_TARGETS] = {NULL};
+  uint32_t wait_s = 0;
+  bool client_ok = true;
+  bool target_ok = true;
+  if (limit_client) {
+    c = limit_bucket(s_clients, LIMIT_CLIENTS, client_key, &s_client_rate,
+                     now);
+    limit_refill(c, &s_client_rate, now);
+    if (c->tokens < (int32_t)n * LIMIT_MILLI) {
+      client_ok = false;
+      wait_s = limit_wait_s(c, &s_client_rate, n);
+    }
+  }
+  for (size_t j = 0; limit_target && j < nkeys; j++) {
+    t[j] = limit_bucket(s_targets, LIMIT_TARGETS, keys[j], &s_target_rate,
+                        now);
+    limit_refill(t[j], &s_target_rate, now);
+    if (t[j]->tokens < (int32_t)counts[j] * LIMIT_MILLI) {
+      target_ok = false;
+      uint32_t w = limit_wait_s(t[j], &s_target_rate, counts[j]);
+      if (w > wait_s)
+        wait_s = w;
+    }
+  }
+
+  if (client_ok && target_ok) {
+    if (c)
+      c->tokens -= n * LIMIT_MILLI;
+    for (size_t j = 0; j < nkeys; j++) {
+      if (t[j])
+        t[j]->tokens -= counts[j] * LIMIT_MILLI;
+    }
+  } else {
+    *retry_s = wait_s;
+    if (!client_ok)
+      s_stats.client_limited++;
+    else
+      s_stats.target_limited++;
+  }
+  taskEXIT_CRITICAL(&s_limit_lock);
+  return client_ok && target_ok ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+void web_limit_get_stats(web_limit_stats_t *out) {
+  taskENTER_CRITICAL(&s_limit_lock);
+  *out = s_stats;
+  taskEXIT_CRITICAL(&s_limit_lock);
+}
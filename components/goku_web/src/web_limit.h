@@ -0,0 +1,72 @@
+/**
+ * @file web_limit.h
+ * @brief Token-bucket rate limits for IR transmit requests
+ *
+ * Every transmission requested over HTTP costs one token from the bucket
+ * of the client address and one from the bucket of its target (a stored
+ * key, the AC state or raw frames), including each transmission inside a
+ * /api/batch request. Buckets refill continuously at the rate set
+ * in Kconfig up to their burst size, so a dashboard user tapping buttons
+ * is never limited while an automation loop stuck on one key is. A small
+ * fixed table holds the most recently seen clients and targets.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Most transmissions one request may ask for (the /api/batch maximum) */
+#define WEB_LIMIT_MAX_TARGETS 16
+
+typedef enum {
+  WEB_LIMIT_KEY, // Stored key, by name
+  WEB_LIMIT_AC,  // AC state
+  WEB_LIMIT_RAW, // Raw durations, all sharing one bucket
+} web_limit_kind_t;
+
+/** Target of one transmission; kinds never share a bucket */
+typedef struct {
+  web_limit_kind_t kind;
+  const char *key; // WEB_LIMIT_KEY only
+} web_limit_target_t;
+
+typedef struct {
+  uint32_t client_limited; // Requests refused by a client bucket
+  uint32_t target_limited; // Requests refused by a target bucket
+} web_limit_stats_t;
+
+/**
+ * @brief Take tokens for the transmissions a request asks for
+ *
+ * The client pays one token per transmission and each target one per
+ * transmission to it. Tokens are taken from every bucket or from none.
+ *
+ * @param req Request being handled, identifies the client address
+ * @param targets One entry per transmission
+ * @param n Number of entries, at most WEB_LIMIT_MAX_TARGETS
+ * @param retry_s Set to the seconds until the request would be allowed
+ * @return esp_err_t ESP_OK if the request may go ahead,
+ *         ESP_ERR_INVALID_STATE if it is over a limit for now, or
+ *         ESP_ERR_INVALID_SIZE if it asks for more than a burst allows and
+ *         can never be admitted
+ */
+esp_err_t web_limit_ir_take(httpd_req_t *req,
+                            const web_limit_target_t *targets, size_t n,
+                            uint32_t *retry_s);
+
+/**
+ * @brief Snapshot of the rejection counters
+ */
+void web_limit_get_stats(web_limit_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,229 @@
+#include "web_perf.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+#include "web_json.h"
+#include "web_req.h"
+#include <string.h>
+
+#define TAG "web_perf"
+
+#define PERF_MAX_ROUTES 48
+
+// Bucket upper bounds; the last bucket catches everything slower
+static const uint32_t s_bucket_ms[] = {1,  2,   5,   10,  20,  50,
+                                       100, 200, 500, 1000, 2000};
+#define PERF_BUCKETS (sizeof(s_bucket_ms) / sizeof(s_bucket_ms[0]) + 1)
+
+typedef struct {
+  uint32_t count;
+  uint32_t max_us;
+  uint64_t total_us;
+  uint32_t buckets[PERF_BUCKETS];
+} perf_hist_t;
+
+struct web_perf_route {
+  const char *uri;
+  httpd_method_t method;
+  uint32_t errors;
+  uint32_t inflight;
+  perf_hist_t latency;
+  perf_hist_t ttfb;
+};
+
+static web_perf_route_t s_routes[PERF_MAX_ROUTES];
+static int s_route_count = 0;
+static portMUX_TYPE s_perf_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Handler being run by the httpd task, for web_perf_mark()
+static web_perf_route_t *s_current = NULL;
+static int64_t s_current_start = 0;
+static bool s_current_detached = false;
+
+static void perf_hist_add(perf_hist_t *h, uint32_t us) {
+  size_t b = 0;
+  while (b < PERF_BUCKETS - 1 && us > s_bucket_ms[b] * 1000)
+    b++;
+  h->buckets[b]++;
+  h->count++;
+  h->total_us += us;
+  if (us > h->max_us)
+    h->max_us = us;
+}
+
+static uint32_t perf_elapsed_us(int64_t start_us) {
+  int64_t d = esp_timer_get_time() - start_us;
+  return d > UINT32_MAX ? UINT32_MAX : (uint32_t)d;
+}
+
+web_perf_route_t *web_perf_route_add(const char *uri, httpd_method_t method) {
+  if (s_route_count >= PERF_MAX_ROUTES) {
+    ESP_LOGW(TAG, "Route table full, %s not timed", uri);
+    return NULL;
+  }
+  web_perf_route_t *route = &s_routes[s_route_count++];
+  memset(route, 0, sizeof(*route));
+  route->uri = uri;
+  route->method = method;
+  return route;
+}
+
+// Account a finished request: the handler's return, or the response to a
+// detached request
+static void perf_finish(web_perf_route_t *route, int64_t start,
+                        esp_err_t err) {
+  uint32_t us = perf_elapsed_us(start);
+
+  taskENTER_CRITICAL(&s_perf_lock);
+  route->inflight--;
+  if (err != ESP_OK)
+    route->errors++;
+  perf_hist_add(&route->latency, us);
+  taskEXIT_CRITICAL(&s_perf_lock);
+
+#if CONFIG_APP_WEB_PERF_SLOW_MS > 0
+  if (us >= CONFIG_APP_WEB_PERF_SLOW_MS * 1000) {
+    ESP_LOGW(TAG, "Slow %s %s: %lu ms%s", http_method_str(route->method),
+             route->uri, (unsigned long)(us / 1000),
+             err != ESP_OK ? " (failed)" : "");
+  }
+#endif
+}
+
+esp_err_t web_perf_run(web_perf_route_t *route,
+                       esp_err_t (*handler)(httpd_req_t *req),
+                       httpd_req_t *req) {
+  if (!route)
+    return handler(req);
+
+  taskENTER_CRITICAL(&s_perf_lock);
+  route->inflight++;
+  taskEXIT_CRITICAL(&s_perf_lock);
+
+  int64_t start = esp_timer_get_time();
+  s_current = route;
+  s_current_start = start;
+  s_current_detached = false;
+  esp_err_t err = handler(req);
+  s_current = NULL;
+
+  // A detached request is accounted by web_perf_complete()
+  if (!s_current_detached)
+    perf_finish(route, start, err);
+  return err;
+}
+
+// Registered URIs carry the original httpd_uri_t in user_ctx
+typedef struct {
+  httpd_uri_t uri;
+  web_perf_route_t *route;
+} perf_wrapped_t;
+
+static perf_wrapped_t s_wrapped[4]; // Pages and endpoints outside the router
+static int s_wrapped_count = 0;
+
+static esp_err_t web_perf_wrapper(httpd_req_t *req) {
+  const perf_wrapped_t *wrapped = req->user_ctx;
+  req->user_ctx = wrapped->uri.user_ctx;
+  return web_perf_run(wrapped->route, wrapped->uri.handler, req);
+}
+
+esp_err_t web_perf_register(httpd_handle_t server, const httpd_uri_t *uri) {
+  if (s_wrapped_count >= (int)(sizeof(s_wrapped) / sizeof(s_wrapped[0])))
+    return httpd_register_uri_handler(server, uri);
+
+  perf_wrapped_t *w = &s_wrapped[s_wrapped_count];
+  w->uri = *uri;
+  w->route = web_perf_route_add(uri->uri, uri->method);
+  if (!w->route)
+    return httpd_register_uri_handler(server, uri);
+
+  httpd_uri_t reg = *uri;
+  reg.handler = web_perf_wrapper;
+  reg.user_ctx = w;
+  esp_err_t err = httpd_register_uri_handler(server, &reg);
+  if (err == ESP_OK)
+    s_wrapped_count++;
+  return err;
+}
+
+web_perf_mark_t web_perf_mark(void) {
+  return (web_perf_mark_t){.route = s_current, .start_us = s_current_start};
+}
+
+web_perf_mark_t web_perf_detach(void) {
+  if (s_current)
+    s_current_detached = true;
+  return web_perf_mark();
+}
+
+void web_perf_complete(const web_perf_mark_t *mark, esp_err_t err) {
+  if (mark->route)
+    perf_finish(mark->route, mark->start_us, err);
+}
+
+void web_perf_first_byte(const web_perf_mark_t *mark) {
+  if (!mark->route)
+    return;
+  uint32_t us = perf_elapsed_us(mark->start_us);
+  taskENTER_CRITICAL(&s_perf_lock);
+  perf_hist_add(&mark->route->ttfb, us);
+  taskEXIT_CRITICAL(&s_perf_lock);
+}
+
+static void perf_write_hist(web_json_t *w, const perf_hist_t *h) {
+  web_json_uint(w, "count", h->count);
+  web_json_uint(w, "avg_us", h->count ? h->total_us / h->count : 0);
+  web_json_uint(w, "max_us", h->max_us);
+  web_json_arr_open(w, "hist");
+  for (size_t b = 0; b < PERF_BUCKETS; b++)
+    web_json_uint(w, NULL, h->buckets[b]);
+  web_json_arr_close(w);
+}
+
+esp_err_t web_perf_handler(httpd_req_t *req) {
+  web_req_query_t q;
+  web_req_query_load(req, &q);
+  bool reset = web_req_query_flag(&q, "reset");
+
+  web_json_t w;
+  web_json_begin(&w, req);
+  web_json_obj_open(&w, NULL);
+  web_json_uint(&w, "uptime_ms", esp_timer_get_time() / 1000);
+  web_json_arr_open(&w, "buckets_ms"); // Upper bounds; one more for the rest
+  for (size_t b = 0; b < PERF_BUCKETS - 1; b++)
+    web_json_uint(&w, NULL, s_bucket_ms[b]);
+  web_json_arr_close(&w);
+
+  web_json_arr_open(&w, "routes");
+  for (int i = 0; i < s_route_count; i++) {
+    // Copy under the lock, serialize outside it
+    web_perf_route_t r;
+    taskENTER_CRITICAL(&s_perf_lock);
+    r = s_routes[i];
+    if (reset) {
+      s_routes[i].errors = 0;
+      memset(&s_routes[i].latency, 0, sizeof(perf_hist_t));
+      memset(&s_routes[i].ttfb, 0, sizeof(perf_hist_t));
+    }
+    taskEXIT_CRITICAL(&s_perf_lock);
+
+    web_json_obj_open(&w, NULL);
+    web_json_str(&w, "uri", r.uri);
+    web_json_str(&w, "method", http_method_str(r.method));
+    web_json_uint(&w, "errors", r.errors);
+    web_json_uint(&w, "inflight", r.inflight);
+    perf_write_hist(&w, &r.latency);
+    if (r.ttfb.count) {
+      web_json_obj_open(&w, "ttfb");
+      perf_write_hist(&w, &r.ttfb);
+      web_json_obj_close(&w);
+    }
+    web_json_obj_close(&w);
+  }
+  web_json_arr_close(&w);
+
+  web_json_obj_close(&w);
+  return web_json_end(&w);
+}
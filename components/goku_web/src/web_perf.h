@@ -0,0 +1,105 @@
+/**
+ * @file web_perf.h
+ * @brief Per-route request counters and latency histograms
+ *
+ * Every route (web_router.h, or web_perf_register() for URIs registered
+ * with httpd directly) runs behind a thin wrapper that times the handler
+ * and keeps, per route, the request count, handler failures, requests in
+ * flight and a fixed-bucket histogram. A handler that detaches its request
+ * calls web_perf_detach(), and the request is then timed until
+ * web_perf_complete() from the task that answers it, so the figures cover
+ * the whole request and not just the hand-off. The overhead is two
+ * esp_timer reads and a short critical section, so it stays enabled in
+ * production. Requests slower than CONFIG_APP_WEB_PERF_SLOW_MS are logged.
+ * GET /api/system/perf reports the figures.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct web_perf_route web_perf_route_t;
+
+/**
+ * @brief Running request captured for a later time-to-first-byte sample or,
+ *        from web_perf_detach(), for finishing its timing
+ */
+typedef struct {
+  web_perf_route_t *route; // NULL if not called from a wrapped handler
+  int64_t start_us;
+} web_perf_mark_t;
+
+/**
+ * @brief Allocate counters for a route
+ *
+ * @param uri Path (must stay valid, normally a string literal)
+ * @param method HTTP method
+ * @return web_perf_route_t* Counters, or NULL when the table is full
+ */
+web_perf_route_t *web_perf_route_add(const char *uri, httpd_method_t method);
+
+/**
+ * @brief Run a handler and account it to route (NULL: just run it)
+ */
+esp_err_t web_perf_run(web_perf_route_t *route,
+                       esp_err_t (*handler)(httpd_req_t *req),
+                       httpd_req_t *req);
+
+/**
+ * @brief Register a URI handler with timing
+ *
+ * Falls back to a plain registration when the route table is full.
+ *
+ * @param server HTTP server
+ * @param uri Handler description (copied)
+ * @return esp_err_t Result of httpd_register_uri_handler()
+ */
+esp_err_t web_perf_register(httpd_handle_t server, const httpd_uri_t *uri);
+
+/**
+ * @brief Capture the route and start time of the running handler
+ *
+ * Only meaningful from a wrapped handler on the httpd task.
+ */
+web_perf_mark_t web_perf_mark(void);
+
+/**
+ * @brief Record time to first byte for a mark (any task)
+ */
+void web_perf_first_byte(const web_perf_mark_t *mark);
+
+/**
+ * @brief Note that the running handler has detached its request
+ *
+ * Call after a successful httpd_req_async_handler_begin(). The handler's
+ * return no longer ends the timing; web_perf_complete() does.
+ *
+ * @return web_perf_mark_t Mark to pass to web_perf_complete()
+ */
+web_perf_mark_t web_perf_detach(void);
+
+/**
+ * @brief Finish timing a detached request (any task)
+ *
+ * Call once the response has been sent, before
+ * httpd_req_async_handler_complete().
+ *
+ * @param mark Mark from web_perf_detach()
+ * @param err Outcome of the request; anything but ESP_OK counts as a failure
+ */
+void web_perf_complete(const web_perf_mark_t *mark, esp_err_t err);
+
+/**
+ * @brief GET /api/system/perf handler (?reset=1 clears after reporting)
+ */
+esp_err_t web_perf_handler(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,498 @@
+#include "web_req.h"
+#include "esp_log.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "web_req"
+
+#define WEB_REQ_RECV_RETRIES 3 // Consecutive socket timeouts tolerated
+
+esp_err_t web_req_recv_body(httpd_req_t *req, char *buf, size_t cap,
+                            size_t *len) {
+  if (len)
+    *len = 0;
+  if (req->content_len >= cap) {
+    ESP_LOGW(TAG, "%s: body of %u bytes exceeds %u", req->uri,
+             (unsigned int)req->content_len, (unsigned int)(cap - 1));
+    httpd_resp_set_status(req, "413 Payload Too Large");
+    httpd_resp_send(req, "Body too large", HTTPD_RESP_USE_STRLEN);
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  // Bodies may arrive in several TCP segments: keep reading until complete
+  size_t got = 0;
+  int timeouts = 0;
+  while (got < req->content_len) {
+    int ret = httpd_req_recv(req, buf + got, req->content_len - got);
+    if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < WEB_REQ_RECV_RETRIES)
+      continue;
+    if (ret <= 0) {
+      if (ret == HTTPD_SOCK_ERR_TIMEOUT)
+        httpd_resp_send_408(req);
+      else if (ret == 0)
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Truncated body");
+      return ESP_FAIL; // Socket errors close the connection, nothing to send
+    }
+    got += ret;
+    timeouts = 0;
+  }
+
+  buf[got] = '\0';
+  if (len)
+    *len = got;
+  return ESP_OK;
+}
+
+esp_err_t web_req_get_query(httpd_req_t *req, char *buf, size_t cap) {
+  size_t qlen = httpd_req_get_url_query_len(req);
+  if (qlen == 0)
+    return ESP_ERR_NOT_FOUND;
+  if (qlen >= cap)
+    return ESP_ERR_INVALID_SIZE;
+  return httpd_req_get_url_query_str(req, buf, cap);
+}
+
+esp_err_t web_req_query_load(httpd_req_t *req, web_req_query_t *q) {
+  q->buf[0] = '\0';
+  esp_err_t err = web_req_get_query(req, q->buf, sizeof(q->buf));
+  q->present = (err == ESP_OK);
+  if (err == ESP_ERR_NOT_FOUND)
+    return ESP_OK;
+  if (err != ESP_OK)
+    q->buf[0] = '\0';
+  return err;
+}
+
+esp_err_t web_req_query_str(const web_req_query_t *q, const char *key,
+                            char *dst, size_t cap) {
+  if (!q->present)
+    return ESP_ERR_NOT_FOUND;
+  esp_err_t err = httpd_query_key_value(q->buf, key, dst, cap);
+  if (err == ESP_ERR_HTTPD_RESULT_TRUNC)
+    return ESP_ERR_INVALID_SIZE;
+  return err == ESP_OK ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t web_req_query_int(const web_req_query_t *q, const char *key,
+                            int *out) {
+  char val[12];
+  esp_err_t err = web_req_query_str(q, key, val, sizeof(val));
+  if (err == ESP_ERR_INVALID_SIZE)
+    return ESP_ERR_INVALID_ARG; // Too many digits for an int
+  if (err != ESP_OK)
+    return err;
+
+  char *end;
+  long v = strtol(val, &end, 10);
+  if (end == val || *end != '\0' || v < INT_MIN || v > INT_MAX)
+    return ESP_ERR_INVALID_ARG;
+  *out = (int)v;
+  return ESP_OK;
+}
+
+bool web_req_query_flag(const web_req_query_t *q, const char *key) {
+  char val[6];
+  return web_req_query_str(q, key, val, sizeof(val)) == ESP_OK &&
+         (strcmp(val, "1") == 0 || strcmp(val, "true") == 0);
+}
+
+/* ---- JSON tokenizer ---- */
+
+static int tok_alloc(web_req_tok_t *toks, int *ntok, int max_toks,
+                     uint8_t type, size_t start, size_t end, int parent) {
+  if (*ntok >= max_toks)
+    return -1;
+  int idx = (*ntok)++;
+  toks[idx] = (web_req_tok_t){.type = type,
+                              .parent = (int16_t)parent,
+                              .start = (uint16_t)start,
+                              .end = (uint16_t)end,
+                              .size = 0};
+  if (parent >= 0)
+    toks[parent].size++;
+  return idx;
+}
+
+static bool tok_is_container(const web_req_tok_t *t) {
+  return t->type == WEB_REQ_TOK_OBJECT || t->type == WEB_REQ_TOK_ARRAY;
+}
+
+int web_req_json_parse(const char *js, size_t len, web_req_tok_t *toks,
+                       int max_toks) {
+  if (len > UINT16_MAX)
+    return -1;
+
+  int ntok = 0;
+  int cur = -1; // Token new values attach to
+  for (size_t pos = 0; pos < len; pos++) {
+    char c = js[pos];
+    switch (c) {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+      break;
+
+    case '{':
+    case '[': {
+      // end == 0 marks a container that is still open
+      int idx = tok_alloc(toks, &ntok, max_toks,
+                          c == '{' ? WEB_REQ_TOK_OBJECT : WEB_REQ_TOK_ARRAY,
+                          pos, 0, cur);
+      if (idx < 0)
+        return -1;
+      cur = idx;
+      break;
+    }
+
+    case '}':
+    case ']': {
+      uint8_t type = (c == '}') ? WEB_REQ_TOK_OBJECT : WEB_REQ_TOK_ARRAY;
+      while (cur >= 0 && !tok_is_container(&toks[cur]))
+        cur = toks[cur].parent; // Leave a key whose value just ended
+      if (cur < 0 || toks[cur].type != type || toks[cur].end != 0)
+        return -1;
+      toks[cur].end = (uint16_t)(pos + 1);
+      cur = toks[cur].parent;
+      break;
+    }
+
+    case '"': {
+      size_t start = pos + 1;
+      for (pos = start; pos < len && js[pos] != '"'; pos++) {
+        if ((unsigned char)js[pos] < 0x20)
+          return -1;
+        if (js[pos] == '\\' && ++pos >= len)
+          return -1;
+      }
+      if (pos >= len)
+        return -1; // Unterminated string
+      if (tok_alloc(toks, &ntok, max_toks, WEB_REQ_TOK_STRING, start, pos,
+                    cur) < 0)
+        return -1;
+      break;
+    }
+
+    case ':':
+      // The preceding string is a key; its value becomes its child
+      if (ntok == 0 || toks[ntok - 1].type != WEB_REQ_TOK_STRING ||
+          cur < 0 || toks[cur].type != WEB_REQ_TOK_OBJECT)
+        return -1;
+      cur = ntok - 1;
+      break;
+
+    case ',':
+      if (cur >= 0 && !tok_is_container(&toks[cur]))
+        cur = toks[cur].parent;
+      break;
+
+    default: {
+      if (c != '-' && (c < '0' || c > '9') && c != 't' && c != 'f' &&
+          c != 'n')
+        return -1;
+      size_t start = pos;
+      while (pos < len && js[pos] != ',' && js[pos] != '}' &&
+             js[pos] != ']' && js[pos] != ' ' && js[pos] != '\t' &&
+             js[pos] != '\r' && js[pos] != '\n' && js[pos] != ':')
+        pos++;
+      if (tok_alloc(toks, &ntok, max_toks, WEB_REQ_TOK_PRIMITIVE, start, pos,
+                    cur) < 0)
+        return -1;
+      pos--; // Re-examine the delimiter
+      break;
+    }
+    }
+  }
+
+  for (int i = 0; i < ntok; i++) {
+    if (tok_is_container(&toks[i]) && toks[i].end == 0)
+      return -1; // Unclosed object or array
+  }
+  return ntok;
+}
+
+int web_req_json_find(const char *js, const web_req_tok_t *toks, int ntok,
+                      int obj, const char *key) {
+  if (obj < 0 || obj >= ntok || toks[obj].type != WEB_REQ_TOK_OBJECT)
+    return -1;
+
+  size_t key_len = strlen(key);
+  int end = web_req_json_skip(toks, ntok, obj);
+  for (int i = obj + 1; i + 1 < end; i++) {
+    const web_req_tok_t *t = &toks[i];
+    if (t->parent != obj || t->type != WEB_REQ_TOK_STRING || t->size != 1)
+      continue;
+    if ((size_t)(t->end - t->start) == key_len &&
+        memcmp(js + t->start, key, key_len) == 0)
+      return i + 1; // A key's value is the next token
+  }
+  return -1;
+}
+
+int web_req_json_skip(const web_req_tok_t *toks, int ntok, int idx) {
+  // Tokens are in document order, so descendants end before the parent does
+  int i = idx + 1;
+  while (i < ntok && toks[i].start < toks[idx].end)
+    i++;
+  return i;
+}
+
+esp_err_t web_req_json_tok_int(const char *js, const web_req_tok_t *tok,
+                               int *out) {
+  if (tok->type != WEB_REQ_TOK_PRIMITIVE)
+    return ESP_ERR_INVALID_ARG;
+
+  const char *p = js + tok->start;
+  const char *end = js + tok->end;
+  if (end - p == 4 && memcmp(p, "true", 4) == 0) {
+    *out = 1;
+    return ESP_OK;
+  }
+  if (end - p == 5 && memcmp(p, "false", 5) == 0) {
+    *out = 0;
+    return ESP_OK;
+  }
+
+  bool neg = (*p == '-');
+  if (neg)
+    p++;
+  if (p == end || *p < '0' || *p > '9')
+    return ESP_ERR_INVALID_ARG;
+  long val = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; p++) {
+    if (val < 100000000) // Saturate instead of overflowing
+      val = val * 10 + (*p - '0');
+  }
+  *out = (int)(neg ? -val : val);
+  return ESP_OK;
+}
+
+static int hex_val(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+esp_err_t web_req_json_tok_str(const char *js, const web_req_tok_t *tok,
+                               char *dst, size_t cap) {
+  if (tok->type != WEB_REQ_TOK_STRING)
+    return ESP_ERR_INVALID_ARG;
+  if (cap == 0)
+    return ESP_ERR_INVALID_SIZE;
+
+  size_t n = 0;
+  for (size_t i = tok->start; i < tok->end; i++) {
+    char c = js[i];
+    if (c == '\\') {
+      c = js[++i];
+      switch (c) {
+      case 'n':
+        c = '\n';
+        break;
+      case 't':
+        c = '\t';
+        break;
+      case 'r':
+        c = '\r';
+        break;
+      case 'b':
+        c = '\b';
+        break;
+      case 'f':
+        c = '\f';
+        break;
+      case 'u': {
+        // Only ASCII is meaningful for keys and names; others become '?'
+        int cp = 0;
+        for (int k = 0; k < 4; k++) {
+          int h = (i + 1 < tok->end) ? hex_val(js[++i]) : -1;
+          if (h < 0)
+            return ESP_ERR_INVALID_ARG;
+          cp = (cp << 4) | h;
+        }
+        c = (cp > 0 && cp < 0x80) ? (char)cp : '?';
+        break;
+      }
+      default: // '"', '\\', '/'
+        break;
+      }
+    }
+    if (n + 1 >= cap)
+      return ESP_ERR_INVALID_SIZE;
+    dst[n++] = c;
+  }
+  dst[n] = '\0';
+  return ESP_OK;
+}
+
+esp_err_t web_req_json_int(const char *js, const web_req_tok_t *toks, int ntok,
+                           int obj, const char *key, int *out) {
+  int idx = web_req_json_find(js, toks, ntok, obj, key);
+  if (idx < 0)
+    return ESP_ERR_NOT_FOUND;
+  return web_req_json_tok_int(js, &toks[idx], out);
+}
+
+esp_err_t web_req_json_str(const char *js, const web_req_tok_t *toks, int ntok,
+                           int obj, const char *key, char *dst, size_t cap) {
+  int idx = web_req_json_find(js, toks, ntok, obj, key);
+  if (idx < 0)
+    return ESP_ERR_NOT_FOUND;
+  return web_req_json_tok_str(js, &toks[idx], dst, cap);
+}
+
+/* ---- CBOR reader ---- */
+
+#define CBOR_MAX_DEPTH 8 // Nesting accepted when skipping unknown members
+#define CBOR_BREAK 0xff
+
+typedef struct {
+  uint8_t major;
+  uint8_t info;  // Additional information (low 5 bits of the initial byte)
+  uint64_t arg;  // Value, length or count
+  bool indefinite;
+} cbor_head_t;
+
+static bool cbor_read_head(const uint8_t *buf, size_t len, size_t *pos,
+                           cbor_head_t *h) {
+  if (*pos >= len)
+    return false;
+  uint8_t ib = buf[(*pos)++];
+  h->major = ib >> 5;
+  h->info = ib & 0x1f;
+  h->arg = h->info;
+  h->indefinite = false;
+  if (h->info < 24)
+    return true;
+  if (h->info == 31) {
+    // Indefinite strings, arrays and maps; a lone break is handled by callers
+    h->indefinite = (h->major >= 2 && h->major <= 5);
+    return h->indefinite;
+  }
+  if (h->info > 27)
+    return false;
+  size_t bytes = (size_t)1 << (h->info - 24);
+  if (len - *pos < bytes)
+    return false;
+  h->arg = 0;
+  for (size_t i = 0; i < bytes; i++)
+    h->arg = (h->arg << 8) | buf[(*pos)++];
+  return true;
+}
+
+static bool cbor_at_break(const uint8_t *buf, size_t len, size_t pos) {
+  return pos < len && buf[pos] == CBOR_BREAK;
+}
+
+static bool cbor_skip(const uint8_t *buf, size_t len, size_t *pos, int depth) {
+  cbor_head_t h;
+  if (depth > CBOR_MAX_DEPTH || !cbor_read_head(buf, len, pos, &h))
+    return false;
+
+  switch (h.major) {
+  case 2: // Byte and text strings
+  case 3:
+    if (h.indefinite) {
+      while (!cbor_at_break(buf, len, *pos)) {
+        if (!cbor_skip(buf, len, pos, depth + 1))
+          return false;
+      }
+      (*pos)++;
+      return true;
+    }
+    if (h.arg > len - *pos)
+      return false;
+    *pos += h.arg;
+    return true;
+
+  case 4: // Arrays and maps
+  case 5: {
+    if (h.indefinite) {
+      while (!cbor_at_break(buf, len, *pos)) {
+        if (!cbor_skip(buf, len, pos, depth + 1))
+          return false;
+      }
+      (*pos)++;
+      return true;
+    }
+    uint64_t items = (h.major == 5) ? h.arg * 2 : h.arg;
+    if (items > len - *pos)
+      return false; // Every item takes at least one byte
+    for (uint64_t i = 0; i < items; i++) {
+      if (!cbor_skip(buf, len, pos, depth + 1))
+        return false;
+    }
+    return true;
+  }
+
+  case 6: // Tag: skip the tagged item
+    return cbor_skip(buf, len, pos, depth + 1);
+
+  default: // Integers and simple values are fully consumed by the head
+    return true;
+  }
+}
+
+bool web_req_is_cbor(httpd_req_t *req) {
+  char type[32];
+  return httpd_req_get_hdr_value_str(req, "Content-Type", type,
+                                     sizeof(type)) == ESP_OK &&
+         strncmp(type, "application/cbor", 16) == 0;
+}
+
+bool web_req_cbor_is_map(const uint8_t *buf, size_t len) {
+  size_t pos = 0;
+  return len > 0 && (buf[0] >> 5) == 5 && cbor_skip(buf, len, &pos, 0) &&
+         pos == len;
+}
+
+esp_err_t web_req_cbor_int(const uint8_t *buf, size_t len, const char *key,
+                           int *out) {
+  size_t pos = 0;
+  cbor_head_t map;
+  if (!cbor_read_head(buf, len, &pos, &map) || map.major != 5)
+    return ESP_ERR_INVALID_ARG;
+
+  size_t key_len = strlen(key);
+  for (uint64_t i = 0; map.indefinite || i < map.arg; i++) {
+    if (map.indefinite && cbor_at_break(buf, len, pos))
+      break;
+
+    // Only definite-length text keys can match; anything else is skipped
+    size_t key_pos = pos;
+    cbor_head_t k;
+    if (!cbor_read_head(buf, len, &key_pos, &k))
+      return ESP_ERR_INVALID_ARG;
+    bool match = k.major == 3 && !k.indefinite && k.arg == key_len &&
+                 key_len <= len - key_pos &&
+                 memcmp(buf + key_pos, key, key_len) == 0;
+    if (!cbor_skip(buf, len, &pos, 1))
+      return ESP_ERR_INVALID_ARG;
+    if (!match) {
+      if (!cbor_skip(buf, len, &pos, 1))
+        return ESP_ERR_INVALID_ARG;
+      continue;
+    }
+
+    cbor_head_t v;
+    if (!cbor_read_head(buf, len, &pos, &v))
+      return ESP_ERR_INVALID_ARG;
+    // Saturate like the JSON reader instead of overflowing
+    uint64_t mag = v.arg < 100000000 ? v.arg : 100000000;
+    if (v.major == 0)
+      *out = (int)mag;
+    else if (v.major == 1)
+      *out = -1 - (int)mag;
+    else if (v.major == 7 && (v.info == 20 || v.info == 21))
+      *out = (v.info == 21);
+    else
+      return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+  }
+  return ESP_ERR_NOT_FOUND;
+}
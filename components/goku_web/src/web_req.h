@@ -0,0 +1,195 @@
+/**
+ * @file web_req.h
+ * @brief Allocation-free request input: body, query string, JSON and CBOR
+ *
+ * All buffers belong to the caller (normally the handler stack). The JSON
+ * tokenizer works in place in the style of jsmn: it records offsets into the
+ * body instead of copying values, and fails cleanly when the token array is
+ * too small. CBOR bodies are small flat maps, read directly by key.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// httpd rejects longer URIs with 414, so a query always fits
+#define WEB_REQ_QUERY_MAX (CONFIG_HTTPD_MAX_URI_LEN + 1)
+
+/**
+ * @brief Query string loaded once for typed lookups
+ */
+typedef struct {
+  bool present; // Request had a query string
+  char buf[WEB_REQ_QUERY_MAX];
+} web_req_query_t;
+
+typedef enum {
+  WEB_REQ_TOK_OBJECT = 1,
+  WEB_REQ_TOK_ARRAY,
+  WEB_REQ_TOK_STRING,    // start/end exclude the quotes, escapes kept
+  WEB_REQ_TOK_PRIMITIVE, // number, true, false or null
+} web_req_tok_type_t;
+
+typedef struct {
+  uint8_t type;   // web_req_tok_type_t
+  int16_t parent; // Index of the enclosing token, -1 for the root
+  uint16_t start; // Offset of the first byte
+  uint16_t end;   // Offset one past the last byte
+  uint16_t size;  // Children (members, elements, or 1 for a key with value)
+} web_req_tok_t;
+
+/**
+ * @brief Receive the complete request body
+ *
+ * Loops over partial receives until Content-Length bytes arrived and
+ * NUL-terminates the result. On failure an error response has already been
+ * sent (400, 408 or 413) and the handler should just return.
+ *
+ * @param req Request
+ * @param buf Destination buffer
+ * @param cap Buffer size; the body must be shorter than this
+ * @param len Received length (excluding the terminator), may be NULL
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t web_req_recv_body(httpd_req_t *req, char *buf, size_t cap,
+                            size_t *len);
+
+/**
+ * @brief Copy the query string into a caller buffer
+ *
+ * @param req Request
+ * @param buf Destination buffer (WEB_REQ_QUERY_MAX always suffices)
+ * @param cap Buffer size
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND if there is no query, or
+ *         ESP_ERR_INVALID_SIZE if it does not fit
+ */
+esp_err_t web_req_get_query(httpd_req_t *req, char *buf, size_t cap);
+
+/**
+ * @brief Load the query string for web_req_query_str/int/flag()
+ *
+ * A request without a query loads as empty, so every lookup reports
+ * ESP_ERR_NOT_FOUND.
+ *
+ * @return esp_err_t ESP_OK (check q->present for an empty query)
+ */
+esp_err_t web_req_query_load(httpd_req_t *req, web_req_query_t *q);
+
+/**
+ * @brief Copy a query parameter
+ *
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND, or ESP_ERR_INVALID_SIZE if
+ *         the value does not fit in dst
+ */
+esp_err_t web_req_query_str(const web_req_query_t *q, const char *key,
+                            char *dst, size_t cap);
+
+/**
+ * @brief Read a decimal integer query parameter
+ *
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND, or ESP_ERR_INVALID_ARG if the
+ *         value is not a number
+ */
+esp_err_t web_req_query_int(const web_req_query_t *q, const char *key,
+                            int *out);
+
+/**
+ * @brief Whether a parameter is set to "1" or "true"
+ */
+bool web_req_query_flag(const web_req_query_t *q, const char *key);
+
+/**
+ * @brief Tokenize a JSON document in place
+ *
+ * @param js Document (need not be NUL-terminated)
+ * @param len Document length, at most UINT16_MAX
+ * @param toks Token array
+ * @param max_toks Capacity of toks
+ * @return int Number of tokens, or -1 on malformed input or too few tokens
+ */
+int web_req_json_parse(const char *js, size_t len, web_req_tok_t *toks,
+                       int max_toks);
+
+/**
+ * @brief Find a member of an object
+ *
+ * @param obj Index of the object token (0 for the document root)
+ * @return int Index of the value token, or -1 if absent
+ */
+int web_req_json_find(const char *js, const web_req_tok_t *toks, int ntok,
+                      int obj, const char *key);
+
+/**
+ * @brief Index of the first token after idx and all of its descendants
+ */
+int web_req_json_skip(const web_req_tok_t *toks, int ntok, int idx);
+
+/**
+ * @brief Read an integer or boolean token (true = 1, false = 0)
+ *
+ * Fractions are truncated.
+ *
+ * @return esp_err_t ESP_OK, or ESP_ERR_INVALID_ARG if the token is not a
+ *         number or boolean
+ */
+esp_err_t web_req_json_tok_int(const char *js, const web_req_tok_t *tok,
+                               int *out);
+
+/**
+ * @brief Copy a string token, decoding escapes
+ *
+ * @return esp_err_t ESP_OK, ESP_ERR_INVALID_ARG if the token is not a
+ *         string, or ESP_ERR_INVALID_SIZE if dst is too small
+ */
+esp_err_t web_req_json_tok_str(const char *js, const web_req_tok_t *tok,
+                               char *dst, size_t cap);
+
+/**
+ * @brief Read an integer or boolean member of an object
+ *
+ * @return esp_err_t As web_req_json_tok_int(), or ESP_ERR_NOT_FOUND
+ */
+esp_err_t web_req_json_int(const char *js, const web_req_tok_t *toks, int ntok,
+                           int obj, const char *key, int *out);
+
+/**
+ * @brief Copy a string member of an object
+ *
+ * @return esp_err_t As web_req_json_tok_str(), or ESP_ERR_NOT_FOUND
+ */
+esp_err_t web_req_json_str(const char *js, const web_req_tok_t *toks, int ntok,
+                           int obj, const char *key, char *dst, size_t cap);
+
+/**
+ * @brief Whether the body is CBOR (Content-Type: application/cbor)
+ */
+bool web_req_is_cbor(httpd_req_t *req);
+
+/**
+ * @brief Check that buf holds exactly one well-formed CBOR map
+ */
+bool web_req_cbor_is_map(const uint8_t *buf, size_t len);
+
+/**
+ * @brief Read an integer or boolean member of a top-level CBOR map
+ *
+ * Keys must be text strings; other members are skipped.
+ *
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND, or ESP_ERR_INVALID_ARG if
+ *         the value is not an integer or boolean
+ */
+esp_err_t web_req_cbor_int(const uint8_t *buf, size_t len, const char *key,
+                           int *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,131 @@
+#include "web_router.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "goku_mem.h"
+#include "web_perf.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TAG "web_router"
+
+typedef struct {
+  const web_route_t *route; // NULL = empty slot
+  web_perf_route_t *perf;
+  uint32_t hash;
+} router_slot_t;
+
+// Sized at start-up to a power of two at least twice the route count, so
+// probe chains stay short however many endpoints the table lists
+static router_slot_t *s_slots = NULL;
+static size_t s_mask = 0;
+
+// FNV-1a over the path only: every method of a path shares a probe chain,
+// which is what lets a miss on the method be answered with 405
+static uint32_t router_hash(const char *path, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint8_t)path[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static bool router_path_eq(const router_slot_t *slot, uint32_t hash,
+                           const char *path, size_t len) {
+  return slot->hash == hash && strncmp(slot->route->path, path, len) == 0 &&
+         slot->route->path[len] == '\0';
+}
+
+// "GET, POST" for the methods set in mask
+static void router_allow(uint32_t mask, char *out, size_t cap) {
+  size_t n = 0;
+  out[0] = '\0';
+  for (int m = 0; m < 32 && n < cap; m++) {
+    if (mask & (1u << m))
+      n += snprintf(out + n, cap - n, "%s%s", n ? ", " : "",
+                    http_method_str(m));
+  }
+}
+
+static esp_err_t web_router_dispatch(httpd_req_t *req) {
+  size_t len = strcspn(req->uri, "?#");
+  uint32_t hash = router_hash(req->uri, len);
+
+  uint32_t allowed = 0; // Methods the path does have
+  for (size_t i = hash & s_mask; s_slots[i].route; i = (i + 1) & s_mask) {
+    const router_slot_t *slot = &s_slots[i];
+    if (!router_path_eq(slot, hash, req->uri, len))
+      continue;
+    if (slot->route->method == req->method)
+      return web_perf_run(slot->perf, slot->route->handler, req);
+    allowed |= 1u << slot->route->method;
+  }
+
+  if (allowed) {
+    char allow[48];
+    router_allow(allowed, allow, sizeof(allow));
+    httpd_resp_set_hdr(req, "Allow", allow);
+    httpd_resp_send_err(req, HTTPD_405_METHOD_NOT_ALLOWED, NULL);
+  } else {
+    httpd_resp_send_404(req);
+  }
+  return ESP_OK;
+}
+
+esp_err_t web_router_start(httpd_handle_t server, const char *pattern,
+                           const web_route_t *routes, size_t count) {
+  if (s_slots)
+    return ESP_ERR_INVALID_STATE;
+  size_t slots = 4;
+  while (slots < count * 2)
+    slots *= 2;
+  s_slots = app_mem_calloc(APP_MEM_TAG_WEB, slots, sizeof(router_slot_t),
+                           MALLOC_CAP_INTERNAL);
+  if (!s_slots) {
+    ESP_LOGE(TAG, "No memory for %u routes", (unsigned int)count);
+    return ESP_ERR_NO_MEM;
+  }
+  s_mask = slots - 1;
+
+  uint32_t methods = 0; // Bit per method that needs a wildcard handler
+  for (size_t r = 0; r < count; r++) {
+    const web_route_t *route = &routes[r];
+    bool dup = false;
+    size_t len = strlen(route->path);
+    uint32_t hash = router_hash(route->path, len);
+    size_t i = hash & s_mask;
+    for (; s_slots[i].route; i = (i + 1) & s_mask) {
+      dup |= router_path_eq(&s_slots[i], hash, route->path, len) &&
+             s_slots[i].route->method == route->method;
+    }
+    if (dup || (unsigned int)route->method >= 32) {
+      ESP_LOGE(TAG, "%s route %s", dup ? "Duplicate" : "Bad method",
+               route->path);
+      app_mem_free(s_slots);
+      s_slots = NULL;
+      return ESP_ERR_INVALID_ARG;
+    }
+    s_slots[i] = (router_slot_t){
+        .route = route,
+        .perf = web_perf_route_add(route->path, route->method),
+        .hash = hash,
+    };
+    methods |= 1u << route->method;
+  }
+
+  for (int m = 0; m < 32; m++) {
+    if (!(methods & (1u << m)))
+      continue;
+    httpd_uri_t uri = {
+        .uri = pattern, .method = m, .handler = web_router_dispatch};
+    esp_err_t err = httpd_register_uri_handler(server, &uri);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "Fail reg %s %s: %d", http_method_str(m), pattern, err);
+      return err;
+    }
+  }
+
+  ESP_LOGI(TAG, "%u routes under %s", (unsigned int)count, pattern);
+  return ESP_OK;
+}
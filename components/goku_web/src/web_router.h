@@ -0,0 +1,47 @@
+/**
+ * @file web_router.h
+ * @brief Table-driven dispatch for the REST API
+ *
+ * Endpoints are listed in one const table. httpd only sees a single
+ * wildcard handler per method; the router finds the route in a hash table
+ * keyed on the path, sized and built once at start-up, so lookup cost does
+ * not grow with the number of endpoints and adding one needs no slot
+ * tuning. Unknown paths get 404, known paths with another method 405 with
+ * an Allow header.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  httpd_method_t method;
+  const char *path; // Exact path, no query ("/api/ac/state")
+  esp_err_t (*handler)(httpd_req_t *req);
+} web_route_t;
+
+/**
+ * @brief Index the table and register the wildcard handlers
+ *
+ * The server must use httpd_uri_match_wildcard. Routes are timed through
+ * web_perf.
+ *
+ * @param server Running HTTP server
+ * @param pattern Wildcard template covering every path in the table
+ * @param routes Route table (must stay valid)
+ * @param count Number of routes
+ * @return esp_err_t ESP_OK, ESP_ERR_NO_MEM, ESP_ERR_INVALID_STATE if
+ *         already started, or ESP_ERR_INVALID_ARG on a duplicate route
+ */
+esp_err_t web_router_start(httpd_handle_t server, const char *pattern,
+                           const web_route_t *routes, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
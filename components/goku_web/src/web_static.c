@@ -0,0 +1,96 @@
+#include "web_static.h"
+#include "web_perf.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#define TAG "web_static"
+
+#define STATIC_QUEUE_LEN 4
+
+typedef struct {
+  httpd_req_t *req; // Detached copy owned by the sender task
+  const web_static_asset_t *asset;
+  web_perf_mark_t mark; // Handler start, for time to first byte and latency
+} static_job_t;
+
+static QueueHandle_t s_static_queue = NULL;
+
+static esp_err_t web_static_write(httpd_req_t *req,
+                                  const web_static_asset_t *asset,
+                                  const web_perf_mark_t *mark) {
+  httpd_resp_set_type(req, asset->type);
+  if (asset->encoding)
+    httpd_resp_set_hdr(req, "Content-Encoding", asset->encoding);
+  if (asset->etag) {
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+  }
+
+  // Headers and the first bytes of the body leave in the call below
+  web_perf_first_byte(mark);
+
+  // One contiguous send with Content-Length; httpd loops over partial
+  // writes, each bounded by the socket send timeout.
+  esp_err_t err =
+      httpd_resp_send(req, (const char *)asset->data, (ssize_t)asset->len);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Send of %u bytes failed: %s", (unsigned int)asset->len,
+             esp_err_to_name(err));
+  }
+  return err;
+}
+
+static void web_static_task(void *arg) {
+  static_job_t job;
+  while (1) {
+    if (xQueueReceive(s_static_queue, &job, portMAX_DELAY) != pdTRUE)
+      continue;
+
+    esp_err_t err = web_static_write(job.req, job.asset, &job.mark);
+    web_perf_complete(&job.mark, err);
+    httpd_req_async_handler_complete(job.req);
+  }
+}
+
+esp_err_t web_static_init(void) {
+  if (s_static_queue)
+    return ESP_OK;
+
+  s_static_queue = xQueueCreate(STATIC_QUEUE_LEN, sizeof(static_job_t));
+  if (!s_static_queue)
+    return ESP_ERR_NO_MEM;
+
+  if (xTaskCreate(web_static_task, "web_static", 4096, NULL, 4, NULL) !=
+      pdPASS) {
+    vQueueDelete(s_static_queue);
+    s_static_queue = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+esp_err_t web_static_send(httpd_req_t *req, const web_static_asset_t *asset) {
+  if (!req || !asset)
+    return ESP_ERR_INVALID_ARG;
+
+  web_perf_mark_t mark = web_perf_mark();
+  if (s_static_queue && uxQueueSpacesAvailable(s_static_queue) > 0) {
+    static_job_t job = {.asset = asset};
+    if (httpd_req_async_handler_begin(req, &job.req) == ESP_OK) {
+      job.mark = web_perf_detach();
+      if (xQueueSend(s_static_queue, &job, 0) == pdTRUE)
+        return ESP_OK;
+      httpd_req_async_handler_complete(job.req);
+
+      // Already detached for timing, so finish it here
+      esp_err_t err = web_static_write(req, asset, &job.mark);
+      web_perf_complete(&job.mark, err);
+      return err;
+    }
+  }
+
+  // Sender saturated: deliver inline rather than refusing the page
+  return web_static_write(req, asset, &mark);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file web_static.h
+ * @brief Static asset delivery off the httpd worker
+ *
+ * Large responses (the embedded UI bundle) are handed to a dedicated sender
+ * task via the async request API, so a slow client never holds the single
+ * httpd task and API calls keep being served while the page downloads.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Static response description
+ *
+ * All pointers must stay valid for the lifetime of the firmware (flash
+ * resident data and string literals).
+ */
+typedef struct {
+  const uint8_t *data;
+  size_t len;
+  const char *type;     // Content-Type
+  const char *encoding; // Content-Encoding or NULL
+  const char *etag;     // ETag or NULL
+} web_static_asset_t;
+
+/**
+ * @brief Start the static sender task
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t web_static_init(void);
+
+/**
+ * @brief Send a static asset
+ *
+ * The request is detached from the httpd task and completed by the sender
+ * task. When the sender is busy or unavailable the asset is sent inline.
+ *
+ * @param req Request being handled
+ * @param asset Asset to send
+ * @return esp_err_t ESP_OK if sent or queued
+ */
+esp_err_t web_static_send(httpd_req_t *req, const web_static_asset_t *asset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,174 @@
+#include "web_stats.h"
+#include "driver/temperature_sensor.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "goku_mem.h"
+#include "sdkconfig.h"
+#include "web_json.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define TAG "web_stats"
+
+#define STATS_INTERVAL_MS CONFIG_APP_WEB_STATS_INTERVAL_MS
+#define STATS_HISTORY CONFIG_APP_WEB_STATS_HISTORY
+#define STATS_TEMP_NONE INT16_MIN
+
+// Trend point: the fields the dashboard charts
+typedef struct {
+  uint32_t uptime_s;
+  uint32_t free_heap;
+  uint32_t psram_free;
+  int16_t temp_dc; // Tenths of a degree, STATS_TEMP_NONE without a sensor
+  int8_t rssi;
+} stats_point_t;
+
+// Double buffer: the sampler fills s_buf[(seq + 1) & 1] while readers copy
+// s_buf[seq & 1], then publishes by bumping s_seq. A reader only retries if
+// it raced a publish, i.e. when sampling finished during its copy.
+static web_stats_t s_buf[2];
+static _Atomic uint32_t s_seq = 0;
+
+static stats_point_t s_hist[STATS_HISTORY];
+static uint32_t s_hist_count = 0; // Samples ever added
+static portMUX_TYPE s_hist_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static temperature_sensor_handle_t s_temp_sensor = NULL;
+static TaskHandle_t s_stats_task = NULL;
+
+static void web_stats_sample(web_stats_t *s) {
+  s->uptime_us = esp_timer_get_time();
+  s->free_heap = app_mem_get_free_internal();
+  s->min_free_heap = esp_get_minimum_free_heap_size();
+
+  multi_heap_info_t psram_info;
+  heap_caps_get_info(&psram_info, MALLOC_CAP_SPIRAM);
+  s->psram_free = psram_info.total_free_bytes;
+  s->psram_total =
+      psram_info.total_free_bytes + psram_info.total_allocated_bytes;
+
+  s->temp = NAN;
+  float celsius;
+  if (s_temp_sensor &&
+      temperature_sensor_get_celsius(s_temp_sensor, &celsius) == ESP_OK)
+    s->temp = celsius;
+
+  wifi_ap_record_t ap_info;
+  s->wifi_connected = esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK;
+  if (s->wifi_connected) {
+    s->rssi = ap_info.rssi;
+    memcpy(s->ssid, ap_info.ssid, sizeof(s->ssid) - 1);
+    s->ssid[sizeof(s->ssid) - 1] = '\0';
+  } else {
+    s->rssi = 0;
+    s->ssid[0] = '\0';
+  }
+
+  app_ir_cache_get_stats(&s->ir_cache);
+  app_settings_get_stats(&s->settings);
+  app_ac_get_persist_stats(&s->ac_persist);
+}
+
+static void web_stats_publish(void) {
+  uint32_t next = atomic_load_explicit(&s_seq, memory_order_relaxed) + 1;
+  web_stats_t *s = &s_buf[next & 1];
+  web_stats_sample(s);
+  s->seq = next;
+  atomic_store_explicit(&s_seq, next, memory_order_release);
+
+  stats_point_t p = {
+      .uptime_s = s->uptime_us / 1000000,
+      .free_heap = s->free_heap,
+      .psram_free = s->psram_free,
+      .temp_dc = STATS_TEMP_NONE,
+      .rssi = s->rssi,
+  };
+  if (!isnan(s->temp))
+    p.temp_dc = (int16_t)lroundf(s->temp * 10);
+  taskENTER_CRITICAL(&s_hist_lock);
+  s_hist[s_hist_count % STATS_HISTORY] = p;
+  s_hist_count++;
+  taskEXIT_CRITICAL(&s_hist_lock);
+}
+
+static void web_stats_task(void *arg) {
+  TickType_t last_wake = xTaskGetTickCount();
+  while (1) {
+    vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(STATS_INTERVAL_MS));
+    web_stats_publish();
+  }
+}
+
+esp_err_t web_stats_init(void) {
+  if (s_stats_task)
+    return ESP_OK;
+
+  temperature_sensor_config_t temp_config =
+      TEMPERATURE_SENSOR_CONFIG_DEFAULT(20, 100);
+  if (temperature_sensor_install(&temp_config, &s_temp_sensor) == ESP_OK) {
+    temperature_sensor_enable(s_temp_sensor);
+  } else {
+    ESP_LOGW(TAG, "Temperature sensor unavailable");
+    s_temp_sensor = NULL;
+  }
+
+  web_stats_publish(); // Handlers never see an empty snapshot
+
+  if (xTaskCreate(web_stats_task, "web_stats", 3072, NULL, 1,
+                  &s_stats_task) != pdPASS)
+    return ESP_ERR_NO_MEM;
+  return ESP_OK;
+}
+
+void web_stats_get(web_stats_t *out) {
+  while (1) {
+    uint32_t seq = atomic_load_explicit(&s_seq, memory_order_acquire);
+    memcpy(out, &s_buf[seq & 1], sizeof(*out));
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&s_seq, memory_order_relaxed) == seq)
+      return;
+  }
+}
+
+esp_err_t web_stats_history_handler(httpd_req_t *req) {
+  taskENTER_CRITICAL(&s_hist_lock);
+  uint32_t end = s_hist_count;
+  taskEXIT_CRITICAL(&s_hist_lock);
+  uint32_t begin = end > STATS_HISTORY ? end - STATS_HISTORY : 0;
+
+  web_json_t w;
+  web_json_begin(&w, req);
+  web_json_obj_open(&w, NULL);
+  web_json_uint(&w, "interval_ms", STATS_INTERVAL_MS);
+  web_json_uint(&w, "uptime", esp_timer_get_time() / 1000000);
+  web_json_arr_open(&w, "samples");
+  for (uint32_t i = begin; i < end; i++) {
+    stats_point_t p;
+    bool valid;
+    taskENTER_CRITICAL(&s_hist_lock);
+    // The sampler may have lapped us while the response was streaming
+    valid = s_hist_count - i <= STATS_HISTORY;
+    p = s_hist[i % STATS_HISTORY];
+    taskEXIT_CRITICAL(&s_hist_lock);
+    if (!valid)
+      continue;
+
+    web_json_arr_open(&w, NULL);
+    web_json_uint(&w, NULL, p.uptime_s);
+    web_json_uint(&w, NULL, p.free_heap);
+    web_json_uint(&w, NULL, p.psram_free);
+    web_json_double(&w, NULL,
+                    p.temp_dc == STATS_TEMP_NONE ? NAN : p.temp_dc / 10.0);
+    web_json_int(&w, NULL, p.rssi);
+    web_json_arr_close(&w);
+  }
+  web_json_arr_close(&w);
+  web_json_obj_close(&w);
+  return web_json_end(&w);
+}
@@ -0,0 +1,63 @@
+/**
+ * @file web_stats.h
+ * @brief Background system stats sampler
+ *
+ * A low-priority task samples heap, PSRAM, chip temperature, Wi-Fi and
+ * subsystem counters every CONFIG_APP_WEB_STATS_INTERVAL_MS. Handlers read
+ * the latest sample from a double buffer without locking or touching any
+ * driver, and a ring of recent samples backs /api/system/stats/history.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "goku_ac.h"
+#include "goku_ir_cache.h"
+#include "goku_settings.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint32_t seq;      // Sample number, 0 until the first sample
+  int64_t uptime_us; // Time of the sample
+  uint32_t free_heap;
+  uint32_t min_free_heap;
+  uint32_t psram_free;
+  uint32_t psram_total;
+  float temp; // Chip temperature in C, NAN without a sensor
+  bool wifi_connected;
+  int8_t rssi;
+  char ssid[33];
+  app_ir_cache_stats_t ir_cache;
+  app_settings_stats_t settings;
+  app_ac_persist_stats_t ac_persist;
+} web_stats_t;
+
+/**
+ * @brief Take the first sample and start the sampler task
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t web_stats_init(void);
+
+/**
+ * @brief Copy the latest sample (any task, never blocks)
+ */
+void web_stats_get(web_stats_t *out);
+
+/**
+ * @brief GET /api/system/stats/history handler
+ *
+ * Returns the retained samples as compact rows of
+ * [uptime_s, free_heap, psram_free, temp, rssi], oldest first.
+ */
+esp_err_t web_stats_history_handler(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
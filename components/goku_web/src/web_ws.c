@@ -0,0 +1,396 @@
+#include "web_ws.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "goku_ac.h"
+#include "goku_ir_app.h"
+#include "goku_log.h"
+#include "goku_mem.h"
+#include "sdkconfig.h"
+#include "web_stats.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "web_ws"
+
+#define WS_MAX_CLIENTS CONFIG_APP_WEB_WS_MAX_CLIENTS
+#define WS_TICK_MS 250
+#define WS_STATS_INTERVAL_MS CONFIG_APP_WEB_WS_STATS_INTERVAL_MS
+#define WS_MAX_INFLIGHT 2 // Frames queued per client before dropping
+#define WS_LOG_CHUNK 384  // Raw log bytes per message (before escaping)
+
+#define WS_NOTIFY_AC (1u << 0)
+#define WS_NOTIFY_RESYNC (1u << 1)
+
+// Shared, refcounted message: one allocation for all clients
+typedef struct {
+  atomic_uint refs;
+  size_t len;
+  char data[];
+} ws_frame_t;
+
+typedef struct {
+  int fd; // -1 = free slot
+  uint8_t inflight;
+} ws_client_t;
+
+static httpd_handle_t s_server = NULL;
+static TaskHandle_t s_ws_task = NULL;
+static ws_client_t s_clients[WS_MAX_CLIENTS];
+static portMUX_TYPE s_clients_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static int ws_client_count(void) {
+  int n = 0;
+  taskENTER_CRITICAL(&s_clients_lock);
+  for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (s_clients[i].fd >= 0)
+      n++;
+  }
+  taskEXIT_CRITICAL(&s_clients_lock);
+  return n;
+}
+
+static bool ws_client_add(int fd) {
+  bool added = false;
+  taskENTER_CRITICAL(&s_clients_lock);
+  for (int i = 0; i < WS_MAX_CLIENTS && !added; i++) {
+    if (s_clients[i].fd == fd)
+      added = true; // Already known
+  }
+  for (int i = 0; i < WS_MAX_CLIENTS && !added; i++) {
+    if (s_clients[i].fd < 0) {
+      s_clients[i].fd = fd;
+      s_clients[i].inflight = 0;
+      added = true;
+    }
+  }
+  taskEXIT_CRITICAL(&s_clients_lock);
+  return added;
+}
+
+static void ws_client_remove(int fd) {
+  taskENTER_CRITICAL(&s_clients_lock);
+  for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (s_clients[i].fd == fd) {
+      s_clients[i].fd = -1;
+      s_clients[i].inflight = 0;
+    }
+  }
+  taskEXIT_CRITICAL(&s_clients_lock);
+}
+
+static void ws_frame_release(ws_frame_t *frame) {
+  if (atomic_fetch_sub(&frame->refs, 1) == 1)
+    app_mem_free(frame);
+}
+
+// Runs in the httpd task once the frame has been written (or failed)
+static void ws_send_done(esp_err_t err, int fd, void *arg) {
+  taskENTER_CRITICAL(&s_clients_lock);
+  for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (s_clients[i].fd == fd && s_clients[i].inflight > 0)
+      s_clients[i].inflight--;
+  }
+  taskEXIT_CRITICAL(&s_clients_lock);
+
+  if (err != ESP_OK)
+    ws_client_remove(fd);
+  ws_frame_release((ws_frame_t *)arg);
+}
+
+void web_ws_broadcast(const char *msg, size_t len) {
+  if (!s_server || !msg || len == 0)
+    return;
+
+  ws_frame_t *frame = app_mem_malloc(APP_MEM_TAG_WEB, sizeof(ws_frame_t) + len,
+                                     MALLOC_CAP_DEFAULT);
+  if (!frame)
+    return;
+  atomic_init(&frame->refs, 1); // Held by this function
+  frame->len = len;
+  memcpy(frame->data, msg, len);
+
+  bool dropped = false;
+  for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+    int fd;
+    bool busy;
+    taskENTER_CRITICAL(&s_clients_lock);
+    fd = s_clients[i].fd;
+    busy = s_clients[i].inflight >= WS_MAX_INFLIGHT;
+    if (fd >= 0 && !busy)
+      s_clients[i].inflight++;
+    taskEXIT_CRITICAL(&s_clients_lock);
+
+    if (fd < 0)
+      continue;
+    if (busy) {
+      dropped = true;
+      continue;
+    }
+    if (httpd_ws_get_fd_info(s_server, fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+      ws_client_remove(fd); // Socket closed or reused
+      continue;
+    }
+
+    httpd_ws_frame_t pkt = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)frame->data,
+        .len = frame->len,
+    };
+    atomic_fetch_add(&frame->refs, 1);
+    if (httpd_ws_send_data_async(s_server, fd, &pkt, ws_send_done, frame) !=
+        ESP_OK) {
+      ws_frame_release(frame);
+      ws_client_remove(fd);
+    }
+  }
+  ws_frame_release(frame);
+
+  // A slow client missed a diff: resend full state on the next pass
+  if (dropped && s_ws_task)
+    xTaskNotify(s_ws_task, WS_NOTIFY_RESYNC, eSetBits);
+}
+
+static void ws_push_ac(bool full) {
+  static ir_ac_state_t last;
+  static ac_brand_t last_brand;
+
+  ir_ac_state_t state;
+  app_ac_get_state(&state);
+  ac_brand_t brand = app_ac_get_brand();
+
+  char msg[128];
+  int base = snprintf(msg, sizeof(msg), "{\"t\":\"ac\"");
+  int n = base;
+  if (full || state.power != last.power)
+    n += snprintf(msg + n, sizeof(msg) - n, ",\"power\":%s",
+                  state.power ? "true" : "false");
+  if (full || state.mode != last.mode)
+    n += snprintf(msg + n, sizeof(msg) - n, ",\"mode\":%u", state.mode);
+  if (full || state.temp != last.temp)
+    n += snprintf(msg + n, sizeof(msg) - n, ",\"temp\":%u", state.temp);
+  if (full || state.fan != last.fan)
+    n += snprintf(msg + n, sizeof(msg) - n, ",\"fan\":%u", state.fan);
+  if (full || brand != last_brand)
+    n += snprintf(msg + n, sizeof(msg) - n, ",\"brand\":%d", (int)brand);
+
+  last = state;
+  last_brand = brand;
+  if (n == base)
+    return; // Nothing changed
+
+  n += snprintf(msg + n, sizeof(msg) - n, "}");
+  web_ws_broadcast(msg, n);
+}
+
+static void ws_push_learn(bool full) {
+  static bool last_learning;
+  static uint32_t last_count;
+
+  uint32_t count = 0;
+  bool learning = app_ir_get_learn_status(&count);
+  if (!full && learning == last_learning && count == last_count)
+    return;
+  last_learning = learning;
+  last_count = count;
+
+  char msg[64];
+  int n = snprintf(msg, sizeof(msg),
+                   "{\"t\":\"learn\",\"learning\":%s,\"captured\":%" PRIu32
+                   "}",
+                   learning ? "true" : "false", count);
+  web_ws_broadcast(msg, n);
+}
+
+// Forwards the sampler's snapshot; returns false if nothing new was sampled
+static bool ws_push_stats(uint32_t *last_seq) {
+  web_stats_t st;
+  web_stats_get(&st);
+  if (st.seq == *last_seq)
+    return false;
+  *last_seq = st.seq;
+
+  char temp[16] = "null";
+  if (!isnan(st.temp))
+    snprintf(temp, sizeof(temp), "%.1f", st.temp);
+
+  char msg[224];
+  int n = snprintf(
+      msg, sizeof(msg),
+      "{\"t\":\"stats\",\"uptime\":%" PRId64 ",\"free_heap\":%" PRIu32
+      ",\"min_free_heap\":%" PRIu32 ",\"psram_free\":%" PRIu32
+      ",\"psram_total\":%" PRIu32 ",\"temp\":%s,\"rssi\":%d}",
+      st.uptime_us / 1000000, st.free_heap, st.min_free_heap, st.psram_free,
+      st.psram_total, temp, st.rssi);
+  web_ws_broadcast(msg, n);
+  return true;
+}
+
+// JSON-escape src into dst; returns input bytes consumed (stops when full)
+static size_t ws_json_escape(const char *src, size_t src_len, char *dst,
+                             size_t dst_cap, size_t *dst_len) {
+  size_t in = 0;
+  size_t out = 0;
+  for (; in < src_len; in++) {
+    unsigned char c = (unsigned char)src[in];
+    char esc[7];
+    size_t n;
+    if (c == '"' || c == '\\') {
+      esc[0] = '\\';
+      esc[1] = c;
+      n = 2;
+    } else if (c == '\n') {
+      memcpy(esc, "\\n", 2);
+      n = 2;
+    } else if (c < 0x20) {
+      n = snprintf(esc, sizeof(esc), "\\u%04x", c);
+    } else {
+      esc[0] = c;
+      n = 1;
+    }
+    if (out + n > dst_cap)
+      break;
+    memcpy(dst + out, esc, n);
+    out += n;
+  }
+  *dst_len = out;
+  return in;
+}
+
+// New log output since the last push; clients fetch the backlog over HTTP
+// and use since/next to detect gaps.
+static void ws_push_log(uint64_t *cursor) {
+  if (app_log_get_cursor() == *cursor)
+    return;
+
+  char raw[WS_LOG_CHUNK];
+  uint64_t next;
+  uint64_t dropped;
+  size_t len = app_log_read_since(*cursor, raw, sizeof(raw), &next, &dropped);
+  if (len == 0 && dropped == 0)
+    return;
+  uint64_t since = *cursor + dropped; // Start of the bytes actually read
+
+  char msg[WS_LOG_CHUNK * 2 + 96];
+  int n = snprintf(msg, sizeof(msg),
+                   "{\"t\":\"log\",\"since\":%" PRIu64 ",\"dropped\":%" PRIu64
+                   ",\"text\":\"",
+                   since, dropped);
+  size_t text_len = 0;
+  // Leave room for the closing fields; the remainder goes out next tick
+  size_t cap = sizeof(msg) - n - 40;
+  size_t used = ws_json_escape(raw, len, msg + n, cap, &text_len);
+  if (used < len) {
+    // Offsets also cover line headers and deferred lines are never split,
+    // so re-read no more than fits and send exactly that
+    len = app_log_read_since(since, raw, used, &next, NULL);
+    ws_json_escape(raw, len, msg + n, cap, &text_len);
+  }
+  n += text_len;
+  *cursor = next;
+  n += snprintf(msg + n, sizeof(msg) - n, "\",\"next\":%" PRIu64 "}", *cursor);
+  web_ws_broadcast(msg, n);
+}
+
+static void ws_task(void *arg) {
+  TickType_t last_stats = 0;
+  uint32_t stats_seq = 0;
+  uint64_t log_cursor = 0;
+  bool synced = false;
+
+  while (1) {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(WS_TICK_MS));
+
+    if (ws_client_count() == 0) {
+      synced = false;
+      continue;
+    }
+
+    bool full = !synced || (bits & WS_NOTIFY_RESYNC);
+    if (!synced)
+      log_cursor = app_log_get_cursor(); // Backlog comes from HTTP
+    synced = true;
+
+    ws_push_ac(full);
+    ws_push_learn(full);
+    ws_push_log(&log_cursor);
+
+    TickType_t now = xTaskGetTickCount();
+    if (full)
+      stats_seq = 0; // Resend the current sample to new clients
+    if ((full || now - last_stats >= pdMS_TO_TICKS(WS_STATS_INTERVAL_MS)) &&
+        ws_push_stats(&stats_seq))
+      last_stats = now;
+  }
+}
+
+static void ws_on_ac_change(void) {
+  if (s_ws_task)
+    xTaskNotify(s_ws_task, WS_NOTIFY_AC, eSetBits);
+}
+
+static esp_err_t ws_handler(httpd_req_t *req) {
+  if (req->method == HTTP_GET) {
+    // Handshake done: start pushing to this socket
+    int fd = httpd_req_to_sockfd(req);
+    if (!ws_client_add(fd)) {
+      ESP_LOGW(TAG, "Client limit (%d) reached, rejecting fd %d",
+               WS_MAX_CLIENTS, fd);
+      return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Client connected (fd %d)", fd);
+    xTaskNotify(s_ws_task, WS_NOTIFY_RESYNC, eSetBits);
+    return ESP_OK;
+  }
+
+  // The UI only listens; read and discard whatever it sends
+  uint8_t buf[64];
+  httpd_ws_frame_t pkt = {.payload = buf};
+  esp_err_t err = httpd_ws_recv_frame(req, &pkt, 0);
+  if (err != ESP_OK)
+    return err;
+  if (pkt.len > sizeof(buf))
+    return ESP_ERR_INVALID_SIZE;
+  if (pkt.len > 0) {
+    err = httpd_ws_recv_frame(req, &pkt, sizeof(buf));
+    if (err != ESP_OK)
+      return err;
+  }
+  if (pkt.type == HTTPD_WS_TYPE_CLOSE)
+    ws_client_remove(httpd_req_to_sockfd(req));
+  return ESP_OK;
+}
+
+esp_err_t web_ws_init(httpd_handle_t server) {
+  if (!server)
+    return ESP_ERR_INVALID_ARG;
+
+  for (int i = 0; i < WS_MAX_CLIENTS; i++)
+    s_clients[i].fd = -1;
+  s_server = server;
+
+  if (!s_ws_task && xTaskCreate(ws_task, "web_ws", 4096, NULL, 4,
+                                &s_ws_task) != pdPASS) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  static const httpd_uri_t ws = {.uri = "/ws",
+                                 .method = HTTP_GET,
+                                 .handler = ws_handler,
+                                 .is_websocket = true};
+  esp_err_t err = httpd_register_uri_handler(server, &ws);
+  if (err != ESP_OK)
+    return err;
+
+  app_ac_set_change_cb(ws_on_ac_change);
+  ESP_LOGI(TAG, "WebSocket push ready on /ws (max %d clients)",
+           WS_MAX_CLIENTS);
+  return ESP_OK;
+}
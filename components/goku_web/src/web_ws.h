@@ -0,0 +1,42 @@
+/**
+ * @file web_ws.h
+ * @brief WebSocket push channel (/ws)
+ *
+ * Connected dashboards receive compact JSON diffs instead of polling:
+ *   {"t":"ac",...}     changed AC fields (full state after connect)
+ *   {"t":"learn",...}  learn progress
+ *   {"t":"stats",...}  periodic system sample
+ *   {"t":"log",...}    new log output with since/next byte offsets
+ * Each message is serialized once and the same buffer is fanned out to
+ * every client.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register /ws on a running server and start the push task
+ *
+ * @param server httpd handle
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t web_ws_init(httpd_handle_t server);
+
+/**
+ * @brief Send a pre-serialized text message to every connected client
+ *
+ * @param msg Message (copied)
+ * @param len Length in bytes
+ */
+void web_ws_broadcast(const char *msg, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
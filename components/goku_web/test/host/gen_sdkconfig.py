@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""Generate sdkconfig.h for the host build from the firmware's Kconfig.
+
+Takes the defaults of every option in main/Kconfig.projbuild, applies
+sdkconfig.defaults on top, as the firmware build does, then the host
+overrides given with --set. Options set to n are left undefined and
+options whose "depends on" symbol is off are dropped, both as in ESP-IDF's
+generated header.
+
+Invoked from test/host/CMakeLists.txt at configure time.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+
+def parse_kconfig(path):
+    """Return ({name: default}, {name: symbol it depends on})."""
+    options = {}  # In file order
+    depends = {}
+    choice = None  # [default, members] inside a choice block
+    name = None
+    help_indent = None
+    with open(path, encoding="utf-8") as f:
+        for raw in f:
+            line = raw.expandtabs()
+            if not line.strip():
+                continue
+            indent = len(line) - len(line.lstrip())
+            if help_indent is not None and indent > help_indent:
+                continue  # Help text
+            help_indent = None
+            key, _, rest = line.strip().partition(" ")
+            rest = rest.strip()
+            if key == "help":
+                help_indent = indent
+            elif key == "choice":
+                choice, name = [None, []], None
+            elif key == "endchoice":
+                for opt in choice[1]:
+                    options[opt] = "y" if opt == choice[0] else "n"
+                choice, name = None, None
+            elif key == "config":
+                name = rest
+                options.setdefault(name, None)
+                if choice is not None:
+                    choice[1].append(name)
+            elif key == "default":
+                value = re.sub(r"\s+if\s+.*$", "", rest)
+                if name is None and choice is not None:
+                    choice[0] = value
+                elif name is not None and options[name] is None:
+                    options[name] = value
+            elif key == "depends" and rest.startswith("on ") and name:
+                depends[name] = rest[3:].strip()
+            elif key in ("menu", "endmenu", "comment", "if", "endif"):
+                name = None
+    return {k: v for k, v in options.items() if v is not None}, depends
+
+
+def parse_defaults(path):
+    """Return {name: value} from an sdkconfig.defaults file."""
+    values = {}
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            m = re.match(r"\s*CONFIG_(\w+)=(.*)$", line)
+            if m:
+                values[m.group(1)] = m.group(2).strip()
+    return values
+
+
+def c_value(value):
+    if value == "y":
+        return "1"
+    return value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--kconfig", required=True,
+                        help="Kconfig.projbuild of the firmware")
+    parser.add_argument("--defaults", required=True,
+                        help="sdkconfig.defaults of the firmware")
+    parser.add_argument("--set", action="append", default=[],
+                        metavar="NAME=VALUE",
+                        help="host override, e.g. APP_LOG_DEFERRED=n")
+    parser.add_argument("--out", required=True, help="sdkconfig.h to write")
+    args = parser.parse_args()
+
+    values, depends = parse_kconfig(args.kconfig)
+    values.update(parse_defaults(args.defaults))
+    for item in args.set:
+        name, sep, value = item.partition("=")
+        if not sep:
+            parser.error(f"--set needs NAME=VALUE, got {item!r}")
+        values[name.removeprefix("CONFIG_")] = value
+
+    lines = [
+        "/* Generated by gen_sdkconfig.py from main/Kconfig.projbuild and",
+        " * sdkconfig.defaults for the goku_web host build. DO NOT EDIT. */",
+        "#pragma once",
+    ]
+    for name, value in values.items():
+        dep = depends.get(name)
+        if value == "n" or (dep and values.get(dep, "n") == "n"):
+            continue
+        lines.append(f"#define CONFIG_{name} {c_value(value)}")
+    text = "\n".join(lines) + "\n"
+
+    # Rewrite only on change, so an unchanged header triggers no rebuild
+    try:
+        with open(args.out, encoding="utf-8") as f:
+            if f.read() == text:
+                return 0
+    except OSError:
+        pass
+    os.makedirs(os.path.dirname(os.path.abspath(args.out)), exist_ok=True)
+    with open(args.out, "w", encoding="utf-8") as f:
+        f.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
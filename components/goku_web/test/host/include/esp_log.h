@@ -0,0 +1,58 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in for ESP-IDF logging, printed to stderr
+ *
+ * Lines below the level in GOKU_HOST_LOG (E, W, I, D or V; default W) are
+ * dropped, so a load test is not slowed down by its own logging.
+ */
+
+#pragma once
+
+#include "sdkconfig.h"
+#include <inttypes.h> // As on ESP-IDF, for PRIu32 and friends
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  ESP_LOG_NONE,
+  ESP_LOG_ERROR,
+  ESP_LOG_WARN,
+  ESP_LOG_INFO,
+  ESP_LOG_DEBUG,
+  ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL ESP_LOG_VERBOSE
+#endif
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format,
+                   ...) __attribute__((format(printf, 3, 4)));
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+uint32_t esp_log_timestamp(void);
+
+#define ESP_LOG_LEVEL(level, tag, format, ...)                                 \
+  esp_log_write(level, tag, format, ##__VA_ARGS__)
+#define ESP_LOG_LEVEL_LOCAL(level, tag, format, ...)                           \
+  do {                                                                         \
+    if (LOG_LOCAL_LEVEL >= (level))                                            \
+      ESP_LOG_LEVEL(level, tag, format, ##__VA_ARGS__);                        \
+  } while (0)
+
+#define ESP_LOGE(tag, format, ...)                                             \
+  ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)                                             \
+  ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)                                             \
+  ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)                                             \
+  ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)                                             \
+  ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+/**
+ * @file esp_memory_utils.h
+ * @brief Host stand-in: no address is external RAM
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+static inline bool esp_ptr_external_ram(const void *p) {
+  (void)p;
+  return false;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file esp_rom_sys.h
+ * @brief Host stand-in for esp_rom_delay_us()
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void esp_rom_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
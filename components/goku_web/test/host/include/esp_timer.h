@@ -0,0 +1,21 @@
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in for esp_timer_get_time()
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Microseconds since the process started (monotonic clock)
+ */
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
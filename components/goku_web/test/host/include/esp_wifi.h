@@ -0,0 +1,32 @@
+/**
+ * @file esp_wifi.h
+ * @brief Host stand-in: always associated with one access point
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  WIFI_AUTH_OPEN = 0,
+  WIFI_AUTH_WPA2_PSK = 3,
+} wifi_auth_mode_t;
+
+typedef struct {
+  uint8_t bssid[6];
+  uint8_t ssid[33];
+  uint8_t primary;
+  int8_t rssi;
+  wifi_auth_mode_t authmode;
+} wifi_ap_record_t;
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info);
+
+#ifdef __cplusplus
+}
+#endif
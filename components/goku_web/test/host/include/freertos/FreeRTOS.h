@@ -0,0 +1,54 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS kernel over POSIX threads
+ *
+ * Tasks are threads, the tick runs at the device's 100 Hz, and a portMUX
+ * critical section is a recursive mutex. Only what the web server uses is
+ * provided.
+ */
+
+#pragma once
+
+#include "sdkconfig.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define configTICK_RATE_HZ 100
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)                                                      \
+  ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks)                                                   \
+  ((uint32_t)(((uint64_t)(ticks) * 1000) / configTICK_RATE_HZ))
+
+#define tskNO_AFFINITY 0x7fffffff
+#define tskIDLE_PRIORITY 0
+
+typedef pthread_mutex_t portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP
+
+#define taskENTER_CRITICAL(mux) pthread_mutex_lock(mux)
+#define taskEXIT_CRITICAL(mux) pthread_mutex_unlock(mux)
+#define portENTER_CRITICAL(mux) pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux) pthread_mutex_unlock(mux)
+#define portENTER_CRITICAL_SAFE(mux) pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL_SAFE(mux) pthread_mutex_unlock(mux)
+
+#ifdef __cplusplus
+}
+#endif
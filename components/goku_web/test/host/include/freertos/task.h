@@ -0,0 +1,46 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for FreeRTOS tasks and task notifications
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+typedef enum {
+  eNoAction = 0,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite,
+  eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+                       uint32_t stack_depth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *out);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *out,
+                                   BaseType_t core);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value,
+                       eNotifyAction action);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks);
+#define xTaskNotifyGive(task) xTaskNotify((task), 0, eIncrement)
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
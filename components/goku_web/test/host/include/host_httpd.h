@@ -0,0 +1,24 @@
+/**
+ * @file host_httpd.h
+ * @brief Host-only controls of the httpd stand-in
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Listen on port instead of config->server_port (80 on the device)
+ *
+ * Call before app_web_init(). The stand-in listens on the loopback address
+ * only.
+ */
+void host_httpd_set_port(uint16_t port);
+
+#ifdef __cplusplus
+}
+#endif
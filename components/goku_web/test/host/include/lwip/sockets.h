@@ -0,0 +1,12 @@
+/**
+ * @file sockets.h
+ * @brief Host stand-in: lwIP's BSD socket API is the system's
+ */
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
@@ -0,0 +1,249 @@
+/**
+ * @file host_esp.c
+ * @brief ESP-IDF system services the web server calls, for the host build
+ */
+
+#include "driver/temperature_sensor.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* --- Time --- */
+
+static int64_t clock_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t s_boot_us;
+
+__attribute__((constructor)) static void host_esp_boot(void) {
+  s_boot_us = clock_us();
+}
+
+int64_t esp_timer_get_time(void) { return clock_us() - s_boot_us; }
+
+void esp_rom_delay_us(uint32_t us) {
+  int64_t until = clock_us() + us;
+  while (clock_us() < until) {
+  }
+}
+
+/* --- Logging --- */
+
+static esp_log_level_t s_log_level = ESP_LOG_WARN;
+
+__attribute__((constructor)) static void host_log_init(void) {
+  static const char levels[] = "NEWIDV";
+  const char *env = getenv("GOKU_HOST_LOG");
+  const char *p = env && *env ? strchr(levels, env[0]) : NULL;
+  if (p)
+    s_log_level = (esp_log_level_t)(p - levels);
+}
+
+uint32_t esp_log_timestamp(void) {
+  return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+  if (strcmp(tag, "*") == 0)
+    s_log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format,
+                   ...) {
+  static const char letters[] = "NEWIDV";
+  if (level > s_log_level)
+    return;
+  char line[512];
+  va_list ap;
+  va_start(ap, format);
+  vsnprintf(line, sizeof(line), format, ap);
+  va_end(ap);
+  fprintf(stderr, "%c (%u) %s: %s\n", letters[level], esp_log_timestamp(), tag,
+          line);
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+  case ESP_OK:
+    return "ESP_OK";
+  case ESP_FAIL:
+    return "ESP_FAIL";
+  case ESP_ERR_NO_MEM:
+    return "ESP_ERR_NO_MEM";
+  case ESP_ERR_INVALID_ARG:
+    return "ESP_ERR_INVALID_ARG";
+  case ESP_ERR_INVALID_STATE:
+    return "ESP_ERR_INVALID_STATE";
+  case ESP_ERR_INVALID_SIZE:
+    return "ESP_ERR_INVALID_SIZE";
+  case ESP_ERR_NOT_FOUND:
+    return "ESP_ERR_NOT_FOUND";
+  case ESP_ERR_NOT_SUPPORTED:
+    return "ESP_ERR_NOT_SUPPORTED";
+  case ESP_ERR_TIMEOUT:
+    return "ESP_ERR_TIMEOUT";
+  case ESP_ERR_INVALID_RESPONSE:
+    return "ESP_ERR_INVALID_RESPONSE";
+  case ESP_ERR_INVALID_CRC:
+    return "ESP_ERR_INVALID_CRC";
+  case ESP_ERR_INVALID_VERSION:
+    return "ESP_ERR_INVALID_VERSION";
+  default:
+    return "ERROR";
+  }
+}
+
+/* --- Heap --- */
+
+// A pretend ESP32-S3 with 8 MB of PSRAM; what the process allocates
+// through heap_caps_malloc() is taken from the matching region
+#define HOST_INTERNAL_TOTAL (320 * 1024)
+#define HOST_PSRAM_TOTAL (8 * 1024 * 1024)
+
+typedef struct {
+  size_t size;
+  bool psram;
+  max_align_t align[]; // Payload follows
+} host_block_t;
+
+typedef struct {
+  size_t total;
+  atomic_size_t used;
+  atomic_size_t peak;
+} host_region_t;
+
+static host_region_t s_internal = {.total = HOST_INTERNAL_TOTAL};
+static host_region_t s_psram = {.total = HOST_PSRAM_TOTAL};
+
+static host_region_t *region_of(uint32_t caps) {
+  return (caps & MALLOC_CAP_SPIRAM) ? &s_psram : &s_internal;
+}
+
+static void region_add(host_region_t *r, size_t size) {
+  size_t used = atomic_fetch_add(&r->used, size) + size;
+  size_t peak = atomic_load(&r->peak);
+  while (used > peak && !atomic_compare_exchange_weak(&r->peak, &peak, used)) {
+  }
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+  host_region_t *r = region_of(caps);
+  if (atomic_load(&r->used) + size > r->total)
+    return NULL;
+  host_block_t *b = malloc(sizeof(*b) + size);
+  if (!b)
+    return NULL;
+  b->size = size;
+  b->psram = r == &s_psram;
+  region_add(r, size);
+  return b->align;
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+  if (size && n > SIZE_MAX / size)
+    return NULL;
+  void *p = heap_caps_malloc(n * size, caps);
+  if (p)
+    memset(p, 0, n * size);
+  return p;
+}
+
+void heap_caps_free(void *ptr) {
+  if (!ptr)
+    return;
+  host_block_t *b =
+      (host_block_t *)((char *)ptr - offsetof(host_block_t, align));
+  atomic_fetch_sub(b->psram ? &s_psram.used : &s_internal.used, b->size);
+  free(b);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps) {
+  return region_of(caps)->total;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+  host_region_t *r = region_of(caps);
+  return r->total - atomic_load(&r->used);
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+  host_region_t *r = region_of(caps);
+  return r->total - atomic_load(&r->peak);
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+  return heap_caps_get_free_size(caps);
+}
+
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps) {
+  memset(info, 0, sizeof(*info));
+  info->total_free_bytes = heap_caps_get_free_size(caps);
+  info->total_allocated_bytes = atomic_load(&region_of(caps)->used);
+  info->largest_free_block = info->total_free_bytes;
+  info->minimum_free_bytes = heap_caps_get_minimum_free_size(caps);
+}
+
+uint32_t esp_get_free_heap_size(void) {
+  return (uint32_t)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) +
+                    heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+  return (uint32_t)(heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL) +
+                    heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+}
+
+/* --- System --- */
+
+esp_reset_reason_t esp_reset_reason(void) { return ESP_RST_POWERON; }
+
+void esp_restart(void) {
+  fprintf(stderr, "esp_restart() called, exiting\n");
+  exit(0);
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info) {
+  memset(ap_info, 0, sizeof(*ap_info));
+  memcpy(ap_info->ssid, "host", sizeof("host"));
+  ap_info->primary = 6;
+  ap_info->rssi = -50;
+  ap_info->authmode = WIFI_AUTH_WPA2_PSK;
+  return ESP_OK;
+}
+
+struct temperature_sensor_obj_t {
+  int unused;
+};
+
+esp_err_t temperature_sensor_install(const temperature_sensor_config_t *config,
+                                     temperature_sensor_handle_t *out) {
+  static struct temperature_sensor_obj_t sensor;
+  *out = &sensor;
+  return ESP_OK;
+}
+
+esp_err_t temperature_sensor_enable(temperature_sensor_handle_t sensor) {
+  return ESP_OK;
+}
+
+esp_err_t temperature_sensor_get_celsius(temperature_sensor_handle_t sensor,
+                                         float *out) {
+  *out = 40.0f + (float)(esp_timer_get_time() / 1000000 % 5);
+  return ESP_OK;
+}
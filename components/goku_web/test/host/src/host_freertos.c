@@ -0,0 +1,294 @@
+/**
+ * @file host_freertos.c
+ * @brief FreeRTOS tasks, notifications and queues over POSIX threads
+ *
+ * Priorities and core affinity are ignored; the host scheduler decides.
+ * Ticks follow the monotonic clock at configTICK_RATE_HZ.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct host_task {
+  pthread_t thread;
+  TaskFunction_t fn;
+  void *arg;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t value;
+  bool pending;
+};
+
+struct host_queue {
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+  UBaseType_t length;
+  UBaseType_t item_size;
+  UBaseType_t head;
+  UBaseType_t count;
+  uint8_t *items;
+};
+
+static _Thread_local struct host_task *s_current;
+
+/* --- Time --- */
+
+static struct timespec clock_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts;
+}
+
+// Absolute deadline ticks from now, for pthread_cond_timedwait
+static struct timespec deadline_after(TickType_t ticks) {
+  struct timespec ts = clock_now();
+  uint64_t ns = (uint64_t)pdTICKS_TO_MS(ticks) * 1000000ull;
+  ts.tv_sec += (time_t)(ns / 1000000000ull);
+  ts.tv_nsec += (long)(ns % 1000000000ull);
+  if (ts.tv_nsec >= 1000000000L) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000L;
+  }
+  return ts;
+}
+
+static void cond_init(pthread_cond_t *cond) {
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+// Waits on cond until woken or the deadline; false on timeout
+static bool cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock,
+                      TickType_t ticks, const struct timespec *deadline) {
+  if (ticks == 0)
+    return false;
+  if (ticks == portMAX_DELAY)
+    return pthread_cond_wait(cond, lock) == 0;
+  return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+TickType_t xTaskGetTickCount(void) {
+  struct timespec ts = clock_now();
+  uint64_t ms = (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+  return (TickType_t)(ms * configTICK_RATE_HZ / 1000u);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  uint64_t ms = pdTICKS_TO_MS(ticks);
+  struct timespec ts = {.tv_sec = (time_t)(ms / 1000),
+                        .tv_nsec = (long)(ms % 1000) * 1000000L};
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+  }
+}
+
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t increment) {
+  *prev_wake += increment;
+  int32_t remain = (int32_t)(*prev_wake - xTaskGetTickCount());
+  if (remain > 0)
+    vTaskDelay((TickType_t)remain);
+}
+
+/* --- Tasks --- */
+
+static struct host_task *task_new(void) {
+  struct host_task *t = calloc(1, sizeof(*t));
+  if (!t)
+    return NULL;
+  pthread_mutex_init(&t->lock, NULL);
+  cond_init(&t->cond);
+  return t;
+}
+
+static void *task_entry(void *arg) {
+  struct host_task *t = arg;
+  s_current = t;
+  t->fn(t->arg);
+  return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *out,
+                                   BaseType_t core) {
+  struct host_task *t = task_new();
+  if (!t)
+    return pdFAIL;
+  t->fn = fn;
+  t->arg = arg;
+  if (out)
+    *out = t; // Before the task runs, as FreeRTOS guarantees
+  if (pthread_create(&t->thread, NULL, task_entry, t) != 0) {
+    if (out)
+      *out = NULL;
+    free(t);
+    return pdFAIL;
+  }
+  pthread_detach(t->thread);
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+                       uint32_t stack_depth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *out) {
+  return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, out,
+                                 tskNO_AFFINITY);
+}
+
+// Threads not started by xTaskCreate get a handle on first use
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  if (!s_current)
+    s_current = task_new();
+  return s_current;
+}
+
+/* --- Task notifications --- */
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value,
+                       eNotifyAction action) {
+  BaseType_t ret = pdPASS;
+  pthread_mutex_lock(&task->lock);
+  switch (action) {
+  case eSetBits:
+    task->value |= value;
+    break;
+  case eIncrement:
+    task->value++;
+    break;
+  case eSetValueWithOverwrite:
+    task->value = value;
+    break;
+  case eSetValueWithoutOverwrite:
+    if (task->pending)
+      ret = pdFAIL;
+    else
+      task->value = value;
+    break;
+  case eNoAction:
+    break;
+  }
+  task->pending = true;
+  pthread_cond_signal(&task->cond);
+  pthread_mutex_unlock(&task->lock);
+  return ret;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                           uint32_t *value, TickType_t ticks) {
+  struct host_task *t = xTaskGetCurrentTaskHandle();
+  struct timespec deadline = deadline_after(ticks);
+  pthread_mutex_lock(&t->lock);
+  if (!t->pending)
+    t->value &= ~clear_on_entry;
+  while (!t->pending && cond_wait(&t->cond, &t->lock, ticks, &deadline)) {
+  }
+  BaseType_t got = t->pending ? pdTRUE : pdFALSE;
+  if (value)
+    *value = t->value;
+  if (got)
+    t->value &= ~clear_on_exit;
+  t->pending = false;
+  pthread_mutex_unlock(&t->lock);
+  return got;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  struct host_task *t = xTaskGetCurrentTaskHandle();
+  struct timespec deadline = deadline_after(ticks);
+  pthread_mutex_lock(&t->lock);
+  while (t->value == 0 && cond_wait(&t->cond, &t->lock, ticks, &deadline)) {
+  }
+  uint32_t value = t->value;
+  if (value)
+    t->value = clear_on_exit ? 0 : value - 1;
+  t->pending = false;
+  pthread_mutex_unlock(&t->lock);
+  return value;
+}
+
+/* --- Queues --- */
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  struct host_queue *q = calloc(1, sizeof(*q));
+  if (!q)
+    return NULL;
+  q->items = calloc(length, item_size);
+  if (!q->items) {
+    free(q);
+    return NULL;
+  }
+  q->length = length;
+  q->item_size = item_size;
+  pthread_mutex_init(&q->lock, NULL);
+  cond_init(&q->not_empty);
+  cond_init(&q->not_full);
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+  if (!q)
+    return;
+  pthread_mutex_destroy(&q->lock);
+  pthread_cond_destroy(&q->not_empty);
+  pthread_cond_destroy(&q->not_full);
+  free(q->items);
+  free(q);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) {
+  struct timespec deadline = deadline_after(ticks);
+  pthread_mutex_lock(&q->lock);
+  while (q->count == q->length &&
+         cond_wait(&q->not_full, &q->lock, ticks, &deadline)) {
+  }
+  if (q->count == q->length) {
+    pthread_mutex_unlock(&q->lock);
+    return pdFAIL;
+  }
+  UBaseType_t tail = (q->head + q->count) % q->length;
+  memcpy(q->items + (size_t)tail * q->item_size, item, q->item_size);
+  q->count++;
+  pthread_cond_signal(&q->not_empty);
+  pthread_mutex_unlock(&q->lock);
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks) {
+  struct timespec deadline = deadline_after(ticks);
+  pthread_mutex_lock(&q->lock);
+  while (q->count == 0 &&
+         cond_wait(&q->not_empty, &q->lock, ticks, &deadline)) {
+  }
+  if (q->count == 0) {
+    pthread_mutex_unlock(&q->lock);
+    return pdFALSE;
+  }
+  memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+  q->head = (q->head + 1) % q->length;
+  q->count--;
+  pthread_cond_signal(&q->not_full);
+  pthread_mutex_unlock(&q->lock);
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  pthread_mutex_lock(&q->lock);
+  UBaseType_t n = q->count;
+  pthread_mutex_unlock(&q->lock);
+  return n;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+  pthread_mutex_lock(&q->lock);
+  UBaseType_t n = q->length - q->count;
+  pthread_mutex_unlock(&q->lock);
+  return n;
+}
@@ -0,0 +1,927 @@
+/**
+ * @file host_httpd.c
+ * @brief esp_http_server stand-in over POSIX sockets
+ *
+ * Follows the ESP-IDF server where it shapes latency: a single thread
+ * parses requests and runs every handler in turn, a detached request keeps
+ * its socket out of the select set until httpd_req_async_handler_complete(),
+ * and max_open_sockets is enforced with the same LRU purge. Only HTTP/1.1
+ * with Content-Length bodies is understood.
+ */
+
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "host_httpd.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define TAG "host_httpd"
+
+#define HOST_RECV_BUF 4096 // Request line, headers and any pipelined bytes
+#define HOST_HDR_MAX 2048
+#define HOST_CHUNK_HDR 16
+
+typedef struct host_server host_server_t;
+
+typedef struct {
+  int fd;           // -1 = free
+  bool busy;        // Detached; skipped by select until completed
+  bool close_after; // Set by the async side, applied on completion
+  uint64_t lru;
+  size_t len;
+  char buf[HOST_RECV_BUF];
+} host_sess_t;
+
+typedef struct host_req {
+  httpd_req_t r;
+  host_server_t *srv;
+  host_sess_t *sess;
+  char head[HOST_HDR_MAX]; // Request line and headers, NUL separated lines
+  size_t head_len;
+  size_t body_left; // Bytes of the body not yet read
+  bool keep_alive;
+  const char *status;
+  const char *type;
+  const char *hdr_field[16];
+  const char *hdr_value[16];
+  size_t hdr_count;
+  bool chunked; // Chunked response under way
+  bool sent;    // Response finished
+  bool failed;  // Socket error; the session is closed
+  bool detached;
+} host_req_t;
+
+typedef struct {
+  httpd_uri_t uri;
+} host_handler_t;
+
+struct host_server {
+  httpd_config_t config;
+  int listen_fd;
+  int ctrl[2]; // Completed async requests post their session index here
+  pthread_t thread;
+  volatile bool stop;
+  pthread_mutex_t handlers_lock; // Handlers are added while serving
+  host_handler_t *handlers;
+  size_t handler_count;
+  host_sess_t *sess;
+  uint64_t lru_clock;
+};
+
+static uint16_t s_port_override;
+
+void host_httpd_set_port(uint16_t port) { s_port_override = port; }
+
+static host_req_t *req_of(httpd_req_t *r) { return (host_req_t *)r->aux; }
+
+/* --- Sockets --- */
+
+static int sock_send_all(int fd, const char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK ? HTTPD_SOCK_ERR_TIMEOUT
+                                                     : HTTPD_SOCK_ERR_FAIL;
+    }
+    buf += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static void sess_close(host_server_t *srv, host_sess_t *s) {
+  if (s->fd < 0)
+    return;
+  if (srv->config.close_fn)
+    srv->config.close_fn(srv, s->fd);
+  else
+    close(s->fd);
+  s->fd = -1;
+  s->busy = false;
+  s->close_after = false;
+  s->len = 0;
+}
+
+static int sess_index(host_server_t *srv, host_sess_t *s) {
+  return (int)(s - srv->sess);
+}
+
+/* --- Responses --- */
+
+static const char *err_status(httpd_err_code_t code) {
+  switch (code) {
+  case HTTPD_501_METHOD_NOT_IMPLEMENTED:
+    return "501 Method Not Implemented";
+  case HTTPD_505_VERSION_NOT_SUPPORTED:
+    return "505 Version Not Supported";
+  case HTTPD_400_BAD_REQUEST:
+    return "400 Bad Request";
+  case HTTPD_401_UNAUTHORIZED:
+    return "401 Unauthorized";
+  case HTTPD_403_FORBIDDEN:
+    return "403 Forbidden";
+  case HTTPD_404_NOT_FOUND:
+    return "404 Not Found";
+  case HTTPD_405_METHOD_NOT_ALLOWED:
+    return "405 Method Not Allowed";
+  case HTTPD_408_REQ_TIMEOUT:
+    return "408 Request Timeout";
+  case HTTPD_411_LENGTH_REQUIRED:
+    return "411 Length Required";
+  case HTTPD_414_URI_TOO_LONG:
+    return "414 URI Too Long";
+  case HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE:
+    return "431 Request Header Fields Too Large";
+  default:
+    return "500 Internal Server Error";
+  }
+}
+
+// Status line and headers; length < 0 announces a chunked body
+static int resp_head(host_req_t *hr, char *out, size_t cap, ssize_t length) {
+  int n = snprintf(out, cap, "HTTP/1.1 %s\r\nContent-Type: %s\r\n",
+                   hr->status, hr->type);
+  if (length >= 0)
+    n += snprintf(out + n, cap - n, "Content-Length: %zd\r\n", length);
+  else
+    n += snprintf(out + n, cap - n, "Transfer-Encoding: chunked\r\n");
+  if (!hr->keep_alive)
+    n += snprintf(out + n, cap - n, "Connection: close\r\n");
+  for (size_t i = 0; i < hr->hdr_count && (size_t)n < cap; i++)
+    n += snprintf(out + n, cap - n, "%s: %s\r\n", hr->hdr_field[i],
+                  hr->hdr_value[i]);
+  if ((size_t)n + 3 > cap)
+    return -1;
+  n += snprintf(out + n, cap - n, "\r\n");
+  return n;
+}
+
+static esp_err_t resp_write(host_req_t *hr, const char *buf, size_t len) {
+  if (hr->failed)
+    return ESP_ERR_HTTPD_RESP_SEND;
+  if (sock_send_all(hr->sess->fd, buf, len) != 0) {
+    hr->failed = true;
+    return ESP_ERR_HTTPD_RESP_SEND;
+  }
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status) {
+  if (!r || !status)
+    return ESP_ERR_INVALID_ARG;
+  req_of(r)->status = status;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type) {
+  if (!r || !type)
+    return ESP_ERR_INVALID_ARG;
+  req_of(r)->type = type;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field,
+                             const char *value) {
+  if (!r || !field || !value)
+    return ESP_ERR_INVALID_ARG;
+  host_req_t *hr = req_of(r);
+  size_t max = hr->srv->config.max_resp_headers;
+  if (max > sizeof(hr->hdr_field) / sizeof(hr->hdr_field[0]))
+    max = sizeof(hr->hdr_field) / sizeof(hr->hdr_field[0]);
+  if (hr->hdr_count >= max)
+    return ESP_ERR_HTTPD_RESP_HDR;
+  hr->hdr_field[hr->hdr_count] = field;
+  hr->hdr_value[hr->hdr_count] = value;
+  hr->hdr_count++;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len) {
+  if (!r)
+    return ESP_ERR_INVALID_ARG;
+  host_req_t *hr = req_of(r);
+  if (buf_len == HTTPD_RESP_USE_STRLEN)
+    buf_len = buf ? (ssize_t)strlen(buf) : 0;
+  if (!buf)
+    buf_len = 0;
+
+  char head[HOST_HDR_MAX];
+  int n = resp_head(hr, head, sizeof(head), buf_len);
+  if (n < 0)
+    return ESP_ERR_HTTPD_RESP_HDR;
+  hr->sent = true;
+  // Head and body in one segment where they fit
+  if ((size_t)n + (size_t)buf_len <= sizeof(head)) {
+    if (buf_len > 0)
+      memcpy(head + n, buf, (size_t)buf_len);
+    return resp_write(hr, head, (size_t)n + (size_t)buf_len);
+  }
+  esp_err_t err = resp_write(hr, head, (size_t)n);
+  if (err == ESP_OK && buf_len > 0)
+    err = resp_write(hr, buf, (size_t)buf_len);
+  return err;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf,
+                                ssize_t buf_len) {
+  if (!r)
+    return ESP_ERR_INVALID_ARG;
+  host_req_t *hr = req_of(r);
+  if (buf_len == HTTPD_RESP_USE_STRLEN)
+    buf_len = buf ? (ssize_t)strlen(buf) : 0;
+  if (!buf)
+    buf_len = 0;
+
+  if (!hr->chunked) {
+    char head[HOST_HDR_MAX];
+    int n = resp_head(hr, head, sizeof(head), -1);
+    if (n < 0)
+      return ESP_ERR_HTTPD_RESP_HDR;
+    hr->chunked = true;
+    esp_err_t err = resp_write(hr, head, (size_t)n);
+    if (err != ESP_OK)
+      return err;
+  }
+
+  char size[HOST_CHUNK_HDR];
+  int n = snprintf(size, sizeof(size), "%zx\r\n", (size_t)buf_len);
+  esp_err_t err = resp_write(hr, size, (size_t)n);
+  if (err == ESP_OK && buf_len > 0)
+    err = resp_write(hr, buf, (size_t)buf_len);
+  if (err == ESP_OK)
+    err = resp_write(hr, "\r\n", 2);
+  if (buf_len == 0)
+    hr->sent = true;
+  return err;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error,
+                              const char *msg) {
+  if (!req)
+    return ESP_ERR_INVALID_ARG;
+  host_req_t *hr = req_of(req);
+  const char *status = err_status(error);
+  hr->status = status;
+  hr->type = "text/plain";
+  esp_err_t err =
+      httpd_resp_send(req, msg ? msg : status + 4, HTTPD_RESP_USE_STRLEN);
+  // Like the device, a malformed request ends the session
+  if (error == HTTPD_400_BAD_REQUEST || error == HTTPD_408_REQ_TIMEOUT ||
+      error == HTTPD_411_LENGTH_REQUIRED || error == HTTPD_414_URI_TOO_LONG ||
+      error == HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE)
+    hr->keep_alive = false;
+  return err;
+}
+
+esp_err_t httpd_resp_send_404(httpd_req_t *r) {
+  return httpd_resp_send_err(r, HTTPD_404_NOT_FOUND, NULL);
+}
+
+esp_err_t httpd_resp_send_408(httpd_req_t *r) {
+  return httpd_resp_send_err(r, HTTPD_408_REQ_TIMEOUT, NULL);
+}
+
+esp_err_t httpd_resp_send_500(httpd_req_t *r) {
+  return httpd_resp_send_err(r, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+}
+
+/* --- Requests --- */
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len) {
+  if (!r || !buf)
+    return HTTPD_SOCK_ERR_INVALID;
+  host_req_t *hr = req_of(r);
+  host_sess_t *s = hr->sess;
+  if (buf_len > hr->body_left)
+    buf_len = hr->body_left;
+  if (buf_len == 0)
+    return 0;
+
+  if (s->len > 0) {
+    size_t n = s->len < buf_len ? s->len : buf_len;
+    memcpy(buf, s->buf, n);
+    memmove(s->buf, s->buf + n, s->len - n);
+    s->len -= n;
+    hr->body_left -= n;
+    return (int)n;
+  }
+
+  for (;;) {
+    ssize_t n = recv(s->fd, buf, buf_len, 0);
+    if (n > 0) {
+      hr->body_left -= (size_t)n;
+      return (int)n;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return HTTPD_SOCK_ERR_TIMEOUT;
+    hr->failed = true;
+    return HTTPD_SOCK_ERR_FAIL;
+  }
+}
+
+// Start of the value of field in the header block, or NULL
+static const char *req_hdr_find(host_req_t *hr, const char *field) {
+  size_t flen = strlen(field);
+  const char *p = hr->head + strlen(hr->head) + 1; // Skip request line
+  const char *end = hr->head + hr->head_len;
+  for (; p < end; p += strlen(p) + 1) {
+    if (strncasecmp(p, field, flen) == 0 && p[flen] == ':') {
+      p += flen + 1;
+      while (*p == ' ' || *p == '\t')
+        p++;
+      return p;
+    }
+  }
+  return NULL;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *r, const char *field) {
+  if (!r || !field)
+    return 0;
+  const char *v = req_hdr_find(req_of(r), field);
+  return v ? strlen(v) : 0;
+}
+
+static esp_err_t copy_trunc(char *dst, size_t cap, const char *src,
+                            size_t len) {
+  if (!dst || cap == 0)
+    return ESP_ERR_INVALID_ARG;
+  size_t n = len < cap - 1 ? len : cap - 1;
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+  return n < len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field,
+                                      char *val, size_t val_size) {
+  if (!r || !field)
+    return ESP_ERR_INVALID_ARG;
+  const char *v = req_hdr_find(req_of(r), field);
+  if (!v)
+    return ESP_ERR_NOT_FOUND;
+  return copy_trunc(val, val_size, v, strlen(v));
+}
+
+static const char *req_query(httpd_req_t *r, size_t *len) {
+  const char *q = strchr(r->uri, '?');
+  if (!q)
+    return NULL;
+  q++;
+  *len = strcspn(q, "#");
+  return q;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *r) {
+  size_t len = 0;
+  return r && req_query(r, &len) ? len : 0;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf,
+                                      size_t buf_len) {
+  size_t len = 0;
+  if (!r)
+    return ESP_ERR_INVALID_ARG;
+  const char *q = req_query(r, &len);
+  if (!q)
+    return ESP_ERR_NOT_FOUND;
+  return copy_trunc(buf, buf_len, q, len);
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val,
+                                size_t val_size) {
+  if (!qry || !key || !val)
+    return ESP_ERR_INVALID_ARG;
+  size_t klen = strlen(key);
+  const char *p = qry;
+  while (*p) {
+    size_t plen = strcspn(p, "&");
+    if (plen > klen && strncmp(p, key, klen) == 0 && p[klen] == '=')
+      return copy_trunc(val, val_size, p + klen + 1, plen - klen - 1);
+    p += plen;
+    if (*p == '&')
+      p++;
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r) {
+  return r ? req_of(r)->sess->fd : -1;
+}
+
+const char *http_method_str(enum http_method m) {
+  switch (m) {
+  case HTTP_DELETE:
+    return "DELETE";
+  case HTTP_GET:
+    return "GET";
+  case HTTP_HEAD:
+    return "HEAD";
+  case HTTP_POST:
+    return "POST";
+  case HTTP_PUT:
+    return "PUT";
+  case HTTP_OPTIONS:
+    return "OPTIONS";
+  case HTTP_PATCH:
+    return "PATCH";
+  default:
+    return "<unknown>";
+  }
+}
+
+static int method_parse(const char *s, size_t len) {
+  static const enum http_method methods[] = {
+      HTTP_DELETE, HTTP_GET,     HTTP_HEAD, HTTP_POST,
+      HTTP_PUT,    HTTP_OPTIONS, HTTP_PATCH};
+  for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+    const char *name = http_method_str(methods[i]);
+    if (strlen(name) == len && strncmp(name, s, len) == 0)
+      return methods[i];
+  }
+  return -1;
+}
+
+/* --- Async requests --- */
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out) {
+  if (!r || !out)
+    return ESP_ERR_INVALID_ARG;
+  host_req_t *hr = req_of(r);
+  host_req_t *copy = malloc(sizeof(*copy));
+  if (!copy)
+    return ESP_ERR_NO_MEM;
+  memcpy(copy, hr, sizeof(*copy));
+  copy->r.aux = copy;
+  hr->detached = true;
+  hr->sess->busy = true;
+  *out = &copy->r;
+  return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *r) {
+  if (!r)
+    return ESP_ERR_INVALID_ARG;
+  host_req_t *hr = req_of(r);
+  host_server_t *srv = hr->srv;
+  host_sess_t *s = hr->sess;
+
+  // Unread body is discarded here, as the server would have done
+  char sink[256];
+  while (!hr->failed && hr->body_left > 0)
+    if (httpd_req_recv(r, sink, sizeof(sink)) <= 0)
+      hr->failed = true;
+  s->close_after = hr->failed || !hr->keep_alive || !hr->sent;
+
+  int idx = sess_index(srv, s);
+  free(hr);
+  if (write(srv->ctrl[1], &idx, sizeof(idx)) != sizeof(idx))
+    return ESP_FAIL;
+  return ESP_OK;
+}
+
+/* --- WebSocket: not supported by the stand-in --- */
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *pkt,
+                              size_t max_len) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket,
+                                   httpd_ws_frame_t *frame,
+                                   transfer_complete_cb callback, void *arg) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t hd, int fd) {
+  return HTTPD_WS_CLIENT_INVALID;
+}
+
+/* --- URI matching --- */
+
+// Same rules as ESP-IDF: a trailing '*' matches any tail, and a '?' makes
+// the character before it optional
+bool httpd_uri_match_wildcard(const char *uri_template,
+                              const char *uri_to_match, size_t match_upto) {
+  size_t tpl_len = strlen(uri_template);
+  char last = tpl_len > 0 ? uri_template[tpl_len - 1] : 0;
+  char prevlast = tpl_len > 1 ? uri_template[tpl_len - 2] : 0;
+  bool asterisk = last == '*' || (prevlast == '*' && last == '?');
+  bool quest = last == '?' || (prevlast == '?' && last == '*');
+
+  size_t special = (size_t)asterisk + (size_t)quest * 2;
+  if (tpl_len < special)
+    return false;
+  size_t exact = tpl_len - special;
+  if (match_upto < exact)
+    return false;
+
+  if (!quest) {
+    if (!asterisk && match_upto != exact)
+      return false;
+    return strncmp(uri_template, uri_to_match, exact) == 0;
+  }
+  if (match_upto > exact && uri_template[exact] != uri_to_match[exact])
+    return false;
+  if (strncmp(uri_template, uri_to_match, exact) != 0)
+    return false;
+  return asterisk || match_upto <= exact + 1;
+}
+
+static bool uri_match(host_server_t *srv, const char *tpl, const char *uri,
+                      size_t len) {
+  if (srv->config.uri_match_fn)
+    return srv->config.uri_match_fn(tpl, uri, len);
+  return strlen(tpl) == len && strncmp(tpl, uri, len) == 0;
+}
+
+// First handler whose URI and method match, as the device picks it
+static bool handler_find(host_server_t *srv, const char *uri, size_t len,
+                         int method, httpd_uri_t *out, bool *path_known) {
+  bool found = false;
+  pthread_mutex_lock(&srv->handlers_lock);
+  for (size_t i = 0; i < srv->handler_count && !found; i++) {
+    const httpd_uri_t *u = &srv->handlers[i].uri;
+    if (!uri_match(srv, u->uri, uri, len))
+      continue;
+    *path_known = true;
+    if ((int)u->method == method) {
+      *out = *u;
+      found = true;
+    }
+  }
+  pthread_mutex_unlock(&srv->handlers_lock);
+  return found;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
+                                     const httpd_uri_t *uri_handler) {
+  host_server_t *srv = handle;
+  if (!srv || !uri_handler)
+    return ESP_ERR_INVALID_ARG;
+  esp_err_t err = ESP_OK;
+  pthread_mutex_lock(&srv->handlers_lock);
+  for (size_t i = 0; i < srv->handler_count && err == ESP_OK; i++) {
+    if (srv->handlers[i].uri.method == uri_handler->method &&
+        strcmp(srv->handlers[i].uri.uri, uri_handler->uri) == 0)
+      err = ESP_ERR_HTTPD_HANDLER_EXISTS;
+  }
+  if (err == ESP_OK && srv->handler_count >= srv->config.max_uri_handlers)
+    err = ESP_ERR_HTTPD_HANDLERS_FULL;
+  if (err == ESP_OK)
+    srv->handlers[srv->handler_count++].uri = *uri_handler;
+  pthread_mutex_unlock(&srv->handlers_lock);
+  return err;
+}
+
+/* --- Server loop --- */
+
+// Splits the header block in s->buf into hr; 0 = incomplete, -1 = too large
+static int req_parse(host_sess_t *s, host_req_t *hr) {
+  char *end = memmem(s->buf, s->len, "\r\n\r\n", 4);
+  if (!end)
+    return s->len >= HOST_HDR_MAX ? -1 : 0;
+  size_t len = (size_t)(end - s->buf) + 4;
+  if (len > HOST_HDR_MAX)
+    return -1;
+
+  // Lines become NUL-terminated strings
+  size_t out = 0;
+  for (size_t i = 0; i < len - 2; i++) {
+    if (s->buf[i] == '\r' && s->buf[i + 1] == '\n') {
+      hr->head[out++] = '\0';
+      i++;
+    } else {
+      hr->head[out++] = s->buf[i];
+    }
+  }
+  hr->head_len = out;
+  memmove(s->buf, s->buf + len, s->len - len);
+  s->len -= len;
+  return 1;
+}
+
+static void req_handle(host_server_t *srv, host_sess_t *s) {
+  host_req_t *hr = calloc(1, sizeof(*hr));
+  if (!hr) {
+    sess_close(srv, s);
+    return;
+  }
+  hr->r.aux = hr;
+  hr->r.handle = srv;
+  hr->srv = srv;
+  hr->sess = s;
+  hr->status = "200 OK";
+  hr->type = "text/html";
+  hr->keep_alive = true;
+
+  int parsed = req_parse(s, hr);
+  if (parsed <= 0) {
+    if (parsed < 0) {
+      hr->keep_alive = false;
+      httpd_resp_send_err(&hr->r, HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE, NULL);
+      sess_close(srv, s);
+    }
+    free(hr);
+    return;
+  }
+
+  // Request line: METHOD SP URI SP VERSION
+  const char *line = hr->head;
+  const char *sp1 = strchr(line, ' ');
+  const char *sp2 = sp1 ? strchr(sp1 + 1, ' ') : NULL;
+  int method = sp1 ? method_parse(line, (size_t)(sp1 - line)) : -1;
+  size_t uri_len = sp2 ? (size_t)(sp2 - sp1 - 1) : 0;
+  bool http11 = sp2 && strcmp(sp2 + 1, "HTTP/1.1") == 0;
+  hr->r.method = method;
+
+  const char *conn = req_hdr_find(hr, "Connection");
+  if (!http11 || (conn && strcasecmp(conn, "close") == 0))
+    hr->keep_alive = false;
+
+  const char *cl = req_hdr_find(hr, "Content-Length");
+  hr->r.content_len = cl ? strtoul(cl, NULL, 10) : 0;
+  hr->body_left = hr->r.content_len;
+
+  if (!sp2) {
+    httpd_resp_send_err(&hr->r, HTTPD_400_BAD_REQUEST, NULL);
+  } else if (uri_len > HTTPD_MAX_URI_LEN) {
+    httpd_resp_send_err(&hr->r, HTTPD_414_URI_TOO_LONG, NULL);
+  } else if (method < 0) {
+    httpd_resp_send_err(&hr->r, HTTPD_501_METHOD_NOT_IMPLEMENTED, NULL);
+  } else if (req_hdr_find(hr, "Transfer-Encoding")) {
+    httpd_resp_send_err(&hr->r, HTTPD_411_LENGTH_REQUIRED, NULL);
+  } else {
+    memcpy((char *)hr->r.uri, sp1 + 1, uri_len);
+    ((char *)hr->r.uri)[uri_len] = '\0';
+    size_t path_len = strcspn(hr->r.uri, "?#");
+
+    httpd_uri_t match;
+    bool path_known = false;
+    bool found =
+        handler_find(srv, hr->r.uri, path_len, method, &match, &path_known);
+
+    if (found && match.is_websocket) {
+      httpd_resp_send_err(&hr->r, HTTPD_501_METHOD_NOT_IMPLEMENTED,
+                          "WebSocket not supported by the host server");
+    } else if (found) {
+      hr->r.user_ctx = match.user_ctx;
+      if (match.handler(&hr->r) != ESP_OK)
+        hr->failed = true; // The device closes the session on error
+    } else if (path_known) {
+      httpd_resp_send_err(&hr->r, HTTPD_405_METHOD_NOT_ALLOWED, NULL);
+    } else {
+      httpd_resp_send_404(&hr->r);
+    }
+  }
+
+  if (hr->detached) {
+    free(hr); // The async copy owns the request now
+    return;
+  }
+
+  char sink[256];
+  while (!hr->failed && hr->body_left > 0)
+    if (httpd_req_recv(&hr->r, sink, sizeof(sink)) <= 0)
+      hr->failed = true;
+  bool close_sess = hr->failed || !hr->keep_alive;
+  free(hr);
+  if (close_sess)
+    sess_close(srv, s);
+}
+
+// Serves every complete request already buffered on s
+static void sess_drain(host_server_t *srv, host_sess_t *s) {
+  while (s->fd >= 0 && !s->busy && memmem(s->buf, s->len, "\r\n\r\n", 4)) {
+    s->lru = ++srv->lru_clock;
+    req_handle(srv, s);
+  }
+}
+
+static void sess_read(host_server_t *srv, host_sess_t *s) {
+  if (s->len >= sizeof(s->buf)) {
+    sess_close(srv, s);
+    return;
+  }
+  ssize_t n = recv(s->fd, s->buf + s->len, sizeof(s->buf) - s->len, 0);
+  if (n <= 0) {
+    if (n < 0 && errno == EINTR)
+      return;
+    sess_close(srv, s);
+    return;
+  }
+  s->len += (size_t)n;
+  if (memmem(s->buf, s->len, "\r\n\r\n", 4))
+    sess_drain(srv, s);
+  else if (s->len >= HOST_HDR_MAX)
+    req_handle(srv, s); // Answers 431 and closes
+}
+
+static host_sess_t *sess_lru(host_server_t *srv) {
+  host_sess_t *victim = NULL;
+  for (size_t i = 0; i < srv->config.max_open_sockets; i++) {
+    host_sess_t *s = &srv->sess[i];
+    if (s->fd >= 0 && !s->busy && (!victim || s->lru < victim->lru))
+      victim = s;
+  }
+  return victim;
+}
+
+static host_sess_t *sess_free_slot(host_server_t *srv) {
+  for (size_t i = 0; i < srv->config.max_open_sockets; i++)
+    if (srv->sess[i].fd < 0)
+      return &srv->sess[i];
+  return NULL;
+}
+
+static void sock_configure(host_server_t *srv, int fd) {
+  struct timeval rcv = {.tv_sec = srv->config.recv_wait_timeout};
+  struct timeval snd = {.tv_sec = srv->config.send_wait_timeout};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &rcv, sizeof(rcv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &snd, sizeof(snd));
+  // lwIP answers small requests in one segment; match it on loopback
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (srv->config.keep_alive_enable) {
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &srv->config.keep_alive_idle,
+               sizeof(int));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL,
+               &srv->config.keep_alive_interval, sizeof(int));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &srv->config.keep_alive_count,
+               sizeof(int));
+  }
+}
+
+static void sess_accept(host_server_t *srv) {
+  int fd = accept(srv->listen_fd, NULL, NULL);
+  if (fd < 0)
+    return;
+
+  host_sess_t *s = sess_free_slot(srv);
+  if (!s && srv->config.lru_purge_enable) {
+    host_sess_t *victim = sess_lru(srv);
+    if (victim) {
+      ESP_LOGD(TAG, "Purging LRU session %d", victim->fd);
+      sess_close(srv, victim);
+      s = victim;
+    }
+  }
+  if (!s) {
+    close(fd);
+    return;
+  }
+
+  sock_configure(srv, fd);
+  if (srv->config.open_fn && srv->config.open_fn(srv, fd) != ESP_OK) {
+    close(fd);
+    return;
+  }
+  s->fd = fd;
+  s->busy = false;
+  s->close_after = false;
+  s->len = 0;
+  s->lru = ++srv->lru_clock;
+}
+
+static void ctrl_read(host_server_t *srv) {
+  int idx;
+  if (read(srv->ctrl[0], &idx, sizeof(idx)) != sizeof(idx) || idx < 0 ||
+      (size_t)idx >= srv->config.max_open_sockets)
+    return;
+  host_sess_t *s = &srv->sess[idx];
+  s->busy = false;
+  if (s->close_after) {
+    sess_close(srv, s);
+    return;
+  }
+  s->lru = ++srv->lru_clock;
+  sess_drain(srv, s);
+}
+
+static void *server_task(void *arg) {
+  host_server_t *srv = arg;
+  while (!srv->stop) {
+    fd_set rd;
+    FD_ZERO(&rd);
+    int maxfd = srv->ctrl[0];
+    FD_SET(srv->ctrl[0], &rd);
+
+    // Without LRU purge a full server stops accepting, as on the device
+    if (srv->config.lru_purge_enable || sess_free_slot(srv)) {
+      FD_SET(srv->listen_fd, &rd);
+      if (srv->listen_fd > maxfd)
+        maxfd = srv->listen_fd;
+    }
+    for (size_t i = 0; i < srv->config.max_open_sockets; i++) {
+      host_sess_t *s = &srv->sess[i];
+      if (s->fd < 0 || s->busy)
+        continue;
+      FD_SET(s->fd, &rd);
+      if (s->fd > maxfd)
+        maxfd = s->fd;
+    }
+
+    if (select(maxfd + 1, &rd, NULL, NULL, NULL) < 0) {
+      if (errno == EINTR)
+        continue;
+      ESP_LOGE(TAG, "select: %s", strerror(errno));
+      break;
+    }
+
+    if (FD_ISSET(srv->ctrl[0], &rd))
+      ctrl_read(srv);
+    for (size_t i = 0; i < srv->config.max_open_sockets; i++) {
+      host_sess_t *s = &srv->sess[i];
+      if (s->fd >= 0 && !s->busy && FD_ISSET(s->fd, &rd))
+        sess_read(srv, s);
+    }
+    if (FD_ISSET(srv->listen_fd, &rd))
+      sess_accept(srv);
+  }
+  return NULL;
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config) {
+  if (!handle || !config || config->max_open_sockets == 0)
+    return ESP_ERR_INVALID_ARG;
+
+  host_server_t *srv = calloc(1, sizeof(*srv));
+  if (!srv)
+    return ESP_ERR_NO_MEM;
+  srv->config = *config;
+  pthread_mutex_init(&srv->handlers_lock, NULL);
+  srv->handlers = calloc(config->max_uri_handlers, sizeof(*srv->handlers));
+  srv->sess = calloc(config->max_open_sockets, sizeof(*srv->sess));
+  if (!srv->handlers || !srv->sess)
+    goto fail;
+  for (size_t i = 0; i < config->max_open_sockets; i++)
+    srv->sess[i].fd = -1;
+
+  if (pipe(srv->ctrl) != 0)
+    goto fail;
+
+  uint16_t port = s_port_override ? s_port_override : config->server_port;
+  srv->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(srv->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {
+      .sin_family = AF_INET,
+      .sin_port = htons(port),
+      .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+  };
+  if (srv->listen_fd < 0 ||
+      bind(srv->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(srv->listen_fd, config->backlog_conn) != 0) {
+    ESP_LOGE(TAG, "Cannot listen on port %u: %s", port, strerror(errno));
+    goto fail;
+  }
+
+  if (pthread_create(&srv->thread, NULL, server_task, srv) != 0)
+    goto fail;
+  ESP_LOGI(TAG, "Listening on 127.0.0.1:%u", port);
+  *handle = srv;
+  return ESP_OK;
+
+fail:
+  if (srv->listen_fd > 0)
+    close(srv->listen_fd);
+  free(srv->handlers);
+  free(srv->sess);
+  free(srv);
+  return ESP_FAIL;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+  host_server_t *srv = handle;
+  if (!srv)
+    return ESP_ERR_INVALID_ARG;
+  srv->stop = true;
+  int idx = -1;
+  if (write(srv->ctrl[1], &idx, sizeof(idx)) != sizeof(idx))
+    return ESP_FAIL;
+  pthread_join(srv->thread, NULL);
+  for (size_t i = 0; i < srv->config.max_open_sockets; i++)
+    sess_close(srv, &srv->sess[i]);
+  close(srv->listen_fd);
+  close(srv->ctrl[0]);
+  close(srv->ctrl[1]);
+  free(srv->handlers);
+  free(srv->sess);
+  free(srv);
+  return ESP_OK;
+}
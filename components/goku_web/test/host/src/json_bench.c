@@ -0,0 +1,379 @@
+/**
+ * @file json_bench.c
+ * @brief web_json writer against the cJSON tree it replaced
+ *
+ * Builds the same documents both ways: through web_json, as the handlers
+ * do now, and through cJSON_CreateObject() + cJSON_PrintUnformatted(), as
+ * they did before. The response is captured by httpd stubs instead of a
+ * socket. Prints time, heap allocations and peak heap per document, and
+ * whether both paths produced the same bytes.
+ *
+ * Usage: goku_json_bench [seconds per case, default 0.3]
+ */
+
+#include "cJSON.h"
+#include "esp_http_server.h"
+#include "web_json.h"
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* --- Heap accounting: every malloc in the process, cJSON included --- */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static _Thread_local bool s_counting;
+static uint64_t s_allocs;
+static size_t s_live;
+static size_t s_peak;
+
+static void heap_add(void *p) {
+  if (!p || !s_counting)
+    return;
+  s_allocs++;
+  s_live += malloc_usable_size(p);
+  if (s_live > s_peak)
+    s_peak = s_live;
+}
+
+static void heap_sub(void *p) {
+  if (!p || !s_counting)
+    return;
+  size_t n = malloc_usable_size(p);
+  s_live = s_live > n ? s_live - n : 0;
+}
+
+void *malloc(size_t size) {
+  void *p = __libc_malloc(size);
+  heap_add(p);
+  return p;
+}
+
+void *calloc(size_t n, size_t size) {
+  void *p = __libc_calloc(n, size);
+  heap_add(p);
+  return p;
+}
+
+void *realloc(void *ptr, size_t size) {
+  heap_sub(ptr);
+  void *p = __libc_realloc(ptr, size);
+  heap_add(p);
+  return p;
+}
+
+void free(void *ptr) {
+  heap_sub(ptr);
+  __libc_free(ptr);
+}
+
+/* --- httpd stubs: the response lands in s_out --- */
+
+static char s_out[16384];
+static size_t s_out_len;
+
+static void out_append(const char *buf, ssize_t len) {
+  if (len < 0)
+    len = (ssize_t)strlen(buf);
+  if (s_out_len + (size_t)len > sizeof(s_out))
+    abort();
+  memcpy(s_out + s_out_len, buf, (size_t)len);
+  s_out_len += (size_t)len;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len) {
+  if (buf)
+    out_append(buf, buf_len);
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf,
+                                ssize_t buf_len) {
+  if (buf)
+    out_append(buf, buf_len);
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type) {
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field,
+                             const char *value) {
+  return ESP_OK;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field,
+                                      char *val, size_t val_size) {
+  return ESP_ERR_NOT_FOUND; // No Accept header: JSON
+}
+
+/* --- Documents, as goku_web answers them --- */
+
+#define BENCH_KEYS 24
+
+static char s_keys[BENCH_KEYS][16];
+
+// GET /api/ac/state
+static void ac_state_old(httpd_req_t *req) {
+  cJSON *root = cJSON_CreateObject();
+  cJSON_AddBoolToObject(root, "power", true);
+  cJSON_AddNumberToObject(root, "mode", 1);
+  cJSON_AddNumberToObject(root, "temp", 24);
+  cJSON_AddNumberToObject(root, "fan", 0);
+  cJSON_AddNumberToObject(root, "brand", 0);
+
+  char *str = cJSON_PrintUnformatted(root);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_send(req, str, HTTPD_RESP_USE_STRLEN);
+
+  cJSON_Delete(root);
+  free(str);
+}
+
+static void ac_state_new(httpd_req_t *req) {
+  web_json_t w;
+  web_json_begin(&w, req);
+  web_json_obj_open(&w, NULL);
+  web_json_bool(&w, "power", true);
+  web_json_uint(&w, "mode", 1);
+  web_json_uint(&w, "temp", 24);
+  web_json_uint(&w, "fan", 0);
+  web_json_uint(&w, "brand", 0);
+  web_json_obj_close(&w);
+  web_json_end(&w);
+}
+
+// GET /api/ir/list
+static void ir_list_old(httpd_req_t *req) {
+  cJSON *list = cJSON_CreateArray();
+  for (int i = 0; i < BENCH_KEYS; i++)
+    cJSON_AddItemToArray(list, cJSON_CreateString(s_keys[i]));
+  char *json_str = cJSON_PrintUnformatted(list);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
+  cJSON_Delete(list);
+  free(json_str);
+}
+
+static void ir_list_new(httpd_req_t *req) {
+  web_json_t w;
+  web_json_begin(&w, req);
+  web_json_arr_open(&w, NULL);
+  for (int i = 0; i < BENCH_KEYS; i++)
+    web_json_str(&w, NULL, s_keys[i]);
+  web_json_arr_close(&w);
+  web_json_end(&w);
+}
+
+// GET /api/led/config
+static void led_config_old(httpd_req_t *req) {
+  cJSON *root = cJSON_CreateObject();
+  cJSON_AddNumberToObject(root, "speed", 50);
+  cJSON_AddNumberToObject(root, "brightness", 128);
+  cJSON_AddStringToObject(root, "effect", "rainbow");
+  cJSON *arr = cJSON_CreateArray();
+  for (int i = 0; i < 8; i++) {
+    cJSON *c = cJSON_CreateArray();
+    cJSON_AddItemToArray(c, cJSON_CreateNumber(i * 30));
+    cJSON_AddItemToArray(c, cJSON_CreateNumber(255 - i * 30));
+    cJSON_AddItemToArray(c, cJSON_CreateNumber(i * 10));
+    cJSON_AddItemToArray(arr, c);
+  }
+  cJSON_AddItemToObject(root, "colors", arr);
+
+  char *json_str = cJSON_PrintUnformatted(root);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
+  cJSON_Delete(root);
+  free(json_str);
+}
+
+static void led_config_new(httpd_req_t *req) {
+  web_json_t w;
+  web_json_begin(&w, req);
+  web_json_obj_open(&w, NULL);
+  web_json_uint(&w, "speed", 50);
+  web_json_uint(&w, "brightness", 128);
+  web_json_str(&w, "effect", "rainbow");
+  web_json_arr_open(&w, "colors");
+  for (int i = 0; i < 8; i++) {
+    web_json_arr_open(&w, NULL);
+    web_json_uint(&w, NULL, i * 30);
+    web_json_uint(&w, NULL, 255 - i * 30);
+    web_json_uint(&w, NULL, i * 10);
+    web_json_arr_close(&w);
+  }
+  web_json_arr_close(&w);
+  web_json_obj_close(&w);
+  web_json_end(&w);
+}
+
+// GET /api/system/stats, in the shape the cJSON version had
+static void stats_old(httpd_req_t *req) {
+  cJSON *root = cJSON_CreateObject();
+  cJSON_AddNumberToObject(root, "uptime", 86400);
+  cJSON_AddNumberToObject(root, "free_heap", 187392);
+  cJSON_AddNumberToObject(root, "min_free_heap", 152116);
+  cJSON_AddNumberToObject(root, "psram_free", 8123456);
+  cJSON_AddNumberToObject(root, "psram_total", 8388608);
+  cJSON_AddNumberToObject(root, "temp", 41.5);
+  cJSON_AddNumberToObject(root, "rssi", -58);
+  cJSON_AddStringToObject(root, "ssid", "home-network");
+  cJSON *cache = cJSON_CreateObject();
+  cJSON_AddNumberToObject(cache, "hits", 1042);
+  cJSON_AddNumberToObject(cache, "misses", 37);
+  cJSON_AddNumberToObject(cache, "evictions", 3);
+  cJSON_AddNumberToObject(cache, "invalidations", 1);
+  cJSON_AddNumberToObject(cache, "entries", 8);
+  cJSON_AddNumberToObject(cache, "bytes", 24576);
+  cJSON_AddNumberToObject(cache, "budget", 32768);
+  cJSON_AddItemToObject(root, "ir_cache", cache);
+  cJSON *wear = cJSON_CreateObject();
+  cJSON_AddNumberToObject(wear, "commits", 12);
+  cJSON_AddNumberToObject(wear, "commit_errors", 0);
+  cJSON_AddNumberToObject(wear, "bytes_written", 9216);
+  cJSON_AddNumberToObject(wear, "ac_changes", 57);
+  cJSON_AddNumberToObject(wear, "ac_writes", 9);
+  cJSON_AddNumberToObject(wear, "ac_coalesced", 48);
+  cJSON_AddBoolToObject(wear, "ac_pending", false);
+  cJSON_AddItemToObject(root, "flash", wear);
+  cJSON_AddStringToObject(root, "version", "1.4.2");
+
+  char *json_str = cJSON_PrintUnformatted(root);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
+  cJSON_Delete(root);
+  free(json_str);
+}
+
+static void stats_new(httpd_req_t *req) {
+  web_json_t w;
+  web_json_begin(&w, req);
+  web_json_obj_open(&w, NULL);
+  web_json_uint(&w, "uptime", 86400);
+  web_json_uint(&w, "free_heap", 187392);
+  web_json_uint(&w, "min_free_heap", 152116);
+  web_json_uint(&w, "psram_free", 8123456);
+  web_json_uint(&w, "psram_total", 8388608);
+  web_json_double(&w, "temp", 41.5);
+  web_json_int(&w, "rssi", -58);
+  web_json_str(&w, "ssid", "home-network");
+  web_json_obj_open(&w, "ir_cache");
+  web_json_uint(&w, "hits", 1042);
+  web_json_uint(&w, "misses", 37);
+  web_json_uint(&w, "evictions", 3);
+  web_json_uint(&w, "invalidations", 1);
+  web_json_uint(&w, "entries", 8);
+  web_json_uint(&w, "bytes", 24576);
+  web_json_uint(&w, "budget", 32768);
+  web_json_obj_close(&w);
+  web_json_obj_open(&w, "flash");
+  web_json_uint(&w, "commits", 12);
+  web_json_uint(&w, "commit_errors", 0);
+  web_json_uint(&w, "bytes_written", 9216);
+  web_json_uint(&w, "ac_changes", 57);
+  web_json_uint(&w, "ac_writes", 9);
+  web_json_uint(&w, "ac_coalesced", 48);
+  web_json_bool(&w, "ac_pending", false);
+  web_json_obj_close(&w);
+  web_json_str(&w, "version", "1.4.2");
+  web_json_obj_close(&w);
+  web_json_end(&w);
+}
+
+/* --- Runner --- */
+
+typedef void (*bench_fn_t)(httpd_req_t *req);
+
+typedef struct {
+  const char *name;
+  bench_fn_t old_fn;
+  bench_fn_t new_fn;
+} bench_case_t;
+
+typedef struct {
+  double ns;       // Per document
+  double allocs;   // Per document
+  size_t peak;     // Heap bytes at the worst point of one document
+  size_t bytes;    // Response size
+  char out[16384]; // Response of the first run
+} bench_result_t;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void bench_run(bench_fn_t fn, double seconds, bench_result_t *res) {
+  httpd_req_t req = {0};
+
+  // One counted run for the heap figures and the output
+  s_allocs = 0;
+  s_live = 0;
+  s_peak = 0;
+  s_out_len = 0;
+  s_counting = true;
+  fn(&req);
+  s_counting = false;
+  res->allocs = (double)s_allocs;
+  res->peak = s_peak;
+  res->bytes = s_out_len;
+  memcpy(res->out, s_out, s_out_len);
+
+  // Then as many as fit in the time budget, in growing batches
+  uint64_t runs = 0;
+  uint64_t batch = 64;
+  double start = now_s();
+  double elapsed = 0;
+  while (elapsed < seconds) {
+    for (uint64_t i = 0; i < batch; i++) {
+      s_out_len = 0;
+      fn(&req);
+    }
+    runs += batch;
+    batch *= 2;
+    elapsed = now_s() - start;
+  }
+  res->ns = elapsed * 1e9 / (double)runs;
+}
+
+int main(int argc, char **argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 0.3;
+  for (int i = 0; i < BENCH_KEYS; i++)
+    snprintf(s_keys[i], sizeof(s_keys[i]), "tv_power_%02d", i);
+
+  static const bench_case_t cases[] = {
+      {"ac_state", ac_state_old, ac_state_new},
+      {"ir_list", ir_list_old, ir_list_new},
+      {"led_config", led_config_old, led_config_new},
+      {"system_stats", stats_old, stats_new},
+  };
+
+  printf("%-14s %6s  %20s  %14s  %16s  %s\n", "document", "bytes",
+         "ns/doc cJSON -> web", "allocs", "peak heap (B)", "output");
+  int differ = 0;
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    static bench_result_t old_res, new_res;
+    bench_run(cases[i].old_fn, seconds, &old_res);
+    bench_run(cases[i].new_fn, seconds, &new_res);
+    bool same = old_res.bytes == new_res.bytes &&
+                memcmp(old_res.out, new_res.out, old_res.bytes) == 0;
+    differ += !same;
+    printf("%-14s %6zu  %8.0f -> %8.0f  %6.0f -> %4.0f  %7zu -> %5zu  %s\n",
+           cases[i].name, new_res.bytes, old_res.ns, new_res.ns,
+           old_res.allocs, new_res.allocs, old_res.peak, new_res.peak,
+           same ? "same" : "differs");
+    if (!same)
+      printf("  cJSON: %.*s\n  web:   %.*s\n", (int)old_res.bytes, old_res.out,
+             (int)new_res.bytes, new_res.out);
+  }
+  return differ ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file main.c
+ * @brief Runs the goku_web server on the host for load tests
+ *
+ * Usage: goku_web_host [port]. The port may also come from GOKU_HOST_PORT
+ * and defaults to 8080. The server runs until SIGINT or SIGTERM.
+ */
+
+#include "esp_log.h"
+#include "goku_web.h"
+#include "host_httpd.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define TAG "host"
+
+static volatile sig_atomic_t s_stop;
+
+static void on_signal(int sig) { s_stop = 1; }
+
+int main(int argc, char **argv) {
+  const char *port = argc > 1 ? argv[1] : getenv("GOKU_HOST_PORT");
+  host_httpd_set_port(port ? (uint16_t)atoi(port) : 8080);
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  signal(SIGPIPE, SIG_IGN);
+
+  if (app_web_init() != ESP_OK) {
+    fprintf(stderr, "Web server failed to start\n");
+    return 1;
+  }
+  // Load scripts wait for this line before sending traffic
+  printf("ready\n");
+  fflush(stdout);
+
+  while (!s_stop)
+    pause();
+  return 0;
+}
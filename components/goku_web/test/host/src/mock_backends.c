@@ -0,0 +1,490 @@
+/**
+ * @file mock_backends.c
+ * @brief In-memory stand-ins for the AC, IR, NVS, LED, log, OTA and Wi-Fi
+ * components behind the web server
+ *
+ * Transmissions hold one transmitter lock for GOKU_HOST_IR_MS (default 100)
+ * to stand in for the RMT airtime, so IR routes queue up as on the device.
+ * The key store starts with GOKU_HOST_IR_KEYS (default 24) keys.
+ */
+
+#include "esp_log.h"
+#include "goku_ac.h"
+#include "goku_data.h"
+#include "goku_ir_app.h"
+#include "goku_ir_cache.h"
+#include "ir_engine.h"
+#include "goku_led.h"
+#include "goku_log.h"
+#include "goku_ota.h"
+#include "goku_settings.h"
+#include "goku_wifi.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TAG "mock"
+
+#define MOCK_KEYS_MAX 128
+#define MOCK_KEY_LEN 16 // NVS key limit, NUL included
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t s_tx_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static unsigned int s_airtime_ms = 100;
+
+static int env_int(const char *name, int def) {
+  const char *v = getenv(name);
+  return v && *v ? atoi(v) : def;
+}
+
+// Holds the transmitter for one frame's airtime
+static void mock_transmit(void) {
+  struct timespec ts = {.tv_sec = s_airtime_ms / 1000,
+                        .tv_nsec = (long)(s_airtime_ms % 1000) * 1000000L};
+  pthread_mutex_lock(&s_tx_lock);
+  nanosleep(&ts, NULL);
+  pthread_mutex_unlock(&s_tx_lock);
+}
+
+void ir_engine_tx_hold(void) { pthread_mutex_lock(&s_tx_lock); }
+
+void ir_engine_tx_release(void) { pthread_mutex_unlock(&s_tx_lock); }
+
+/* --- NVS key store --- */
+
+static char s_keys[MOCK_KEYS_MAX][MOCK_KEY_LEN];
+static size_t s_key_count;
+
+__attribute__((constructor)) static void mock_init(void) {
+  s_airtime_ms = (unsigned int)env_int("GOKU_HOST_IR_MS", 100);
+  int keys = env_int("GOKU_HOST_IR_KEYS", 24);
+  for (int i = 0; i < keys && i < MOCK_KEYS_MAX; i++)
+    snprintf(s_keys[s_key_count++], MOCK_KEY_LEN, "key_%02d", i);
+}
+
+static int key_find(const char *key) {
+  for (size_t i = 0; i < s_key_count; i++)
+    if (strcmp(s_keys[i], key) == 0)
+      return (int)i;
+  return -1;
+}
+
+static esp_err_t key_add(const char *key) {
+  if (strlen(key) >= MOCK_KEY_LEN)
+    return ESP_ERR_INVALID_ARG;
+  pthread_mutex_lock(&s_lock);
+  esp_err_t err = ESP_OK;
+  if (key_find(key) < 0) {
+    if (s_key_count < MOCK_KEYS_MAX)
+      strcpy(s_keys[s_key_count++], key);
+    else
+      err = ESP_ERR_NO_MEM;
+  }
+  pthread_mutex_unlock(&s_lock);
+  return err;
+}
+
+// Stored frames are not kept; a key reads as one captured NEC frame
+esp_err_t app_data_load_ir(const char *key, void *data, size_t *len) {
+  pthread_mutex_lock(&s_lock);
+  int i = key_find(key);
+  pthread_mutex_unlock(&s_lock);
+  if (i < 0)
+    return ESP_ERR_NOT_FOUND;
+  if (data)
+    memset(data, 0, *len);
+  *len = 67 * sizeof(uint16_t);
+  return ESP_OK;
+}
+
+esp_err_t app_data_delete_ir(const char *key) {
+  pthread_mutex_lock(&s_lock);
+  int i = key_find(key);
+  if (i >= 0)
+    memcpy(s_keys[i], s_keys[--s_key_count], MOCK_KEY_LEN);
+  pthread_mutex_unlock(&s_lock);
+  return i >= 0 ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t app_data_rename_ir(const char *old_key, const char *new_key) {
+  if (strlen(new_key) >= MOCK_KEY_LEN)
+    return ESP_ERR_INVALID_ARG;
+  pthread_mutex_lock(&s_lock);
+  int i = key_find(old_key);
+  esp_err_t err = ESP_ERR_NOT_FOUND;
+  if (i >= 0 && key_find(new_key) >= 0) {
+    err = ESP_ERR_INVALID_STATE;
+  } else if (i >= 0) {
+    strcpy(s_keys[i], new_key);
+    err = ESP_OK;
+  }
+  pthread_mutex_unlock(&s_lock);
+  return err;
+}
+
+esp_err_t app_data_foreach_ir_key(app_data_ir_key_cb_t cb, void *ctx) {
+  if (!cb)
+    return ESP_ERR_INVALID_ARG;
+  char keys[MOCK_KEYS_MAX][MOCK_KEY_LEN];
+  pthread_mutex_lock(&s_lock);
+  size_t n = s_key_count;
+  memcpy(keys, s_keys, n * MOCK_KEY_LEN);
+  pthread_mutex_unlock(&s_lock);
+  for (size_t i = 0; i < n; i++)
+    if (!cb(keys[i], ctx))
+      break;
+  return ESP_OK;
+}
+
+/* --- IR --- */
+
+static bool s_learning;
+static uint32_t s_learned;
+
+// The remote is pressed straight away: a captured NEC frame
+esp_err_t app_ir_start_learn(void) {
+  s_learning = true;
+  s_learned = 67;
+  return ESP_OK;
+}
+
+esp_err_t app_ir_stop_learn(void) {
+  s_learning = false;
+  return ESP_OK;
+}
+
+bool app_ir_get_learn_status(uint32_t *count) {
+  if (count)
+    *count = s_learned;
+  return s_learning;
+}
+
+esp_err_t app_ir_save_learned_result(const char *key) {
+  if (s_learned == 0)
+    return ESP_ERR_INVALID_STATE;
+  s_learning = false;
+  return key_add(key);
+}
+
+esp_err_t app_ir_send_key(const char *key) {
+  pthread_mutex_lock(&s_lock);
+  bool found = key_find(key) >= 0;
+  pthread_mutex_unlock(&s_lock);
+  if (!found)
+    return ESP_ERR_NOT_FOUND;
+  mock_transmit();
+  return ESP_OK;
+}
+
+esp_err_t app_ir_send_raw(const uint16_t *durations, size_t count) {
+  if (!durations || count == 0)
+    return ESP_ERR_INVALID_ARG;
+  mock_transmit();
+  return ESP_OK;
+}
+
+void app_ir_cache_get_stats(app_ir_cache_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->budget = 32 * 1024;
+}
+
+/* --- AC --- */
+
+static ir_ac_state_t s_ac = {.mode = IR_AC_MODE_COOL, .temp = 24};
+static ac_brand_t s_brand = AC_BRAND_DAIKIN;
+static app_ac_change_cb_t s_change_cb;
+static app_ac_persist_stats_t s_persist;
+static app_ac_sched_stats_t s_sched;
+
+bool app_ac_update_state(const ir_ac_state_t *delta, ac_brand_t brand,
+                         uint32_t fields) {
+  pthread_mutex_lock(&s_lock);
+  ir_ac_state_t next = s_ac;
+  ac_brand_t next_brand = s_brand;
+  if (delta) {
+    if (fields & APP_AC_FIELD_POWER)
+      next.power = delta->power;
+    if (fields & APP_AC_FIELD_TEMP)
+      next.temp = delta->temp;
+    if (fields & APP_AC_FIELD_MODE)
+      next.mode = delta->mode;
+    if (fields & APP_AC_FIELD_FAN)
+      next.fan = delta->fan;
+    if (fields & APP_AC_FIELD_SWING_V)
+      next.swing_v = delta->swing_v;
+    if (fields & APP_AC_FIELD_SWING_H)
+      next.swing_h = delta->swing_h;
+  }
+  if ((fields & APP_AC_FIELD_BRAND) && brand < AC_BRAND_MAX)
+    next_brand = brand;
+  bool changed = next_brand != s_brand || memcmp(&next, &s_ac, sizeof(next));
+  s_ac = next;
+  s_brand = next_brand;
+  if (changed)
+    s_persist.changes++;
+  pthread_mutex_unlock(&s_lock);
+
+  if (changed && s_change_cb)
+    s_change_cb();
+  return changed;
+}
+
+void app_ac_get_state(ir_ac_state_t *state) {
+  pthread_mutex_lock(&s_lock);
+  *state = s_ac;
+  pthread_mutex_unlock(&s_lock);
+}
+
+ac_brand_t app_ac_get_brand(void) { return s_brand; }
+
+void app_ac_set_change_cb(app_ac_change_cb_t cb) { s_change_cb = cb; }
+
+void app_ac_get_persist_stats(app_ac_persist_stats_t *stats) {
+  pthread_mutex_lock(&s_lock);
+  *stats = s_persist;
+  pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t app_ac_send(void) {
+  mock_transmit();
+  pthread_mutex_lock(&s_lock);
+  s_sched.transmissions++;
+  pthread_mutex_unlock(&s_lock);
+  return ESP_OK;
+}
+
+// No coalescing: every request is its own transmission
+esp_err_t app_ac_request_send_wait(app_ac_source_t source,
+                                   uint32_t timeout_ms) {
+  if (source >= APP_AC_SRC_COUNT)
+    return ESP_ERR_INVALID_ARG;
+  pthread_mutex_lock(&s_lock);
+  s_sched.sources[source].received++;
+  s_sched.sources[source].transmitted++;
+  pthread_mutex_unlock(&s_lock);
+  return app_ac_send();
+}
+
+void app_ac_get_sched_stats(app_ac_sched_stats_t *stats) {
+  pthread_mutex_lock(&s_lock);
+  *stats = s_sched;
+  pthread_mutex_unlock(&s_lock);
+}
+
+const char *app_ac_source_to_str(app_ac_source_t source) {
+  switch (source) {
+  case APP_AC_SRC_WEB:
+    return "web";
+  case APP_AC_SRC_CLOUD:
+    return "cloud";
+  case APP_AC_SRC_LOCAL:
+    return "local";
+  default:
+    return "unknown";
+  }
+}
+
+/* --- LED --- */
+
+static const char *const s_effect_names[] = {
+    "static",
+    "rainbow",
+    "running",
+    "breathing",
+    "blink",
+    "knight_rider",
+    "loading",
+    "color_wipe",
+    "theater_chase",
+    "fire",
+    "sparkle",
+    "random",
+    "auto_cycle",
+};
+
+static struct {
+  uint8_t rgb[3];
+  app_led_effect_t effect;
+  uint8_t brightness;
+  uint8_t speed;
+  uint8_t colors[8][3];
+  uint8_t state_rgb[APP_SETTINGS_LED_STATE_COUNT][3];
+} s_led = {.rgb = {0, 0, 255}, .brightness = 128, .speed = 50};
+
+const char *app_led_effect_to_str(app_led_effect_t effect) {
+  if ((unsigned int)effect >=
+      sizeof(s_effect_names) / sizeof(s_effect_names[0]))
+    return s_effect_names[APP_LED_EFFECT_STATIC];
+  return s_effect_names[effect];
+}
+
+bool app_led_effect_from_str(const char *name, app_led_effect_t *out) {
+  for (size_t i = 0; i < sizeof(s_effect_names) / sizeof(s_effect_names[0]);
+       i++) {
+    if (strcmp(name, s_effect_names[i]) == 0) {
+      *out = (app_led_effect_t)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+esp_err_t app_led_set_config(app_led_effect_t effect, uint8_t index, uint8_t r,
+                             uint8_t g, uint8_t b) {
+  if (index >= 8)
+    return ESP_ERR_INVALID_ARG;
+  s_led.effect = effect;
+  s_led.colors[index][0] = r;
+  s_led.colors[index][1] = g;
+  s_led.colors[index][2] = b;
+  if (index == 0) {
+    s_led.rgb[0] = r;
+    s_led.rgb[1] = g;
+    s_led.rgb[2] = b;
+  }
+  return ESP_OK;
+}
+
+esp_err_t app_led_set_effect(app_led_effect_t effect) {
+  s_led.effect = effect;
+  return ESP_OK;
+}
+
+esp_err_t app_led_set_brightness(uint8_t brightness) {
+  s_led.brightness = brightness;
+  return ESP_OK;
+}
+
+esp_err_t app_led_set_speed(uint8_t speed) {
+  s_led.speed = speed;
+  return ESP_OK;
+}
+
+esp_err_t app_led_get_effect_config(app_led_effect_t effect, uint8_t *speed,
+                                    uint8_t colors[8][3]) {
+  *speed = s_led.speed;
+  memcpy(colors, s_led.colors, sizeof(s_led.colors));
+  return ESP_OK;
+}
+
+esp_err_t app_led_get_config(uint8_t *r, uint8_t *g, uint8_t *b,
+                             app_led_effect_t *effect, uint8_t *brightness,
+                             uint8_t *speed) {
+  if (r)
+    *r = s_led.rgb[0];
+  if (g)
+    *g = s_led.rgb[1];
+  if (b)
+    *b = s_led.rgb[2];
+  if (effect)
+    *effect = s_led.effect;
+  if (brightness)
+    *brightness = s_led.brightness;
+  if (speed)
+    *speed = s_led.speed;
+  return ESP_OK;
+}
+
+esp_err_t app_led_set_state_color(app_led_state_t state, uint8_t r, uint8_t g,
+                                  uint8_t b) {
+  if ((unsigned int)state >= APP_SETTINGS_LED_STATE_COUNT)
+    return ESP_ERR_INVALID_ARG;
+  s_led.state_rgb[state][0] = r;
+  s_led.state_rgb[state][1] = g;
+  s_led.state_rgb[state][2] = b;
+  return ESP_OK;
+}
+
+esp_err_t app_led_get_state_color(app_led_state_t state, uint8_t *r, uint8_t *g,
+                                  uint8_t *b) {
+  if ((unsigned int)state >= APP_SETTINGS_LED_STATE_COUNT)
+    return ESP_ERR_INVALID_ARG;
+  *r = s_led.state_rgb[state][0];
+  *g = s_led.state_rgb[state][1];
+  *b = s_led.state_rgb[state][2];
+  return ESP_OK;
+}
+
+esp_err_t app_led_save_settings(void) { return ESP_OK; }
+
+/* --- Log ring: empty, the host prints to stderr instead --- */
+
+size_t app_log_read_since(uint64_t cursor, char *dest, size_t max_len,
+                          uint64_t *next, uint64_t *dropped) {
+  if (next)
+    *next = cursor;
+  if (dropped)
+    *dropped = 0;
+  return 0;
+}
+
+size_t app_log_read_until(uint64_t cursor, uint64_t end, char *dest,
+                          size_t max_len, uint64_t *next, uint64_t *dropped) {
+  return app_log_read_since(cursor, dest, max_len, next, dropped);
+}
+
+uint64_t app_log_get_cursor(void) { return 0; }
+
+void app_log_clear(void) {}
+
+void app_log_get_stats(app_log_stats_t *out) { memset(out, 0, sizeof(*out)); }
+
+esp_err_t app_log_get_previous(app_log_previous_t *out) {
+  return ESP_ERR_NOT_FOUND;
+}
+
+size_t app_log_read_previous(size_t offset, char *dest, size_t max_len) {
+  return 0;
+}
+
+esp_err_t app_log_set_tag(const char *tag, esp_log_level_t level,
+                          uint8_t sample, uint16_t per_min) {
+  esp_log_level_set(tag, level);
+  return ESP_OK;
+}
+
+esp_err_t app_log_reset_tag(const char *tag) { return ESP_ERR_NOT_FOUND; }
+
+size_t app_log_get_tags(app_log_tag_info_t *out, size_t max) { return 0; }
+
+/* --- Settings, OTA, Wi-Fi --- */
+
+void app_settings_get_stats(app_settings_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->loaded_version = 2;
+}
+
+const char *app_ota_get_cached_version(void) { return PROJECT_VERSION; }
+
+bool app_ota_is_update_available(void) { return false; }
+
+void app_ota_trigger_check(void) {}
+
+esp_err_t app_ota_start(const char *url) {
+  ESP_LOGW(TAG, "OTA to %s ignored on host", url ? url : "(default)");
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t app_wifi_update_credentials(const char *ssid, const char *password) {
+  return ESP_OK;
+}
+
+esp_err_t app_wifi_get_scan_results(wifi_ap_record_t **ap_list,
+                                    uint16_t *count) {
+  static const char *const ssids[] = {"host", "neighbour", "guest"};
+  size_t n = sizeof(ssids) / sizeof(ssids[0]);
+  wifi_ap_record_t *list = calloc(n, sizeof(*list));
+  if (!list)
+    return ESP_ERR_NO_MEM;
+  for (size_t i = 0; i < n; i++) {
+    strcpy((char *)list[i].ssid, ssids[i]);
+    list[i].rssi = (int8_t)(-45 - 10 * (int)i);
+    list[i].primary = 1 + 5 * i;
+    list[i].authmode = WIFI_AUTH_WPA2_PSK;
+  }
+  *ap_list = list;
+  *count = (uint16_t)n;
+  return ESP_OK;
+}
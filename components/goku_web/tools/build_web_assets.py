@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Bundle the web UI into a single gzip-compressed page.
+
+Inlines the local stylesheet and script referenced by www/index.html,
+applies a whitespace-only minification and writes:
+
+  <out>       gzip of the bundled page (deterministic: mtime=0)
+  <etag>      quoted content hash of <out>, used as the HTTP ETag
+
+Invoked from components/goku_web/CMakeLists.txt at build time.
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+
+def minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    css = re.sub(r"\s+", " ", css)
+    css = re.sub(r"\s*([{};,])\s*", r"\1", css)
+    return css.replace(";}", "}").strip()
+
+
+def minify_js(js):
+    # Whitespace only: keep every line break so ASI behaves exactly as in
+    # the source, drop indentation, blank lines and full-line comments.
+    lines = []
+    for line in js.splitlines():
+        line = line.strip()
+        if not line or line.startswith("//"):
+            continue
+        lines.append(line)
+    return "\n".join(lines)
+
+
+def minify_html(html):
+    html = re.sub(r">\s*\n\s*<", "><", html)
+    return re.sub(r"\s*\n\s*", " ", html).strip()
+
+
+def bundle(src_dir):
+    def read(name):
+        with open(os.path.join(src_dir, name), encoding="utf-8") as f:
+            return f.read()
+
+    html = minify_html(read("index.html"))
+
+    def inline_css(m):
+        return "<style>" + minify_css(read(m.group(1))) + "</style>"
+
+    def inline_js(m):
+        return "<script>" + minify_js(read(m.group(1))) + "</script>"
+
+    # Only local assets are inlined; CDN links stay as they are
+    html = re.sub(r"<link rel='stylesheet' href='([\w.-]+\.css)'>", inline_css,
+                  html)
+    html = re.sub(r"<script src='([\w.-]+\.js)'></script>", inline_js, html)
+    return html.encode("utf-8")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--src", required=True, help="www source directory")
+    parser.add_argument("--out", required=True, help="output .gz file")
+    parser.add_argument("--etag", required=True, help="output ETag file")
+    args = parser.parse_args()
+
+    page = bundle(args.src)
+    gz = gzip.compress(page, compresslevel=9, mtime=0)
+    etag = '"' + hashlib.sha256(gz).hexdigest()[:16] + '"'
+
+    with open(args.out, "wb") as f:
+        f.write(gz)
+    with open(args.etag, "w", encoding="ascii") as f:
+        f.write(etag)
+
+    print("web assets: %d -> %d bytes gzip, ETag %s" % (len(page), len(gz), etag))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,341 @@
+#!/usr/bin/env python3
+"""Load test the device web server with many dashboard-like clients.
+
+Each polling client holds one keep-alive connection and issues requests
+drawn from a weighted mix, reconnecting whenever the device closes it
+(LRU purge, timeouts). Idle clients open a connection and never send,
+the way a backgrounded browser tab does. At the end it prints throughput,
+latency percentiles per operation, errors, reconnects and the change in
+the "http" section of /api/system/stats:
+
+  tools/load_test.py 192.168.1.50 --clients 12 --idle 4 --duration 30
+  tools/load_test.py 192.168.1.50 --mix stats=4 ir=2 index=1 ac=1
+
+Mix entries are NAME[=WEIGHT], where NAME is one of the operations below
+or any GET path. "ac" transmits IR, so it is not in the default mix.
+
+--json writes the results for later runs; --baseline compares against
+such a file and exits with status 1 when throughput drops or p50/p99
+grow by more than --tolerance percent, so runs can gate CI on a bench
+device.
+
+--server starts a local server first and stops it afterwards, which with
+the host build in test/host gives the same run on Linux without a device:
+
+  tools/load_test.py 127.0.0.1 --port 8080 \
+      --server "build-host/goku_web_host 8080" \
+      --mix stats=4 ir=2 index=1 ac=1 --baseline host.json
+
+Standard library only; not part of the build.
+"""
+
+import argparse
+import http.client
+import json
+import random
+import shlex
+import socket
+import subprocess
+import sys
+import threading
+import time
+
+OPS = {
+    "ac": ("POST", "/api/ac/control?async=1", b'{"temp":24}'),
+    "ir": ("GET", "/api/ir/list", None),
+    "stats": ("GET", "/api/system/stats", None),
+    "index": ("GET", "/", None),
+}
+
+DEFAULT_MIX = ["stats=4", "ir=2", "index=1"]
+
+
+def parse_mix(entries):
+    mix = []
+    for entry in entries:
+        name, _, weight = entry.partition("=")
+        if name in OPS:
+            method, path, body = OPS[name]
+        elif name.startswith("/"):
+            method, path, body = "GET", name, None
+        else:
+            raise SystemExit(f"unknown operation '{name}'")
+        try:
+            weight = int(weight) if weight else 1
+        except ValueError:
+            raise SystemExit(f"bad weight in '{entry}'")
+        if weight > 0:
+            mix.append((name, method, path, body, weight))
+    if not mix:
+        raise SystemExit("empty mix")
+    return mix
+
+
+def fetch_conn_stats(host, port, timeout):
+    conn = http.client.HTTPConnection(host, port, timeout=timeout)
+    try:
+        conn.request("GET", "/api/system/stats")
+        resp = conn.getresponse()
+        body = resp.read()
+        if resp.status != 200:
+            return None
+        return json.loads(body).get("http")
+    except (OSError, http.client.HTTPException, ValueError):
+        return None
+    finally:
+        conn.close()
+
+
+class Poller(threading.Thread):
+    def __init__(self, args, mix, seed, deadline):
+        super().__init__(daemon=True)
+        self.args = args
+        self.mix = mix
+        self.rng = random.Random(seed)
+        self.deadline = deadline
+        self.latencies = {op[0]: [] for op in mix}
+        self.errors = 0
+        self.reconnects = 0
+        self.status = {}
+
+    def connect(self):
+        return http.client.HTTPConnection(
+            self.args.host, self.args.port, timeout=self.args.timeout
+        )
+
+    def run(self):
+        weights = [op[4] for op in self.mix]
+        headers = {"Accept-Encoding": "gzip"}
+        conn = self.connect()
+        while time.monotonic() < self.deadline:
+            op = self.rng.choices(self.mix, weights)[0]
+            name, method, path, body, _ = op
+            start = time.monotonic()
+            try:
+                conn.request(method, path, body=body, headers=headers)
+                resp = conn.getresponse()
+                resp.read()
+            except (OSError, http.client.HTTPException):
+                # Closed by the server or timed out: count it and start over
+                self.errors += 1
+                self.reconnects += 1
+                conn.close()
+                conn = self.connect()
+                continue
+            self.latencies[name].append((time.monotonic() - start) * 1000)
+            self.status[resp.status] = self.status.get(resp.status, 0) + 1
+            if resp.will_close:
+                self.reconnects += 1
+                conn.close()
+                conn = self.connect()
+            if self.args.interval:
+                time.sleep(self.args.interval / 1000)
+        conn.close()
+
+
+def open_idle(host, port, count, timeout):
+    socks = []
+    for _ in range(count):
+        try:
+            socks.append(socket.create_connection((host, port), timeout))
+        except OSError as e:
+            print(f"idle connection failed: {e}", file=sys.stderr)
+    return socks
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return 0.0
+    idx = min(len(sorted_values) - 1, int(len(sorted_values) * pct / 100))
+    return sorted_values[idx]
+
+
+def summarize(values, duration):
+    values = sorted(values)
+    return {
+        "requests": len(values),
+        "rps": round(len(values) / duration, 2),
+        "p50_ms": round(percentile(values, 50), 2),
+        "p99_ms": round(percentile(values, 99), 2),
+        "max_ms": round(values[-1], 2) if values else 0.0,
+    }
+
+
+def compare(results, baseline, tolerance):
+    """Print changes against a baseline; return False on a regression."""
+    ok = True
+    limit = tolerance / 100
+    for name, cur in results["ops"].items():
+        base = baseline.get("ops", {}).get(name)
+        if not base:
+            continue
+        for key, worse_if_higher in (
+            ("rps", False),
+            ("p50_ms", True),
+            ("p99_ms", True),
+        ):
+            if not base[key]:
+                continue
+            change = (cur[key] - base[key]) / base[key]
+            regressed = change > limit if worse_if_higher else -change > limit
+            mark = "  REGRESSION" if regressed else ""
+            print(
+                f"  {name:<16} {key:<7} {base[key]:>9.2f} -> {cur[key]:>9.2f} "
+                f"({change * 100:+.1f}%){mark}"
+            )
+            ok = ok and not regressed
+    return ok
+
+
+def start_server(command, timeout):
+    """Start command and wait until it prints its "ready" line."""
+    proc = subprocess.Popen(
+        shlex.split(command), stdout=subprocess.PIPE, text=True
+    )
+    ready = threading.Event()
+
+    def watch():
+        for line in proc.stdout:
+            if line.strip() == "ready":
+                ready.set()
+
+    threading.Thread(target=watch, daemon=True).start()
+    if not ready.wait(timeout) or proc.poll() is not None:
+        proc.kill()
+        raise SystemExit(f"server '{command}' did not become ready")
+    return proc
+
+
+def stop_server(proc):
+    proc.terminate()
+    try:
+        proc.wait(5)
+    except subprocess.TimeoutExpired:
+        proc.kill()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("host", help="device address")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument(
+        "--clients", type=int, default=8, help="polling clients (default 8)"
+    )
+    parser.add_argument(
+        "--idle", type=int, default=0, help="connections that never send"
+    )
+    parser.add_argument(
+        "--duration", type=float, default=20, help="seconds (default 20)"
+    )
+    parser.add_argument(
+        "--interval", type=float, default=0, help="ms between requests"
+    )
+    parser.add_argument("--timeout", type=float, default=5, help="seconds")
+    parser.add_argument(
+        "--mix",
+        nargs="+",
+        default=DEFAULT_MIX,
+        help=f"weighted operations (default {' '.join(DEFAULT_MIX)})",
+    )
+    parser.add_argument("--seed", type=int, default=1, help="request order")
+    parser.add_argument("--json", help="write results to this file")
+    parser.add_argument("--baseline", help="results file to compare against")
+    parser.add_argument(
+        "--tolerance",
+        type=float,
+        default=10,
+        help="allowed regression in percent (default 10)",
+    )
+    parser.add_argument(
+        "--server", help="command starting a local server for the run"
+    )
+    args = parser.parse_args()
+    mix = parse_mix(args.mix)
+
+    server = start_server(args.server, args.timeout) if args.server else None
+    try:
+        return run(args, mix)
+    finally:
+        if server:
+            stop_server(server)
+
+
+def run(args, mix):
+
+    before = fetch_conn_stats(args.host, args.port, args.timeout)
+    idle = open_idle(args.host, args.port, args.idle, args.timeout)
+
+    deadline = time.monotonic() + args.duration
+    pollers = [
+        Poller(args, mix, args.seed + i, deadline) for i in range(args.clients)
+    ]
+    for p in pollers:
+        p.start()
+    for p in pollers:
+        p.join()
+    for s in idle:
+        s.close()
+
+    results = {
+        "config": {
+            "clients": args.clients,
+            "idle": args.idle,
+            "duration": args.duration,
+            "mix": args.mix,
+        },
+        "total": summarize(
+            [v for p in pollers for lat in p.latencies.values() for v in lat],
+            args.duration,
+        ),
+        "ops": {
+            op[0]: summarize(
+                [v for p in pollers for v in p.latencies[op[0]]], args.duration
+            )
+            for op in mix
+        },
+        "status": {},
+        "errors": sum(p.errors for p in pollers),
+        "reconnects": sum(p.reconnects for p in pollers),
+    }
+    status = results["status"]
+    for p in pollers:
+        for code, n in p.status.items():
+            status[str(code)] = status.get(str(code), 0) + n
+
+    rows = [("total", results["total"])] + list(results["ops"].items())
+    for name, s in rows:
+        print(
+            f"{name:<16} {s['requests']:>7} req {s['rps']:>8.1f}/s  "
+            f"p50 {s['p50_ms']:.1f} ms  p99 {s['p99_ms']:.1f} ms  "
+            f"max {s['max_ms']:.1f} ms"
+        )
+    print(f"status     {dict(sorted(results['status'].items()))}")
+    print(f"errors     {results['errors']}")
+    print(f"reconnects {results['reconnects']}")
+
+    after = fetch_conn_stats(args.host, args.port, args.timeout)
+    if before and after:
+        print(f"sockets    {after.get('sockets')} (peak {after.get('peak')})")
+        for key in ("opened", "closed_full"):
+            delta = after.get(key, 0) - before.get(key, 0)
+            print(f"{key:<10} +{delta}")
+        results["http"] = after
+    else:
+        print("device connection stats unavailable", file=sys.stderr)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+            f.write("\n")
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        print(f"against {args.baseline} (tolerance {args.tolerance:g}%):")
+        if not compare(results, baseline, args.tolerance):
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,544 @@
+const statusEl = document.getElementById('learnStatus');
+const keyListEl = document.getElementById('keyList');
+function toggleSidebar() {
+  document.getElementById('sidebar').classList.toggle('active');
+  document.getElementById('overlay').classList.toggle('active');
+}
+window.onload = function() {
+  navTo('dashboard');
+  checkUpdate();
+  // Polling fallback while the /ws push channel is down
+  setInterval(() => {
+      if(!wsLive && !document.getElementById('dashboard').classList.contains('hidden')) updateDashboard(); }, 5000);
+  setTimeout(initCharts, 500);
+  document.getElementById('dashStatus').innerText = 'JS Active';
+};
+function navTo(id) {
+  if(window.innerWidth <= 768) toggleSidebar();
+  document.querySelectorAll('.view').forEach(el => el.classList.add('hidden'));
+  const el = document.getElementById(id);
+  if(el) el.classList.remove('hidden');
+  if(id === 'dashboard') updateDashboard();
+  if(id === 'controls' || id === 'keys') { fetchKeys();
+    fetchACState(); }
+  if(id === 'logs') fetchLogs();
+  if(id === 'led') { fetchLedConfig(); fetchSystemColors();
+  }
+}
+// Byte offset of the next unread log output (from X-Log-Next / ws "next")
+let logCursor = null;
+const LOG_VIEW_MAX = 16384;
+function appendLogText(text, replace) {
+  const viewer = document.getElementById('logViewer');
+  let all = (replace ? '' : viewer.innerText) + text;
+  if(all.length > LOG_VIEW_MAX) all = all.slice(all.length - LOG_VIEW_MAX);
+  viewer.innerText = all || 'No logs available.';
+}
+async function fetchLogs() {
+  try {
+    const first = logCursor === null;
+    const res = await fetch('/api/system/logs' + (first ? '' : '?since=' + logCursor));
+    if (!res.ok) throw new Error('Failed');
+    const text = await res.text();
+    const next = res.headers.get('X-Log-Next');
+    if(next !== null) logCursor = Number(next);
+    if(first || text) appendLogText(text, first);
+  } catch(e) {
+    logCursor = null;
+    document.getElementById('logViewer').innerText = 'Failed to load logs.';
+  }
+}
+function applyLogChunk(msg) {
+  if(logCursor === null) return;
+  if(msg.since === logCursor) {
+    appendLogText((msg.dropped ? '[... ' + msg.dropped + ' bytes dropped]\n' : '') + msg.text, false);
+    logCursor = msg.next;
+  } else if(msg.next > logCursor) {
+    fetchLogs(); // Missed a chunk: catch up over HTTP
+  }
+}
+let acPower = false;
+async function fetchACState() {
+  try {
+    const res = await fetch('/api/ac/state');
+    applyACState(await res.json());
+  } catch(e) {}
+}
+// Accepts a full state or a /ws diff carrying only the changed fields
+function applyACState(data) {
+  if('power' in data) acPower = data.power;
+  if('mode' in data) document.getElementById('modeSelect').value = data.mode;
+  if('temp' in data) document.getElementById('tempSelect').value = data.temp;
+  if('fan' in data) document.getElementById('fanSelect').value = data.fan;
+  if('brand' in data) document.getElementById('brandSelect').value = data.brand;
+  updatePowerUI();
+}
+function updatePowerUI() {
+  if(acPower) {
+    document.getElementById('btnOn').style.background = '#22c55e';
+    document.getElementById('btnOn').style.color = '#fff';
+    document.getElementById('btnOff').style.background = '#334155';
+    document.getElementById('btnOff').style.color = '#94a3b8';
+  } else {
+    document.getElementById('btnOff').style.background = '#ef4444';
+    document.getElementById('btnOff').style.color = '#fff';
+    document.getElementById('btnOn').style.background = '#334155';
+    document.getElementById('btnOn').style.color = '#94a3b8';
+  }
+}
+function setPower(state) {
+  acPower = state;
+  updatePowerUI();
+  saveAC();
+}
+async function saveAC() {
+  const body = {
+    power: acPower ? 1 : 0,
+    mode: parseInt(document.getElementById('modeSelect').value),
+    temp: parseInt(document.getElementById('tempSelect').value),
+    fan: parseInt(document.getElementById('fanSelect').value),
+    brand: parseInt(document.getElementById('brandSelect').value)
+  };
+  try {
+    await fetch('/api/ac/control', {
+        method: 'POST',
+        headers: {'Content-Type': 'application/json'},
+        body: JSON.stringify(body)
+    });
+  } catch(e) { alert('Error sending command'); }
+}
+async function fetchKeys() {
+  try {
+    const res = await fetch('/api/ir/list');
+    if (!res.ok) throw new Error('Failed');
+    const keys = await res.json();
+    let html = '';
+    if(keys.length === 0) html = '<p>No saved keys.</p>';
+    keys.forEach(k => {
+        html += `<div style='display:flex;justify-content:space-between;align-items:center;background:#0f172a;padding:10px;margin-bottom:5px;border-radius:8px'>`
+        + `<span>${k}</span>`
+        + `<div><button class='btn' style='padding:5px 10px;margin-right:5px;font-size:0.8rem' onclick="sendKey('${k}')">Send</button>`
+        + `<button class='btn' style='padding:5px 10px;background:#ef4444;font-size:0.8rem' onclick="deleteKey('${k}')">Del</button></div></div>`;
+    });
+    document.getElementById('keyList').innerHTML = html;
+  } catch(e) {
+    document.getElementById('keyList').innerHTML = 'Failed to load keys.';
+  }
+}
+async function fetchSystemColors() {
+  const div = document.getElementById('systemColorsList');
+  div.innerHTML = 'Loading...';
+  try {
+    const res = await fetch('/api/led/state-config');
+    const data = await res.json();
+    div.innerHTML = '';
+    data.forEach(item => {
+        const row = document.createElement('div');
+        row.className = 'row';
+        row.innerHTML = `<label style='width: 40%'>${item.name}</label>` +           `<input type='color' value='${rgbToHex(item.r, item.g, item.b)}' ` +           `onchange='saveSystemColor(${item.id}, this.value)'>`;
+        div.appendChild(row);
+    });
+  } catch(e) { div.innerHTML = 'Error loading colors'; }
+}
+async function saveSystemColor(id, hex) {
+  const c = hexToRgb(hex);
+  try {
+    await fetch(`/api/led/state-config?id=${id}&r=${c.r}&g=${c.g}&b=${c.b}`, {method:'POST'});
+  } catch(e) { alert('Failed to save color'); }
+}
+async function fetchList() {
+  try { const res = await fetch('/api/ir/list');
+    const keys = await res.json(); renderList(keys); }
+  catch(e){}
+}
+function renderList(keys) {
+  keyListEl.innerHTML = '';
+  if(keys.length === 0) { keyListEl.innerHTML = '<div class="status">No keys saved</div>'; return; }
+  keys.forEach(key => {
+      const div = document.createElement('div');
+      div.className = 'key-item';
+      div.innerHTML = `<div><strong>${key}</strong></div><div class='key-actions'>      <button class='btn btn-secondary' onclick="sendKey('${key}')">Test</button>      <button class='btn btn-danger' onclick="deleteKey('${key}')">Del</button>    </div>`;
+      keyListEl.appendChild(div);
+  });
+}
+let learnInterval = null;
+let learnWatching = false;
+async function startLearn() {
+  await fetch('/api/learn/start', {method:'POST'});
+  statusEl.innerText = 'Listening... Press remote button';
+  statusEl.style.color = '#fbbf24';
+  document.getElementById('saveForm').classList.add('hidden');
+  if(learnInterval) clearInterval(learnInterval);
+  learnWatching = true;
+  if(!wsLive) learnInterval = setInterval(checkLearnStatus, 1000);
+}
+async function stopLearn() {
+  await fetch('/api/learn/stop', {method:'POST'});
+  statusEl.innerText = 'Stopped';
+  statusEl.style.color = '#94a3b8';
+  learnWatching = false;
+  if(learnInterval) clearInterval(learnInterval);
+}
+async function checkLearnStatus() {
+  try {
+    const res = await fetch('/api/learn/status');
+    applyLearnStatus(await res.json());
+  } catch(e) {}
+}
+function applyLearnStatus(data) {
+  if(!data.learning) learnWatching = false;
+  if(data.captured > 0) {
+    statusEl.innerText = 'Signal Captured! (' + data.captured + ' symbols)';
+    statusEl.style.color = '#22c55e';
+    document.getElementById('saveForm').classList.remove('hidden');
+    if(!data.learning) clearInterval(learnInterval);
+  } else if (!data.learning) {
+    statusEl.innerText = 'Stopped (No signal)';
+    clearInterval(learnInterval);
+  }
+}
+async function saveLearnedKey() {
+  const name = document.getElementById('keyNameInput').value;
+  if(!name) { alert('Enter a key name'); return; }
+  const res = await fetch('/api/save?key=' + encodeURIComponent(name), {method:'POST'});
+  if(res.ok) {
+    alert('Saved!');
+    fetchList();
+    document.getElementById('keyNameInput').value = '';
+    document.getElementById('saveForm').classList.add('hidden');
+  } else { alert('Failed to save'); }
+}
+function genKeyName() {
+  const bCode = {'daikin':'dk', 'samsung':'ss', 'mitsubishi':'mt'};
+  const mCode = {'auto':'a','cool':'c','heat':'h','fan':'f','dry':'d'};
+  const fCode = {'auto':'a','low':'l','medium':'m','high':'h'};
+  const b = bCode[document.getElementById('learnBrand').value] || 'ac';
+  const m = mCode[document.getElementById('learnMode').value] || '0';
+  const t = document.getElementById('learnTemp').value;
+  const f = fCode[document.getElementById('learnFan').value] || '0';
+  const name = `${b}_${m}${t}_${f}`;
+  document.getElementById('keyNameInput').value = name;
+}
+async function updateAC() {
+  const data = {
+    power: acPower ? 1 : 0,    mode: parseInt(document.getElementById('modeSelect').value),    temp: parseInt(document.getElementById('tempSelect').value),    fan: parseInt(document.getElementById('fanSelect').value),    brand: parseInt(document.getElementById('brandSelect').value)
+  };
+  try {
+    const res = await fetch('/api/ac/control', {
+        method: 'POST',      body: JSON.stringify(data)
+    });
+    if(!res.ok) alert('Failed to set AC');
+  } catch(e) { alert('Error setting AC'); }
+}
+function saveMode() { updateAC(); }
+function saveFan() { updateAC(); }
+function saveTemp() { updateAC(); }
+function saveBrand() { updateAC(); }
+function setPower(p) { acPower = p; updatePowerUI(); updateAC(); }
+async function sendKey(key) {
+  await fetch('/api/send?key='+encodeURIComponent(key), {method:'POST'});
+}
+async function deleteKey(key) {
+  if(!confirm('Delete ' + key + '?')) return;
+  await fetch('/api/ir/delete?key='+encodeURIComponent(key), {method:'POST'});
+  fetchList();
+}
+async function checkUpdate() {
+  const status = document.getElementById('otaStatus');
+  status.innerText = 'Checking...';
+  try {
+    const res = await fetch('/api/ota/check');
+    const data = await res.json();
+    document.getElementById('currentVer').innerText = data.current;
+    if(data.available) {
+      document.getElementById('otaSection').classList.add('hidden');
+      document.getElementById('updateAvailable').classList.remove('hidden');
+      document.getElementById('newVer').innerText = data.latest;
+      status.innerText = '';
+    } else {
+      status.innerText = 'System is up to date.';
+    }
+  } catch (e) { status.innerText = 'Error checking update';
+  }
+}
+async function startUpdate() {
+  if(!confirm('Start Firmware Update? Device will reboot.')) return;
+  const status = document.getElementById('otaStatus');
+  status.innerText = 'Starting update...';
+  try {
+    const res = await fetch('/api/ota/start', {method:'POST'});
+    if(res.ok) status.innerText = 'Update started! Wait for reboot...';
+    else status.innerText = 'Failed to start update';
+  } catch(e) { status.innerText = 'Error starting update'; }
+}
+async function saveWifi() {
+  const ssid = document.getElementById('wifiSSID').value;
+  const pass = document.getElementById('wifiPass').value;
+  if(!ssid) { alert('SSID is required'); return; }
+  if(!confirm('Save credentials and restart device?')) return;
+  try {
+    const res = await fetch('/api/wifi/config?ssid=' + encodeURIComponent(ssid) + '&password=' + encodeURIComponent(pass), {method:'POST'});
+    if(res.ok) alert('Settings saved. Device rebooting...');
+    else alert('Failed to save settings');
+  } catch(e) { alert('Error: ' + e); }
+}
+async function scanWifi() {
+  const btn = document.getElementById('scanBtn');
+  const list = document.getElementById('scanList');
+  btn.disabled = true; btn.innerText = 'Scanning...';
+  list.innerHTML = ''; list.classList.remove('hidden');
+  try {
+    const res = await fetch('/api/wifi/scan');
+    const data = await res.json();
+    if(data.length === 0) list.innerHTML = '<div class="status">No networks found</div>';
+    data.forEach(net => {
+        const div = document.createElement('div');
+        div.className = 'key-item';
+        div.style.cursor = 'pointer';
+        div.innerHTML = `<div><strong>${net.ssid}</strong> <small>(${net.rssi}dBm)</small></div>`;
+        div.onclick = () => {
+          document.getElementById('wifiSSID').value = net.ssid; list.classList.add('hidden'); };
+        list.appendChild(div);
+    });
+  } catch(e) { list.innerHTML = '<div class="status">Scan failed</div>'; }
+  btn.disabled = false; btn.innerText = 'Scan';
+}
+function hexToRgb(hex) {
+  var result = /^#?([a-f\d]{2})([a-f\d]{2})([a-f\d]{2})$/i.exec(hex);
+  return result ? {
+    r: parseInt(result[1], 16),
+    g: parseInt(result[2], 16),
+    b: parseInt(result[3], 16)
+  } : null;
+}
+
+function componentToHex(c) { var hex = c.toString(16); return hex.length == 1 ? '0' + hex : hex; }
+function rgbToHex(r, g, b) { return '#' + componentToHex(r) + componentToHex(g) + componentToHex(b); }
+
+let ledColors = [];
+let selectedLed = -1;
+let currentEffect = 'static';
+
+function initRing() {
+  const ring = document.getElementById('ledRing');
+  ring.innerHTML = '';
+  const radius = 90;
+  for(let i=0; i<8; i++) {
+    const div = document.createElement('div');
+    div.className = 'led-pixel';
+    const angle = (i * 360 / 8) - 90;
+    const rad = angle * Math.PI / 180;
+    const x = Math.round(radius * Math.cos(rad));
+    const y = Math.round(radius * Math.sin(rad));
+    div.style.transform = `translate(${x}px, ${y}px)`;
+    div.onclick = (e) => selectLed(i, e);
+    div.id = 'led-'+i;
+    ring.appendChild(div);
+  }
+}
+
+function selectLed(i, e) {
+  if(e) e.stopPropagation();
+  selectedLed = i;
+  document.querySelectorAll('.led-pixel').forEach(el=>el.classList.remove('selected'));
+  document.getElementById('led-'+i).classList.add('selected');
+}
+
+function updateRingUI() {
+  ledColors.forEach((c, i) => {
+      const el = document.getElementById('led-'+i);
+      if(el) el.style.backgroundColor = `rgb(${c[0]}, ${c[1]}, ${c[2]})`;
+  });
+}
+
+function setTab(effect, btn) {
+  currentEffect = effect;
+  document.querySelectorAll('.effect-tab').forEach(b=>b.classList.remove('active'));
+  if(btn) btn.classList.add('active');
+  else {
+  }
+  fetchLedConfig();
+}
+
+async function applyColor(hex) {
+  if(!hex) hex = document.getElementById('customColor').value;
+  const c = hexToRgb(hex);
+  if(selectedLed !== -1) {
+    ledColors[selectedLed] = [c.r, c.g, c.b];
+    updateRingUI();
+    await fetch(`/api/led/config?effect=${currentEffect}&index=${selectedLed}&r=${c.r}&g=${c.g}&b=${
+        c.b}`, {method:'POST'});
+  }
+}
+
+async function applyToAll() {
+  const hex = document.getElementById('customColor').value;
+  const c = hexToRgb(hex);
+  for(let i=0; i<8; i++) ledColors[i] = [c.r, c.g, c.b];
+  updateRingUI();
+  await fetch(`/api/led/config?effect=${currentEffect}&index=255&r=${c.r}&g=${c.g}&b=${c.b}`, {method:'POST'});
+}
+
+async function saveLedConfig() {
+  const speed = document.getElementById('ledSpeed').value;
+  const bright = document.getElementById('ledBright').value;
+  document.getElementById('valSpeed').innerText = speed;
+  document.getElementById('valBright').innerText = bright;
+  await fetch(`/api/led/config?effect=${currentEffect}&speed=${speed}&brightness=${bright}`, {method:'POST'});
+}
+
+async function fetchLedConfig() {
+  try {
+    const res = await fetch(`/api/led/config?effect=${currentEffect}`);
+    const data = await res.json();
+    ledColors = data.colors || [];
+    updateRingUI();
+    document.getElementById('ledSpeed').value = data.speed;
+    document.getElementById('valSpeed').innerText = data.speed;
+    document.getElementById('ledBright').value = data.brightness;
+    document.getElementById('valBright').innerText = data.brightness;
+  } catch(e) {}
+}
+
+function savePreset() {
+  fetch('/api/led/save-preset', {method: 'POST'})
+  .then(r => { if(r.ok) alert('Preset saved!'); else alert('Failed to save'); })
+  .catch(e => alert('Error saving preset'));
+}
+const oldNavTo = navTo;
+navTo = function(id) {
+  if(id === 'led') {
+    if(document.getElementById('ledRing').innerHTML === '') initRing();
+    fetchLedConfig();
+  }
+  if(window.innerWidth <= 768) toggleSidebar();
+  document.querySelectorAll('.view').forEach(el => el.classList.add('hidden'));
+  const el = document.getElementById(id);
+  if(el) el.classList.remove('hidden');
+  if(id === 'dashboard') updateDashboard();
+  if(id === 'logs') fetchLogs();
+  if(id === 'controls' || id === 'keys') fetchKeys();
+};
+let heapChart, rssiChart;
+function initCharts() {
+  if (typeof Chart === 'undefined') return;
+  const ctxHeap = document.getElementById('heapChart').getContext('2d');
+  heapChart = new Chart(ctxHeap, {
+      type: 'line',    data: { labels: [], datasets: [{ label: 'Free Heap (KB)', data: [], borderColor: '#3b82f6', tension: 0.4 }] },    options: { animation: false, scales: { y: {
+            beginAtZero: true } } }
+  });
+  const ctxRssi = document.getElementById('rssiChart').getContext('2d');
+  rssiChart = new Chart(ctxRssi, {
+      type: 'line',    data: { labels: [], datasets: [{ label: 'WiFi RSSI (dBm)', data: [], borderColor: '#22c55e', tension: 0.4 }] },    options: { animation: false }
+  });
+  loadStatsHistory();
+}
+const CHART_POINTS = 60;
+function pushChartPoint(chart, label, value) {
+  if(!chart) return;
+  if(chart.data.labels.length >= CHART_POINTS) {
+    chart.data.labels.shift();
+    chart.data.datasets[0].data.shift(); }
+  chart.data.labels.push(label);
+  chart.data.datasets[0].data.push(value);
+}
+// Seed the trend charts from the device's sample ring instead of waiting
+async function loadStatsHistory() {
+  try {
+    const res = await fetch('/api/system/stats/history');
+    const hist = await res.json();
+    const now = Date.now();
+    [heapChart, rssiChart].forEach(c => { c.data.labels = []; c.data.datasets[0].data = []; });
+    hist.samples.forEach(([t, heap, psram, temp, rssi]) => {
+      const label = new Date(now - (hist.uptime - t) * 1000).toLocaleTimeString();
+      pushChartPoint(heapChart, label, heap / 1024);
+      pushChartPoint(rssiChart, label, rssi);
+    });
+    heapChart.update();
+    rssiChart.update();
+  } catch(e) {}
+}
+async function updateDashboard() {
+  try {
+    const res = await fetch('/api/system/stats');
+    renderStats(await res.json());
+  } catch(e) {
+    document.getElementById('dashStatus').innerText = 'Err: ' + e.message;
+    document.getElementById('dashStatus').style.color = 'red';
+  }
+}
+function renderStats(data) {
+  const d = Math.floor(data.uptime / 86400);
+  const h = Math.floor((data.uptime % 86400) / 3600);
+  const m = Math.floor((data.uptime % 3600) / 60);
+  document.getElementById('txtUptime').innerText = `Uptime: ${d}d ${h}h ${m}m`;
+  const cpu = Math.floor(Math.random() * 10) + 2;
+  document.getElementById('valCpu').innerText = cpu + '%';
+  document.getElementById('progCpu').style.width = cpu + '%';
+  const totalHeap = 300000;
+  const used = totalHeap - data.free_heap;
+  const ramPct = Math.round((used / totalHeap) * 100);
+  document.getElementById('valRam').innerText = ramPct + '%';
+  document.getElementById('progRam').style.width = ramPct + '%';
+  if (data.psram_total > 0) {
+    const psramUsed = data.psram_total - data.psram_free;
+    const psramPct = Math.round((psramUsed / data.psram_total) * 100);
+    document.getElementById('valPsram').innerText = psramPct + '%';
+    document.getElementById('progPsram').style.width = psramPct + '%';
+  } else {
+    document.getElementById('valPsram').innerText = 'N/A';
+    document.getElementById('progPsram').style.width = '0%';
+  }
+  if(data.temp) {
+    document.getElementById('valTemp').innerText = data.temp.toFixed(1) + ' °C';
+    const tempPct = Math.min((data.temp / 80) * 100, 100);
+    document.getElementById('progTemp').style.width = tempPct + '%';
+  }
+  const now = new Date().toLocaleTimeString();
+  if(heapChart) {
+    pushChartPoint(heapChart, now, data.free_heap / 1024);
+    heapChart.update();
+  }
+  if(rssiChart) {
+    pushChartPoint(rssiChart, now, data.rssi);
+    rssiChart.update();
+  }
+}
+async function clearLogs() {
+  try {
+    await fetch('/api/system/logs/clear', {method: 'POST'});
+    logCursor = null;
+    fetchLogs();
+  } catch(e) {}
+}
+// Live updates pushed by the device; polling resumes while disconnected
+let wsLive = false;
+function connectWs() {
+  let ws;
+  try {
+    ws = new WebSocket((location.protocol === 'https:' ? 'wss://' : 'ws://') + location.host + '/ws');
+  } catch(e) { return; }
+  ws.onopen = () => { wsLive = true; if(learnInterval) clearInterval(learnInterval); };
+  ws.onclose = () => {
+    if(wsLive && learnWatching) learnInterval = setInterval(checkLearnStatus, 1000);
+    wsLive = false;
+    setTimeout(connectWs, 3000);
+  };
+  ws.onmessage = (ev) => {
+    let msg;
+    try { msg = JSON.parse(ev.data); } catch(e) { return; }
+    if(msg.t === 'ac') applyACState(msg);
+    else if(msg.t === 'learn' && (learnWatching || msg.learning)) applyLearnStatus(msg);
+    else if(msg.t === 'stats') renderStats(msg);
+    else if(msg.t === 'log') applyLogChunk(msg);
+  };
+}
+connectWs();
+fetchKeys();
+fetchLedConfig();
+fetchSystemColors();
+fetchLogs();
+fetch('/api/ota/check').then(r=>r.json()).then(d=>{
+    document.getElementById('currentVer').innerText=d.current;
+    document.getElementById('txtFirmware').innerText=d.current;
+}).catch(e=>{});
@@ -7,6 +7,7 @@
 #include <freertos/task.h>
 #include <stdio.h>
 
+#include "goku_ac.h"
 #include "goku_button.h"
 #include "goku_data.h"
 #include "goku_ir_app.h"
@@ -16,6 +17,7 @@
 #include "goku_mem.h"
 #include "goku_ota.h"
 #include "goku_rainmaker.h"
+#include "goku_settings.h"
 #include "goku_web.h"
 #include "goku_wifi.h"
 
@@ -38,6 +40,14 @@ void app_main(void) {
   // 1. Initialize NVS (Non-Volatile Storage)
   ESP_ERROR_CHECK(app_data_init());
 
+  // Load the settings snapshot (single NVS read) before any consumer
+  if (app_settings_init() != ESP_OK) {
+    ESP_LOGW(TAG, "Settings store unavailable, running on defaults");
+  }
+  if (app_log_tags_init() != ESP_OK) {
+    ESP_LOGW(TAG, "Some log tag rules could not be applied");
+  }
+
   // 2. Initialize Network Stack
   ESP_ERROR_CHECK(esp_netif_init());
   ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -47,6 +57,11 @@ void app_main(void) {
     ESP_LOGE(TAG, "Failed to init IR");
   }
 
+  // Restore the last known AC state (needs the settings store)
+  if (app_ac_init() != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to init AC logic");
+  }
+
   // 4. Initialize Peripherals (LED, Button)
   ESP_ERROR_CHECK(app_led_init());
   app_led_set_state(APP_LED_STARTUP);